@@ -21,6 +21,7 @@
 #define RIPPLE_KEYCACHE_H_INCLUDED
 
 #include <mutex>
+#include <vector>
 
 #include <beast/chrono/abstract_clock.h>
 #include <beast/chrono/chrono_io.h>
@@ -157,6 +158,17 @@ public:
         m_map.clear ();
     }
 
+    /** Returns a copy of the keys in the cache. */
+    std::vector <key_type> getKeys () const
+    {
+        std::vector <key_type> keys;
+        lock_guard lock (m_mutex);
+        keys.reserve (m_map.size ());
+        for (auto const& entry : m_map)
+            keys.push_back (entry.first);
+        return keys;
+    }
+
     void setTargetSize (size_type s)
     {
         lock_guard lock (m_mutex);
@@ -0,0 +1,251 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+#ifndef RIPPLE_SHARDEDTAGGEDCACHE_H_INCLUDED
+#define RIPPLE_SHARDEDTAGGEDCACHE_H_INCLUDED
+
+#include <ripple/common/TaggedCache.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace ripple {
+
+/** A TaggedCache split into independently locked partitions.
+
+    Each key is assigned to one of `Partitions` TaggedCache instances by
+    its hash, so threads working on different keys rarely contend for the
+    same mutex. The target size is divided evenly among the partitions,
+    and each partition is swept on its own.
+
+    The interface is the same as TaggedCache, except that there is no
+    single mutex covering the whole container, so `peekMutex` is not
+    provided. Caches whose callers need to lock the whole container must
+    use TaggedCache instead.
+*/
+template <
+    class Key,
+    class T,
+    std::size_t Partitions = 16,
+    class Hash = beast::hardened_hash <>,
+    class KeyEqual = std::equal_to <Key>,
+    class Mutex = std::recursive_mutex
+>
+class ShardedTaggedCache
+{
+private:
+    typedef TaggedCache <Key, T, Hash, KeyEqual, Mutex> partition_type;
+
+public:
+    typedef typename partition_type::key_type key_type;
+    typedef typename partition_type::mapped_type mapped_type;
+    typedef typename partition_type::weak_mapped_ptr weak_mapped_ptr;
+    typedef typename partition_type::mapped_ptr mapped_ptr;
+    typedef beast::abstract_clock <std::chrono::seconds> clock_type;
+
+    static_assert (Partitions > 0, "A cache needs at least one partition");
+
+public:
+    ShardedTaggedCache (std::string const& name, int size,
+        clock_type::rep expiration_seconds, clock_type& clock, beast::Journal journal,
+            beast::insight::Collector::ptr const& collector = beast::insight::NullCollector::New ())
+        : m_clock (clock)
+        , m_stats (name,
+            std::bind (&ShardedTaggedCache::collect_metrics, this),
+                collector)
+        , m_target_size (size)
+    {
+        m_partitions.reserve (Partitions);
+
+        for (std::size_t i = 0; i < Partitions; ++i)
+            m_partitions.emplace_back (new partition_type (name,
+                partitionSize (size), expiration_seconds, clock, journal));
+    }
+
+public:
+    /** Return the clock associated with the cache. */
+    clock_type& clock ()
+    {
+        return m_clock;
+    }
+
+    int getTargetSize () const
+    {
+        return m_target_size;
+    }
+
+    void setTargetSize (int s)
+    {
+        m_target_size = s;
+
+        for (auto& p : m_partitions)
+            p->setTargetSize (partitionSize (s));
+    }
+
+    clock_type::rep getTargetAge () const
+    {
+        return m_partitions.front ()->getTargetAge ();
+    }
+
+    void setTargetAge (clock_type::rep s)
+    {
+        for (auto& p : m_partitions)
+            p->setTargetAge (s);
+    }
+
+    int getCacheSize ()
+    {
+        int size = 0;
+        for (auto& p : m_partitions)
+            size += p->getCacheSize ();
+        return size;
+    }
+
+    int getTrackSize ()
+    {
+        int size = 0;
+        for (auto& p : m_partitions)
+            size += p->getTrackSize ();
+        return size;
+    }
+
+    float getHitRate ()
+    {
+        // Keys are spread evenly, so the partitions see similar traffic
+        float rate = 0;
+        for (auto& p : m_partitions)
+            rate += p->getHitRate ();
+        return rate / Partitions;
+    }
+
+    void clearStats ()
+    {
+        for (auto& p : m_partitions)
+            p->clearStats ();
+    }
+
+    void clear ()
+    {
+        for (auto& p : m_partitions)
+            p->clear ();
+    }
+
+    /** Sweep each partition in turn.
+        Only one partition is locked at a time.
+    */
+    void sweep ()
+    {
+        for (auto& p : m_partitions)
+            p->sweep ();
+    }
+
+    bool del (key_type const& key, bool valid)
+    {
+        return partition (key).del (key, valid);
+    }
+
+    /** Replace aliased objects with originals.
+        @see TaggedCache::canonicalize
+    */
+    bool canonicalize (key_type const& key, std::shared_ptr<T>& data, bool replace = false)
+    {
+        return partition (key).canonicalize (key, data, replace);
+    }
+
+    std::shared_ptr<T> fetch (key_type const& key)
+    {
+        return partition (key).fetch (key);
+    }
+
+    /** Insert the element into the container.
+        If the key already exists, nothing happens.
+        @return `true` If the element was inserted
+    */
+    bool insert (key_type const& key, T const& value)
+    {
+        return partition (key).insert (key, value);
+    }
+
+    bool retrieve (key_type const& key, T& data)
+    {
+        return partition (key).retrieve (key, data);
+    }
+
+    /** Refresh the expiration time on a key.
+
+        @param key The key to refresh.
+        @return `true` if the key was found and the object is cached.
+    */
+    bool refreshIfPresent (key_type const& key)
+    {
+        return partition (key).refreshIfPresent (key);
+    }
+
+private:
+    static int partitionSize (int size)
+    {
+        // Zero means no target, keep it that way
+        if (size <= 0)
+            return size;
+
+        return std::max (1, static_cast <int> (
+            (size + Partitions - 1) / Partitions));
+    }
+
+    partition_type& partition (key_type const& key)
+    {
+        return *m_partitions [m_hash (key) % Partitions];
+    }
+
+    void collect_metrics ()
+    {
+        m_stats.size.set (getCacheSize ());
+        m_stats.hit_rate.set (static_cast <
+            beast::insight::Gauge::value_type> (getHitRate ()));
+    }
+
+private:
+    struct Stats
+    {
+        template <class Handler>
+        Stats (std::string const& prefix, Handler const& handler,
+            beast::insight::Collector::ptr const& collector)
+            : hook (collector->make_hook (handler))
+            , size (collector->make_gauge (prefix, "size"))
+            , hit_rate (collector->make_gauge (prefix, "hit_rate"))
+            { }
+
+        beast::insight::Hook hook;
+        beast::insight::Gauge size;
+        beast::insight::Gauge hit_rate;
+    };
+
+    clock_type& m_clock;
+    Stats m_stats;
+    Hash m_hash;
+
+    // Desired number of cache entries across all partitions (0 = ignore)
+    std::atomic <int> m_target_size;
+
+    std::vector <std::unique_ptr <partition_type>> m_partitions;
+};
+
+}
+
+#endif
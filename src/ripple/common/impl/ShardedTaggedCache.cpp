@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+#include <ripple/common/ShardedTaggedCache.h>
+
+#include <beast/unit_test/suite.h>
+#include <beast/chrono/manual_clock.h>
+
+namespace ripple {
+
+class ShardedTaggedCache_test : public beast::unit_test::suite
+{
+public:
+    void run ()
+    {
+        beast::Journal const j;
+
+        beast::manual_clock <std::chrono::seconds> clock;
+        clock.set (0);
+
+        typedef int Key;
+        typedef std::string Value;
+        typedef ShardedTaggedCache <Key, Value, 4> Cache;
+
+        Cache c ("test", 16, 1, clock, j);
+
+        // Insert items spread over the partitions and retrieve them
+        {
+            for (int i = 0; i < 16; ++i)
+                expect (! c.insert (i, std::to_string (i)));
+            expect (c.getCacheSize() == 16);
+            expect (c.getTrackSize() == 16);
+
+            for (int i = 0; i < 16; ++i)
+            {
+                std::string s;
+                expect (c.retrieve (i, s));
+                expect (s == std::to_string (i));
+            }
+        }
+
+        // Age them so every partition purges them, except for the one
+        // we hold a strong pointer to
+        {
+            Cache::mapped_ptr p (c.fetch (7));
+            expect (p != nullptr);
+
+            ++clock;
+            c.sweep ();
+            expect (c.getCacheSize() == 0);
+            expect (c.getTrackSize() == 1);
+
+            // Canonicalize a new object with the same key and make
+            // sure we get the original object
+            Cache::mapped_ptr p2 (std::make_shared <Value> ("7"));
+            expect (c.canonicalize (7, p2));
+            expect (p.get() == p2.get());
+            expect (c.getCacheSize() == 1);
+        }
+
+        ++clock;
+        c.sweep ();
+        expect (c.getCacheSize() == 0);
+        expect (c.getTrackSize() == 0);
+
+        // Removal only affects the key's own partition
+        {
+            expect (! c.insert (1, "one"));
+            expect (! c.insert (2, "two"));
+            expect (c.del (1, false));
+            expect (c.fetch (1) == nullptr);
+            expect (c.fetch (2) != nullptr);
+            expect (c.getTrackSize() == 1);
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ShardedTaggedCache,common,ripple);
+
+}
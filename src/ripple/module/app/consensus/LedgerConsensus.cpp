@@ -1010,21 +1010,15 @@ private:
                 = newLCL->peekTransactionMap ()->disarmDirty ();
 
             // write out dirty nodes (temporarily done here)
-            int fc;
-
-            while ((fc = newLCL->peekAccountStateMap()->flushDirty (
-                *acctNodes, 256, hotACCOUNT_NODE, newLCL->getLedgerSeq ())) > 0)
-            {
-                WriteLog (lsTRACE, LedgerConsensus)
-                    << "Flushed " << fc << " dirty state nodes";
-            }
+            int fc = newLCL->peekAccountStateMap()->flushDirtyBatch (
+                *acctNodes, hotACCOUNT_NODE, newLCL->getLedgerSeq ());
+            WriteLog (lsTRACE, LedgerConsensus)
+                << "Flushed " << fc << " dirty state nodes";
 
-            while ((fc = newLCL->peekTransactionMap()->flushDirty (
-                *txnNodes, 256, hotTRANSACTION_NODE, newLCL->getLedgerSeq ())) > 0)
-            {
-                WriteLog (lsTRACE, LedgerConsensus)
-                    << "Flushed " << fc << " dirty transaction nodes";
-            }
+            fc = newLCL->peekTransactionMap()->flushDirtyBatch (
+                *txnNodes, hotTRANSACTION_NODE, newLCL->getLedgerSeq ());
+            WriteLog (lsTRACE, LedgerConsensus)
+                << "Flushed " << fc << " dirty transaction nodes";
 
             // Accept ledger
             newLCL->setAccepted (closeTime, mCloseResolution, closeTimeCorrect);
@@ -47,7 +47,7 @@ const char* TxnDBInit[] =
 
     "CREATE TABLE AccountTransactions (         \
         TransID     CHARACTER(64),              \
-        Account     CHARACTER(64),              \
+        Account     BLOB,                       \
         LedgerSeq   BIGINT UNSIGNED,            \
         TxnSeq      INTEGER                     \
     );",
@@ -107,6 +107,7 @@ sqlite3* SqliteDatabase::getAuxConnection ()
 
 void SqliteDatabase::disconnect ()
 {
+    mStatements.clear ();
     sqlite3_finalize (mCurrentStmt);
     sqlite3_close (mConnection);
 
@@ -114,6 +115,18 @@ void SqliteDatabase::disconnect ()
         sqlite3_close (mAuxConnection);
 }
 
+SqliteStatement& SqliteDatabase::getStatement (std::string const& sql)
+{
+    auto& statement = mStatements[sql];
+
+    if (statement)
+        statement->reset ();
+    else
+        statement = std::make_unique <SqliteStatement> (this, sql);
+
+    return *statement;
+}
+
 // returns true if the query went ok
 bool SqliteDatabase::executeSQL (const char* sql, bool fail_ok)
 {
@@ -24,6 +24,8 @@
 
 namespace ripple {
 
+class SqliteStatement;
+
 class SqliteDatabase
     : public Database
     , private beast::Thread
@@ -73,6 +75,14 @@ public:
 
     void doHook (const char* db, int walSize);
 
+    /** Get a prepared statement for a query.
+        The statement is compiled the first time a query is seen and kept
+        until the database disconnects. It is returned reset, and the
+        caller must bind every parameter, and must hold the database lock
+        for as long as it uses the statement.
+    */
+    SqliteStatement& getStatement (std::string const& sql);
+
     int getKBUsedDB ();
     int getKBUsedAll ();
 
@@ -90,6 +100,8 @@ private:
     sqlite3_stmt* mCurrentStmt;
     bool mMoreRows;
 
+    hash_map <std::string, std::unique_ptr <SqliteStatement>> mStatements;
+
     JobQueue*               mWalQ;
     bool                    walRunning;
 };
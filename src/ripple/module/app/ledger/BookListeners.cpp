@@ -31,26 +31,31 @@ void BookListeners::removeSubscriber (std::uint64_t seq)
     mListeners.erase (seq);
 }
 
-void BookListeners::publish (Json::Value const& jvObj)
+void BookListeners::publish (Json::Value const& jvObj, std::string const& sObj)
 {
-    Json::FastWriter jfwWriter;
-    std::string sObj = jfwWriter.write (jvObj);
+    std::vector <InfoSub::pointer> subs;
 
-    ScopedLockType sl (mLock);
-    NetworkOPs::SubMapType::const_iterator it = mListeners.begin ();
-
-    while (it != mListeners.end ())
     {
-        InfoSub::pointer p = it->second.lock ();
+        ScopedLockType sl (mLock);
+        NetworkOPs::SubMapType::const_iterator it = mListeners.begin ();
 
-        if (p)
+        while (it != mListeners.end ())
         {
-            p->send (jvObj, sObj, true);
-            ++it;
+            InfoSub::pointer p = it->second.lock ();
+
+            if (p)
+            {
+                subs.push_back (p);
+                ++it;
+            }
+            else
+                it = mListeners.erase (it);
         }
-        else
-            it = mListeners.erase (it);
     }
+
+    // Send without holding the lock, since a send can block
+    for (auto const& p : subs)
+        p->send (jvObj, sObj, true);
 }
 
 } // ripple
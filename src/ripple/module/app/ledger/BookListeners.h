@@ -32,7 +32,7 @@ public:
 
     void addSubscriber (InfoSub::ref sub);
     void removeSubscriber (std::uint64_t sub);
-    void publish (Json::Value const& jvObj);
+    void publish (Json::Value const& jvObj, std::string const& sObj);
 
 private:
     typedef RippleRecursiveMutex LockType;
@@ -46,6 +46,8 @@ InboundLedger::InboundLedger (uint256 const& hash, std::uint32_t seq, fcReason r
     , mByHash (true)
     , mSeq (seq)
     , mReason (reason)
+    , mTxPipeline (getConfig ().LEDGER_FETCH_REQUESTS)
+    , mStatePipeline (getConfig ().LEDGER_FETCH_REQUESTS)
     , mReceiveDispatched (false)
 {
 
@@ -220,9 +222,6 @@ bool InboundLedger::tryLocal ()
 */
 void InboundLedger::onTimer (bool wasProgress, ScopedLockType&)
 {
-    mRecentTXNodes.clear ();
-    mRecentASNodes.clear ();
-
     if (isDone())
     {
         if (m_journal.info) m_journal.info <<
@@ -254,6 +253,10 @@ void InboundLedger::onTimer (bool wasProgress, ScopedLockType&)
         mAggressive = true;
         mByHash = true;
 
+        // Nothing came back, so ask for everything again
+        mTxPipeline.reset ();
+        mStatePipeline.reset ();
+
         std::size_t pc = getPeerCount ();
         WriteLog (lsDEBUG, InboundLedger) <<
             "No progress(" << pc <<
@@ -263,6 +266,12 @@ void InboundLedger::onTimer (bool wasProgress, ScopedLockType&)
         if (pc < 4)
             addPeers ();
     }
+    else if ((mTxPipeline.getOutstanding () != 0) ||
+        (mStatePipeline.getOutstanding () != 0))
+    {
+        // Hand out any nodes whose requests have gone unanswered
+        trigger (Peer::ptr ());
+    }
 }
 
 /** Add more peers to the set, if possible */
@@ -341,6 +350,54 @@ std::weak_ptr<PeerSet> InboundLedger::pmDowncast ()
     return std::dynamic_pointer_cast<PeerSet> (shared_from_this ());
 }
 
+/** Call with a lock
+*/
+std::vector <Peer::ShortId> InboundLedger::getPeerIds () const
+{
+    std::vector <Peer::ShortId> ret;
+    ret.reserve (mPeers.size ());
+
+    for (auto const& p : mPeers)
+    {
+        if (getApp ().overlay ().findPeerByShortID (p.first))
+            ret.push_back (p.first);
+    }
+
+    return ret;
+}
+
+/** Split missing nodes into requests for the peers with room for them
+    Call with a lock
+*/
+std::size_t InboundLedger::sendNodeRequests (LedgerFetchPipeline& pipeline,
+    std::vector <Peer::ShortId> const& peers,
+    std::vector <SHAMapNodeID> const& nodeIDs,
+    protocol::TMGetLedger const& message)
+{
+    auto const requests = pipeline.assign (peers, nodeIDs,
+        LedgerFetchPipeline::clock_type::now ());
+
+    for (auto const& request : requests)
+    {
+        Peer::ptr peer (getApp().overlay ().findPeerByShortID (request.peer));
+
+        if (!peer)
+            continue;
+
+        protocol::TMGetLedger tmGL (message);
+
+        for (auto const& nodeID : request.nodes)
+            *tmGL.add_nodeids () = nodeID.getRawString ();
+
+        if (m_journal.trace) m_journal.trace <<
+            "Sending " << request.nodes.size () << " node request to " << peer;
+
+        peer->send (std::make_shared<Message> (tmGL, protocol::mtGET_LEDGER));
+    }
+
+    return requests.size ();
+}
+
 /** Dispatch acquire completion
 */
 static void LADispatch (
@@ -554,15 +611,21 @@ void InboundLedger::trigger (Peer::ptr const& peer)
         {
             std::vector<SHAMapNodeID> nodeIDs;
             std::vector<uint256> nodeHashes;
-            // VFALCO Why 256? Make this a constant
-            nodeIDs.reserve (256);
-            nodeHashes.reserve (256);
+            auto const peers = getPeerIds ();
+
+            // Look for enough nodes to fill every peer's pipeline. When they
+            // are all full, still look for one to see if we're done.
+            std::size_t const wanted = std::max <std::size_t> (1,
+                mStatePipeline.getWanted (peers,
+                    LedgerFetchPipeline::clock_type::now ()));
+            nodeIDs.reserve (wanted);
+            nodeHashes.reserve (wanted);
             AccountStateSF filter (mSeq);
 
             // Release the lock while we process the large state map
             sl.unlock();
             mLedger->peekAccountStateMap ()->getMissingNodes (
-                nodeIDs, nodeHashes, 256, &filter);
+                nodeIDs, nodeHashes, wanted, &filter);
             sl.lock();
 
             // Make sure nothing happened while we released the lock
@@ -582,30 +645,14 @@ void InboundLedger::trigger (Peer::ptr const& peer)
                 }
                 else
                 {
-                    // VFALCO Why 128? Make this a constant
-                    if (!mAggressive)
-                        filterNodes (nodeIDs, nodeHashes, mRecentASNodes,
-                            128, !isProgress ());
+                    tmGL.set_itype (protocol::liAS_NODE);
 
-                    if (!nodeIDs.empty ())
-                    {
-                        tmGL.set_itype (protocol::liAS_NODE);
-                        BOOST_FOREACH (SHAMapNodeID const& it, nodeIDs)
-                        {
-                            * (tmGL.add_nodeids ()) = it.getRawString ();
-                        }
-                        if (m_journal.trace) m_journal.trace <<
-                            "Sending AS node " << nodeIDs.size () <<
-                                " request to " << (
-                                    peer ? "selected peer" : "all peers");
-                        if (nodeIDs.size () == 1 && m_journal.trace) m_journal.trace <<
-                            "AS node: " << nodeIDs[0];
-                        sendRequest (tmGL, peer);
+                    if (sendNodeRequests (mStatePipeline, peers,
+                        nodeIDs, tmGL) != 0)
                         return;
-                    }
-                    else
-                        if (m_journal.trace) m_journal.trace <<
-                            "All AS nodes filtered";
+
+                    if (m_journal.trace) m_journal.trace <<
+                        "All AS nodes requested";
                 }
             }
         }
@@ -634,11 +681,15 @@ void InboundLedger::trigger (Peer::ptr const& peer)
         {
             std::vector<SHAMapNodeID> nodeIDs;
             std::vector<uint256> nodeHashes;
-            nodeIDs.reserve (256);
-            nodeHashes.reserve (256);
+            auto const peers = getPeerIds ();
+            std::size_t const wanted = std::max <std::size_t> (1,
+                mTxPipeline.getWanted (peers,
+                    LedgerFetchPipeline::clock_type::now ()));
+            nodeIDs.reserve (wanted);
+            nodeHashes.reserve (wanted);
             TransactionStateSF filter (mSeq);
             mLedger->peekTransactionMap ()->getMissingNodes (
-                nodeIDs, nodeHashes, 256, &filter);
+                nodeIDs, nodeHashes, wanted, &filter);
 
             if (nodeIDs.empty ())
             {
@@ -654,27 +705,14 @@ void InboundLedger::trigger (Peer::ptr const& peer)
             }
             else
             {
-                if (!mAggressive)
-                    filterNodes (nodeIDs, nodeHashes, mRecentTXNodes,
-                        128, !isProgress ());
+                tmGL.set_itype (protocol::liTX_NODE);
 
-                if (!nodeIDs.empty ())
-                {
-                    tmGL.set_itype (protocol::liTX_NODE);
-                    BOOST_FOREACH (SHAMapNodeID const& it, nodeIDs)
-                    {
-                        * (tmGL.add_nodeids ()) = it.getRawString ();
-                    }
-                    if (m_journal.trace) m_journal.trace <<
-                        "Sending TX node " << nodeIDs.size () <<
-                        " request to " << (
-                            peer ? "selected peer" : "all peers");
-                    sendRequest (tmGL, peer);
+                if (sendNodeRequests (mTxPipeline, peers,
+                    nodeIDs, tmGL) != 0)
                     return;
-                }
-                else
-                    if (m_journal.trace) m_journal.trace <<
-                        "All TX nodes filtered";
+
+                if (m_journal.trace) m_journal.trace <<
+                    "All TX nodes requested";
             }
         }
     }
@@ -690,77 +728,6 @@ void InboundLedger::trigger (Peer::ptr const& peer)
     }
 }
 
-void InboundLedger::filterNodes (std::vector<SHAMapNodeID>& nodeIDs,
-    std::vector<uint256>& nodeHashes, std::set<SHAMapNodeID>& recentNodes,
-    int max, bool aggressive)
-{
-    // ask for new nodes in preference to ones we've already asked for
-    assert (nodeIDs.size () == nodeHashes.size ());
-
-    std::vector<bool> duplicates;
-    duplicates.reserve (nodeIDs.size ());
-
-    int dupCount = 0;
-
-    BOOST_FOREACH(SHAMapNodeID const& nodeID, nodeIDs)
-    {
-        if (recentNodes.count (nodeID) != 0)
-        {
-            duplicates.push_back (true);
-            ++dupCount;
-        }
-        else
-            duplicates.push_back (false);
-    }
-
-    if (dupCount == nodeIDs.size ())
-    {
-        // all duplicates
-        if (!aggressive)
-        {
-            nodeIDs.clear ();
-            nodeHashes.clear ();
-            if (m_journal.trace) m_journal.trace <<
-                "filterNodes: all are duplicates";
-            return;
-        }
-    }
-    else if (dupCount > 0)
-    {
-        // some, but not all, duplicates
-        int insertPoint = 0;
-
-        for (unsigned int i = 0; i < nodeIDs.size (); ++i)
-            if (!duplicates[i])
-            {
-                // Keep this node
-                if (insertPoint != i)
-                {
-                    nodeIDs[insertPoint] = nodeIDs[i];
-                    nodeHashes[insertPoint] = nodeHashes[i];
-                }
-
-                ++insertPoint;
-            }
-
-        if (m_journal.trace) m_journal.trace <<
-            "filterNodes " << nodeIDs.size () << " to " << insertPoint;
-        nodeIDs.resize (insertPoint);
-        nodeHashes.resize (insertPoint);
-    }
-
-    if (nodeIDs.size () > max)
-    {
-        nodeIDs.resize (max);
-        nodeHashes.resize (max);
-    }
-
-    BOOST_FOREACH (const SHAMapNodeID & n, nodeIDs)
-    {
-        recentNodes.insert (n);
-    }
-}
-
 /** Take ledger header data
     Call with a lock
 */
@@ -1137,6 +1104,13 @@ int InboundLedger::processData (std::shared_ptr<Peer> peer,
                 node.nodedata ().end ()));
         }
 
+        // Free up the pipeline slot this answers
+        LedgerFetchPipeline& pipeline = (packet.type () == protocol::liTX_NODE)
+            ? mTxPipeline : mStatePipeline;
+        pipeline.onReply (peer->getShortId (), std::vector <SHAMapNodeID> (
+            nodeIDs.begin (), nodeIDs.end ()),
+                LedgerFetchPipeline::clock_type::now ());
+
         SHAMapAddNode ret;
 
         if (packet.type () == protocol::liTX_NODE)
@@ -94,10 +94,6 @@ public:
 
     std::vector<neededHash_t> getNeededHashes ();
 
-    // VFALCO TODO Replace uint256 with something semanticallyh meaningful
-    void filterNodes (std::vector<SHAMapNodeID>& nodeIDs, std::vector<uint256>& nodeHashes,
-                             std::set<SHAMapNodeID>& recentNodes, int max, bool aggressive);
-
     Json::Value getJson (int);
     void runData ();
 
@@ -113,6 +109,15 @@ private:
 
     std::weak_ptr <PeerSet> pmDowncast ();
 
+    // The peers in the set which are still connected
+    std::vector <Peer::ShortId> getPeerIds () const;
+
+    // Send requests for missing nodes to the peers with room for them
+    std::size_t sendNodeRequests (LedgerFetchPipeline& pipeline,
+        std::vector <Peer::ShortId> const& peers,
+        std::vector <SHAMapNodeID> const& nodeIDs,
+        protocol::TMGetLedger const& message);
+
     int processData (std::shared_ptr<Peer> peer, protocol::TMLedgerData& data);
 
     bool takeHeader (std::string const& data);
@@ -139,8 +144,8 @@ private:
     std::uint32_t      mSeq;
     fcReason           mReason;
 
-    std::set <SHAMapNodeID> mRecentTXNodes;
-    std::set <SHAMapNodeID> mRecentASNodes;
+    LedgerFetchPipeline mTxPipeline;
+    LedgerFetchPipeline mStatePipeline;
 
 
     // Data we have received from peers
@@ -240,16 +240,14 @@ Ledger::~Ledger ()
     {
         logTimedDestroy <Ledger> (
             mTransactionMap,
-            "mTransactionMap with "
-            + std::to_string(mTransactionMap->size ()) + " items");
+            "mTransactionMap");
     }
 
     if (mAccountStateMap)
     {
         logTimedDestroy <Ledger> (
             mAccountStateMap,
-            "mAccountStateMap with "
-            + std::to_string (mAccountStateMap->size ()) + " items");
+            "mAccountStateMap");
     }
 }
 
@@ -628,8 +626,6 @@ bool Ledger::saveValidatedLedger (bool current)
         "DELETE FROM Transactions WHERE LedgerSeq = %u;");
     static boost::format deleteTrans2 (
         "DELETE FROM AccountTransactions WHERE LedgerSeq = %u;");
-    static boost::format deleteAcctTrans (
-        "DELETE FROM AccountTransactions WHERE TransID = '%s';");
     static boost::format transExists (
         "SELECT Status FROM Transactions WHERE TransID = '%s';");
     static boost::format updateTx (
@@ -699,7 +695,11 @@ bool Ledger::saveValidatedLedger (bool current)
         db->executeSQL (boost::str (deleteTrans1 % getLedgerSeq ()));
         db->executeSQL (boost::str (deleteTrans2 % getLedgerSeq ()));
 
-        std::string const ledgerSeq (std::to_string (getLedgerSeq ()));
+        SqliteStatement& deleteAcctTrans (db->getSqliteDB ()->getStatement (
+            "DELETE FROM AccountTransactions WHERE TransID = ?;"));
+        SqliteStatement& insertAcctTrans (db->getSqliteDB ()->getStatement (
+            "INSERT INTO AccountTransactions "
+            "(TransID, Account, LedgerSeq, TxnSeq) VALUES (?, ?, ?, ?);"));
 
         for (auto const& vt : aLedger->getMap ())
         {
@@ -709,48 +709,34 @@ bool Ledger::saveValidatedLedger (bool current)
                 transactionID, getLedgerSeq ());
 
             std::string const txnId (to_string (transactionID));
-            std::string const txnSeq (std::to_string (vt.second->getTxnSeq ()));
 
-            db->executeSQL (boost::str (deleteAcctTrans % transactionID));
+            deleteAcctTrans.bind (1, txnId);
+            deleteAcctTrans.step ();
+            deleteAcctTrans.reset ();
 
             auto const& accts = vt.second->getAffected ();
 
             if (!accts.empty ())
             {
-                std::string sql ("INSERT INTO AccountTransactions "
-                                 "(TransID, Account, LedgerSeq, TxnSeq) VALUES ");
-
-                // Try to make an educated guess on how much space we'll need
-                // for our arguments. In argument order we have:
-                // 64 + 34 + 10 + 10 = 118 + 10 extra = 128 bytes
-                sql.reserve (sql.length () + (accts.size () * 128));
-
-                bool first = true;
                 for (auto const& it : accts)
                 {
-                    if (!first)
-                        sql += ", ('";
-                    else
+                    Account const& account (it.getAccountID ());
+
+                    insertAcctTrans.bind (1, txnId);
+                    insertAcctTrans.bind (2, account.begin (), account.size ());
+                    insertAcctTrans.bind (3, getLedgerSeq ());
+                    insertAcctTrans.bind (4, vt.second->getTxnSeq ());
+
+                    int const rc = insertAcctTrans.step ();
+
+                    if (!insertAcctTrans.isDone (rc))
                     {
-                        sql += "('";
-                        first = false;
+                        WriteLog (lsWARNING, Ledger) << "ActTx: "
+                            << insertAcctTrans.getError (rc);
                     }
 
-                    sql += txnId;
-                    sql += "','";
-                    sql += it.humanAccountID ();
-                    sql += "',";
-                    sql += ledgerSeq;
-                    sql += ",";
-                    sql += txnSeq;
-                    sql += ")";
-                }
-                sql += ";";
-                if (ShouldLog (lsTRACE, Ledger))
-                {
-                    WriteLog (lsTRACE, Ledger) << "ActTx: " << sql;
+                    insertAcctTrans.reset ();
                 }
-                db->executeSQL (sql);
             }
             else
                 WriteLog (lsWARNING, Ledger)
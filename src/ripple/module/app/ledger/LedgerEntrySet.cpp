@@ -17,6 +17,8 @@
 */
 //==============================================================================
 
+#include <beast/unit_test/suite.h>
+
 namespace ripple {
 
 // #define META_DEBUG
@@ -26,6 +28,232 @@ namespace ripple {
 //
 #define DIR_NODE_MAX        32
 
+LedgerEntrySetEntries::const_iterator::const_iterator (
+    Entries::const_iterator base, Entries::const_iterator baseEnd,
+    Entries::const_iterator delta, Entries::const_iterator deltaEnd)
+    : mBase (base)
+    , mBaseEnd (baseEnd)
+    , mDelta (delta)
+    , mDeltaEnd (deltaEnd)
+{
+    settle ();
+}
+
+LedgerEntrySetEntries::const_iterator&
+LedgerEntrySetEntries::const_iterator::operator++ ()
+{
+    assert (mCurrent != nullptr);
+
+    if ((mDelta != mDeltaEnd) && (&*mDelta == mCurrent))
+        ++mDelta;
+    else
+        ++mBase;
+
+    settle ();
+    return *this;
+}
+
+// Point at the next entry to visit, skipping the base entries hidden
+// by the delta and the placeholders for erased entries.
+void LedgerEntrySetEntries::const_iterator::settle ()
+{
+    for (;;)
+    {
+        if (mDelta == mDeltaEnd)
+        {
+            mCurrent = (mBase == mBaseEnd) ? nullptr : &*mBase;
+            return;
+        }
+
+        if ((mBase != mBaseEnd) && (mBase->first < mDelta->first))
+        {
+            mCurrent = &*mBase;
+            return;
+        }
+
+        if ((mBase != mBaseEnd) && (mBase->first == mDelta->first))
+            ++mBase;
+
+        if (mDelta->second.mAction != taaNONE)
+        {
+            mCurrent = &*mDelta;
+            return;
+        }
+
+        ++mDelta;
+    }
+}
+
+void LedgerEntrySetEntries::clear ()
+{
+    mBase.reset ();
+    mDelta.clear ();
+}
+
+void LedgerEntrySetEntries::swap (LedgerEntrySetEntries& other)
+{
+    mBase.swap (other.mBase);
+    mDelta.swap (other.mDelta);
+}
+
+LedgerEntrySetEntries::Entries::const_iterator
+LedgerEntrySetEntries::lowerBound (Entries const& entries, uint256 const& index)
+{
+    return std::lower_bound (entries.begin (), entries.end (), index,
+        [](value_type const& entry, uint256 const& index)
+        {
+            return entry.first < index;
+        });
+}
+
+LedgerEntrySetEntry const* LedgerEntrySetEntries::find (uint256 const& index) const
+{
+    auto const delta = lowerBound (mDelta, index);
+
+    if ((delta != mDelta.end ()) && (delta->first == index))
+        return (delta->second.mAction == taaNONE) ? nullptr : &delta->second;
+
+    if (mBase)
+    {
+        auto const base = lowerBound (*mBase, index);
+
+        if ((base != mBase->end ()) && (base->first == index))
+            return &base->second;
+    }
+
+    return nullptr;
+}
+
+LedgerEntrySetEntry* LedgerEntrySetEntries::findForWrite (uint256 const& index)
+{
+    auto const delta = lowerBound (mDelta, index);
+
+    if ((delta != mDelta.end ()) && (delta->first == index))
+    {
+        if (delta->second.mAction == taaNONE)
+            return nullptr;
+
+        return &mDelta[delta - mDelta.begin ()].second;
+    }
+
+    if (mBase)
+    {
+        auto const base = lowerBound (*mBase, index);
+
+        if ((base != mBase->end ()) && (base->first == index))
+            return insertDelta (index, base->second);
+    }
+
+    return nullptr;
+}
+
+void LedgerEntrySetEntries::insert (uint256 const& index,
+    LedgerEntrySetEntry const& entry)
+{
+    assert (find (index) == nullptr);
+
+    // An erased base entry leaves a placeholder, which the entry replaces
+    auto const delta = lowerBound (mDelta, index);
+
+    if ((delta != mDelta.end ()) && (delta->first == index))
+        mDelta[delta - mDelta.begin ()].second = entry;
+    else
+        insertDelta (index, entry);
+}
+
+void LedgerEntrySetEntries::erase (uint256 const& index)
+{
+    bool inBase = false;
+
+    if (mBase)
+    {
+        auto const base = lowerBound (*mBase, index);
+        inBase = (base != mBase->end ()) && (base->first == index);
+    }
+
+    auto const delta = lowerBound (mDelta, index);
+    bool const inDelta = (delta != mDelta.end ()) && (delta->first == index);
+
+    if (!inBase)
+    {
+        if (inDelta)
+            mDelta.erase (delta);
+    }
+    else if (inDelta)
+    {
+        mDelta[delta - mDelta.begin ()].second =
+            LedgerEntrySetEntry (SLE::pointer (), taaNONE, 0);
+    }
+    else
+    {
+        insertDelta (index, LedgerEntrySetEntry (SLE::pointer (), taaNONE, 0));
+    }
+}
+
+LedgerEntrySetEntries::const_iterator LedgerEntrySetEntries::begin () const
+{
+    if (mBase)
+        return const_iterator (mBase->begin (), mBase->end (),
+            mDelta.begin (), mDelta.end ());
+
+    return const_iterator (mDelta.end (), mDelta.end (),
+        mDelta.begin (), mDelta.end ());
+}
+
+LedgerEntrySetEntries::const_iterator LedgerEntrySetEntries::end () const
+{
+    return const_iterator ();
+}
+
+LedgerEntrySetEntries::const_iterator
+LedgerEntrySetEntries::upper_bound (uint256 const& index) const
+{
+    auto delta = lowerBound (mDelta, index);
+
+    if ((delta != mDelta.end ()) && (delta->first == index))
+        ++delta;
+
+    if (!mBase)
+        return const_iterator (mDelta.end (), mDelta.end (),
+            delta, mDelta.end ());
+
+    auto base = lowerBound (*mBase, index);
+
+    if ((base != mBase->end ()) && (base->first == index))
+        ++base;
+
+    return const_iterator (base, mBase->end (), delta, mDelta.end ());
+}
+
+LedgerEntrySetEntry* LedgerEntrySetEntries::insertDelta (uint256 const& index,
+    LedgerEntrySetEntry const& entry)
+{
+    // The entry may live in the base, which merging can free
+    value_type value (index, entry);
+
+    // Merging costs a pass over the base, waiting until the delta is a
+    // quarter of its size keeps that cost proportional to the changes.
+    if ((mDelta.size () >= 16) && ((mDelta.size () * 4) >= baseSize ()))
+        merge ();
+
+    auto const pos = mDelta.begin () + (lowerBound (mDelta, index) - mDelta.cbegin ());
+    return &mDelta.insert (pos, std::move (value))->second;
+}
+
+void LedgerEntrySetEntries::merge ()
+{
+    auto merged = std::make_shared <Entries> ();
+    merged->reserve (baseSize () + mDelta.size ());
+
+    for (auto it = begin (), e = end (); it != e; ++it)
+        merged->push_back (*it);
+
+    mBase = std::move (merged);
+    mDelta.clear ();
+}
+
+//------------------------------------------------------------------------------
+
 void LedgerEntrySet::init (Ledger::ref ledger, uint256 const& transactionID,
                            std::uint32_t ledgerID, TransactionEngineParams params)
 {
@@ -60,23 +288,25 @@ void LedgerEntrySet::swapWith (LedgerEntrySet& e)
 // This is basically: copy-on-read.
 SLE::pointer LedgerEntrySet::getEntry (uint256 const& index, LedgerEntryAction& action)
 {
-    auto it = mEntries.find (index);
+    auto found = mEntries.find (index);
 
-    if (it == mEntries.end ())
+    if (found == nullptr)
     {
         action = taaNONE;
         return SLE::pointer ();
     }
 
-    if (it->second.mSeq != mSeq)
+    if (found->mSeq != mSeq)
     {
-        assert (it->second.mSeq < mSeq);
-        it->second.mEntry = std::make_shared<SerializedLedgerEntry> (*it->second.mEntry);
-        it->second.mSeq = mSeq;
+        assert (found->mSeq < mSeq);
+        auto entry = mEntries.findForWrite (index);
+        entry->mEntry = std::make_shared<SerializedLedgerEntry> (*entry->mEntry);
+        entry->mSeq = mSeq;
+        found = entry;
     }
 
-    action = it->second.mAction;
-    return it->second.mEntry;
+    action = found->mAction;
+    return found->mEntry;
 }
 
 SLE::pointer LedgerEntrySet::entryCreate (LedgerEntryType letType, uint256 const& index)
@@ -114,32 +344,32 @@ SLE::pointer LedgerEntrySet::entryCache (LedgerEntryType letType, uint256 const&
 
 LedgerEntryAction LedgerEntrySet::hasEntry (uint256 const& index) const
 {
-    std::map<uint256, LedgerEntrySetEntry>::const_iterator it = mEntries.find (index);
+    auto const entry = mEntries.find (index);
 
-    if (it == mEntries.end ())
+    if (entry == nullptr)
         return taaNONE;
 
-    return it->second.mAction;
+    return entry->mAction;
 }
 
 void LedgerEntrySet::entryCache (SLE::ref sle)
 {
     assert (mLedger);
     assert (sle->isMutable () || mImmutable); // Don't put an immutable SLE in a mutable LES
-    auto it = mEntries.find (sle->getIndex ());
+    auto it = mEntries.findForWrite (sle->getIndex ());
 
-    if (it == mEntries.end ())
+    if (it == nullptr)
     {
-        mEntries.insert (std::make_pair (sle->getIndex (), LedgerEntrySetEntry (sle, taaCACHED, mSeq)));
+        mEntries.insert (sle->getIndex (), LedgerEntrySetEntry (sle, taaCACHED, mSeq));
         return;
     }
 
-    switch (it->second.mAction)
+    switch (it->mAction)
     {
     case taaCACHED:
-        assert (sle == it->second.mEntry);
-        it->second.mSeq     = mSeq;
-        it->second.mEntry   = sle;
+        assert (sle == it->mEntry);
+        it->mSeq     = mSeq;
+        it->mEntry   = sle;
         return;
 
     default:
@@ -151,22 +381,22 @@ void LedgerEntrySet::entryCreate (SLE::ref sle)
 {
     assert (mLedger && !mImmutable);
     assert (sle->isMutable ());
-    auto it = mEntries.find (sle->getIndex ());
+    auto it = mEntries.findForWrite (sle->getIndex ());
 
-    if (it == mEntries.end ())
+    if (it == nullptr)
     {
-        mEntries.insert (std::make_pair (sle->getIndex (), LedgerEntrySetEntry (sle, taaCREATE, mSeq)));
+        mEntries.insert (sle->getIndex (), LedgerEntrySetEntry (sle, taaCREATE, mSeq));
         return;
     }
 
-    switch (it->second.mAction)
+    switch (it->mAction)
     {
 
     case taaDELETE:
         WriteLog (lsDEBUG, LedgerEntrySet) << "Create after Delete = Modify";
-        it->second.mEntry = sle;
-        it->second.mAction = taaMODIFY;
-        it->second.mSeq = mSeq;
+        it->mEntry = sle;
+        it->mAction = taaMODIFY;
+        it->mSeq = mSeq;
         break;
 
     case taaMODIFY:
@@ -182,35 +412,35 @@ void LedgerEntrySet::entryCreate (SLE::ref sle)
         throw std::runtime_error ("Unknown taa");
     }
 
-    assert (it->second.mSeq == mSeq);
+    assert (it->mSeq == mSeq);
 }
 
 void LedgerEntrySet::entryModify (SLE::ref sle)
 {
     assert (sle->isMutable () && !mImmutable);
     assert (mLedger);
-    auto it = mEntries.find (sle->getIndex ());
+    auto it = mEntries.findForWrite (sle->getIndex ());
 
-    if (it == mEntries.end ())
+    if (it == nullptr)
     {
-        mEntries.insert (std::make_pair (sle->getIndex (), LedgerEntrySetEntry (sle, taaMODIFY, mSeq)));
+        mEntries.insert (sle->getIndex (), LedgerEntrySetEntry (sle, taaMODIFY, mSeq));
         return;
     }
 
-    assert (it->second.mSeq == mSeq);
-    assert (it->second.mEntry == sle);
+    assert (it->mSeq == mSeq);
+    assert (it->mEntry == sle);
 
-    switch (it->second.mAction)
+    switch (it->mAction)
     {
     case taaCACHED:
-        it->second.mAction  = taaMODIFY;
+        it->mAction  = taaMODIFY;
 
         // Fall through
 
     case taaCREATE:
     case taaMODIFY:
-        it->second.mSeq     = mSeq;
-        it->second.mEntry   = sle;
+        it->mSeq     = mSeq;
+        it->mEntry   = sle;
         break;
 
     case taaDELETE:
@@ -225,29 +455,29 @@ void LedgerEntrySet::entryDelete (SLE::ref sle)
 {
     assert (sle->isMutable () && !mImmutable);
     assert (mLedger);
-    auto it = mEntries.find (sle->getIndex ());
+    auto it = mEntries.findForWrite (sle->getIndex ());
 
-    if (it == mEntries.end ())
+    if (it == nullptr)
     {
         assert (false); // deleting an entry not cached?
-        mEntries.insert (std::make_pair (sle->getIndex (), LedgerEntrySetEntry (sle, taaDELETE, mSeq)));
+        mEntries.insert (sle->getIndex (), LedgerEntrySetEntry (sle, taaDELETE, mSeq));
         return;
     }
 
-    assert (it->second.mSeq == mSeq);
-    assert (it->second.mEntry == sle);
+    assert (it->mSeq == mSeq);
+    assert (it->mEntry == sle);
 
-    switch (it->second.mAction)
+    switch (it->mAction)
     {
     case taaCACHED:
     case taaMODIFY:
-        it->second.mSeq     = mSeq;
-        it->second.mEntry   = sle;
-        it->second.mAction  = taaDELETE;
+        it->mSeq     = mSeq;
+        it->mEntry   = sle;
+        it->mAction  = taaDELETE;
         break;
 
     case taaCREATE:
-        mEntries.erase (it);
+        mEntries.erase (sle->getIndex ());
         break;
 
     case taaDELETE:
@@ -347,26 +577,26 @@ Json::Value LedgerEntrySet::getJson (int) const
 SLE::pointer LedgerEntrySet::getForMod (uint256 const& node, Ledger::ref ledger,
                                         NodeToLedgerEntry& newMods)
 {
-    auto it = mEntries.find (node);
+    auto it = mEntries.findForWrite (node);
 
-    if (it != mEntries.end ())
+    if (it != nullptr)
     {
-        if (it->second.mAction == taaDELETE)
+        if (it->mAction == taaDELETE)
         {
             WriteLog (lsFATAL, LedgerEntrySet) << "Trying to thread to deleted node";
             return SLE::pointer ();
         }
 
-        if (it->second.mAction == taaCACHED)
-            it->second.mAction = taaMODIFY;
+        if (it->mAction == taaCACHED)
+            it->mAction = taaMODIFY;
 
-        if (it->second.mSeq != mSeq)
+        if (it->mSeq != mSeq)
         {
-            it->second.mEntry = std::make_shared<SerializedLedgerEntry> (*it->second.mEntry);
-            it->second.mSeq = mSeq;
+            it->mEntry = std::make_shared<SerializedLedgerEntry> (*it->mEntry);
+            it->mSeq = mSeq;
         }
 
-        return it->second.mEntry;
+        return it->mEntry;
     }
 
     auto me = newMods.find (node);
@@ -454,8 +684,16 @@ void LedgerEntrySet::calcRawMeta (Serializer& s, TER result, std::uint32_t index
     // Entries modified only as a result of building the transaction metadata
     NodeToLedgerEntry newMod;
 
-    for (auto& it : mEntries)
+    // Threading below can change entries as we go, which moves them
+    // around in mEntries, so each one is looked up again when visited
+    std::vector<uint256> nodes;
+
+    for (auto const& it : mEntries)
+        nodes.push_back (it.first);
+
+    for (auto const& node : nodes)
     {
+        LedgerEntrySetEntries::value_type const it (node, *mEntries.find (node));
         SField::ptr type = &sfGeneric;
 
         switch (it.second.mAction)
@@ -995,17 +1233,17 @@ uint256 LedgerEntrySet::getNextLedgerIndex (uint256 const& uHash)
 {
     // find next node in ledger that isn't deleted by LES
     uint256 ledgerNext = uHash;
-    std::map<uint256, LedgerEntrySetEntry>::const_iterator it;
+    LedgerEntrySetEntry const* entry;
 
     do
     {
         ledgerNext = mLedger->getNextLedgerIndex (ledgerNext);
-        it  = mEntries.find (ledgerNext);
+        entry = mEntries.find (ledgerNext);
     }
-    while ((it != mEntries.end ()) && (it->second.mAction == taaDELETE));
+    while ((entry != nullptr) && (entry->mAction == taaDELETE));
 
     // find next node in LES that isn't deleted
-    for (it = mEntries.upper_bound (uHash); it != mEntries.end (); ++it)
+    for (auto it = mEntries.upper_bound (uHash); it != mEntries.end (); ++it)
     {
         // node found in LES, node found in ledger, return earliest
         if (it->second.mAction != taaDELETE)
@@ -1824,4 +2062,130 @@ TER LedgerEntrySet::accountSend (
     return terResult;
 }
 
+//------------------------------------------------------------------------------
+
+class LedgerEntrySetEntries_test : public beast::unit_test::suite
+{
+public:
+    static uint256 index (int i)
+    {
+        uint256 ret;
+        ret.begin ()[31] = static_cast<unsigned char> (i);
+        return ret;
+    }
+
+    static LedgerEntrySetEntry entry (LedgerEntryAction action, int seq)
+    {
+        return LedgerEntrySetEntry (SLE::pointer (), action, seq);
+    }
+
+    // The indexes in order, and whether they match the expected ones
+    bool walk (LedgerEntrySetEntries const& entries, std::vector<int> const& expected)
+    {
+        std::vector<uint256> found;
+
+        for (auto const& e : entries)
+            found.push_back (e.first);
+
+        if (found.size () != expected.size ())
+            return false;
+
+        for (std::size_t i = 0; i < found.size (); ++i)
+            if (found[i] != index (expected[i]))
+                return false;
+
+        return true;
+    }
+
+    void testOrder ()
+    {
+        testcase ("order");
+
+        LedgerEntrySetEntries entries;
+        expect (entries.empty ());
+
+        // Enough entries to merge the delta into the base a few times
+        for (int i = 99; i >= 0; i -= 3)
+            entries.insert (index (i), entry (taaCACHED, 0));
+
+        std::vector<int> expected;
+        for (int i = 0; i <= 99; ++i)
+            if ((99 - i) % 3 == 0)
+                expected.push_back (i);
+
+        expect (walk (entries, expected));
+
+        auto it = entries.upper_bound (index (3));
+        expect ((it != entries.end ()) && (it->first == index (6)));
+
+        it = entries.upper_bound (index (4));
+        expect ((it != entries.end ()) && (it->first == index (6)));
+    }
+
+    void testDuplicate ()
+    {
+        testcase ("duplicate");
+
+        LedgerEntrySetEntries base;
+
+        for (int i = 0; i < 40; ++i)
+            base.insert (index (i), entry (taaCACHED, 0));
+
+        LedgerEntrySetEntries copy (base);
+
+        copy.findForWrite (index (5))->mAction = taaMODIFY;
+        copy.erase (index (6));
+        copy.insert (index (200), entry (taaCREATE, 1));
+
+        // The original doesn't see the changes
+        expect (base.find (index (5))->mAction == taaCACHED);
+        expect (base.find (index (6)) != nullptr);
+        expect (base.find (index (200)) == nullptr);
+
+        expect (copy.find (index (5))->mAction == taaMODIFY);
+        expect (copy.find (index (6)) == nullptr);
+        expect (copy.findForWrite (index (6)) == nullptr);
+        expect (copy.find (index (200))->mAction == taaCREATE);
+
+        std::vector<int> expected;
+        for (int i = 0; i < 40; ++i)
+            if (i != 6)
+                expected.push_back (i);
+        expected.push_back (200);
+
+        expect (walk (copy, expected));
+
+        // Erasing something that only the delta had leaves no trace
+        copy.erase (index (200));
+        expected.pop_back ();
+        expect (walk (copy, expected));
+
+        // Inserting over an erased base entry replaces the placeholder
+        copy.insert (index (6), entry (taaCREATE, 1));
+        expect (copy.find (index (6))->mAction == taaCREATE);
+
+        expected.clear ();
+        for (int i = 0; i < 40; ++i)
+            expected.push_back (i);
+        expect (walk (copy, expected));
+
+        copy.erase (index (6));
+        expect (copy.find (index (6)) == nullptr);
+        copy.insert (index (6), entry (taaCREATE, 1));
+        expect (walk (copy, expected));
+
+        copy.swap (base);
+        expect (base.find (index (6))->mAction == taaCREATE);
+        expect (copy.find (index (6))->mAction == taaCACHED);
+    }
+
+    void run ()
+    {
+        testOrder ();
+        testDuplicate ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(LedgerEntrySetEntries,ripple_app,ripple);
+
 } // ripple
@@ -75,6 +75,147 @@ public:
     }
 };
 
+/** The entries of a LedgerEntrySet, in index order.
+
+    Metadata is built by walking the entries in order, so they are kept
+    in sorted vectors rather than a hash table. The base vector is shared
+    between a set and its duplicates and is never changed once shared.
+    The delta vector holds the entries this set has touched since, and
+    an erased base entry is left in the delta as a taaNONE placeholder.
+    Duplicating a set only copies the delta. Once the delta is large
+    compared to the base, the two are merged into a new base.
+*/
+class LedgerEntrySetEntries
+{
+public:
+    typedef std::pair <uint256, LedgerEntrySetEntry> value_type;
+
+private:
+    typedef std::vector <value_type> Entries;
+
+public:
+    // Walks the base and the delta together, a delta entry hides the
+    // base entry with the same index.
+    class const_iterator
+        : public std::iterator <std::forward_iterator_tag, value_type const>
+    {
+    public:
+        const_iterator () = default;
+
+        value_type const& operator* () const
+        {
+            return *mCurrent;
+        }
+
+        value_type const* operator-> () const
+        {
+            return mCurrent;
+        }
+
+        const_iterator& operator++ ();
+
+        const_iterator operator++ (int)
+        {
+            const_iterator ret (*this);
+            ++*this;
+            return ret;
+        }
+
+        bool operator== (const_iterator const& other) const
+        {
+            return mCurrent == other.mCurrent;
+        }
+
+        bool operator!= (const_iterator const& other) const
+        {
+            return mCurrent != other.mCurrent;
+        }
+
+    private:
+        friend class LedgerEntrySetEntries;
+
+        const_iterator (Entries::const_iterator base, Entries::const_iterator baseEnd,
+            Entries::const_iterator delta, Entries::const_iterator deltaEnd);
+
+        void settle ();
+
+        Entries::const_iterator mBase;
+        Entries::const_iterator mBaseEnd;
+        Entries::const_iterator mDelta;
+        Entries::const_iterator mDeltaEnd;
+        value_type const* mCurrent = nullptr;
+    };
+
+    LedgerEntrySetEntries () = default;
+    LedgerEntrySetEntries (LedgerEntrySetEntries const&) = default;
+    LedgerEntrySetEntries& operator= (LedgerEntrySetEntries const&) = default;
+
+    LedgerEntrySetEntries (LedgerEntrySetEntries&& other)
+        : mBase (std::move (other.mBase))
+        , mDelta (std::move (other.mDelta))
+    {
+    }
+
+    LedgerEntrySetEntries& operator= (LedgerEntrySetEntries&& other)
+    {
+        mBase = std::move (other.mBase);
+        mDelta = std::move (other.mDelta);
+        return *this;
+    }
+
+    bool empty () const
+    {
+        return begin () == end ();
+    }
+
+    void clear ();
+
+    void swap (LedgerEntrySetEntries& other);
+
+    /** Find an entry for reading.
+        @return The entry, or nullptr if there is none.
+    */
+    LedgerEntrySetEntry const* find (uint256 const& index) const;
+
+    /** Find an entry for changing.
+        An entry in the shared base is first copied into the delta.
+        The pointer is good until the next call which changes the set.
+        @return The entry, or nullptr if there is none.
+    */
+    LedgerEntrySetEntry* findForWrite (uint256 const& index);
+
+    /** Add an entry, there must not already be one for the index. */
+    void insert (uint256 const& index, LedgerEntrySetEntry const& entry);
+
+    /** Remove the entry for an index, if there is one. */
+    void erase (uint256 const& index);
+
+    const_iterator begin () const;
+    const_iterator end () const;
+
+    /** Return the first entry after an index. */
+    const_iterator upper_bound (uint256 const& index) const;
+
+private:
+    static Entries::const_iterator lowerBound (Entries const& entries,
+        uint256 const& index);
+
+    std::size_t baseSize () const
+    {
+        return mBase ? mBase->size () : 0;
+    }
+
+    // Insert into the delta at the sorted position, merging first if
+    // the delta has grown too large.
+    LedgerEntrySetEntry* insertDelta (uint256 const& index,
+        LedgerEntrySetEntry const& entry);
+
+    void merge ();
+
+    std::shared_ptr <Entries const> mBase;
+    Entries mDelta;
+};
+
 /** An LES is a LedgerEntrySet.
 
     It's a view into a ledger used while a transaction is processing.
@@ -277,8 +418,7 @@ public:
     void calcRawMeta (Serializer&, TER result, std::uint32_t index);
 
     // iterator functions
-    typedef std::map<uint256, LedgerEntrySetEntry>::iterator iterator;
-    typedef std::map<uint256, LedgerEntrySetEntry>::const_iterator const_iterator;
+    typedef LedgerEntrySetEntries::const_iterator const_iterator;
 
     bool isEmpty () const
     {
@@ -292,14 +432,6 @@ public:
     {
         return mEntries.end ();
     }
-    iterator begin ()
-    {
-        return mEntries.begin ();
-    }
-    iterator end ()
-    {
-        return mEntries.end ();
-    }
 
     void setDeliveredAmount (STAmount const& amt)
     {
@@ -308,7 +440,7 @@ public:
 
 private:
     Ledger::pointer mLedger;
-    std::map<uint256, LedgerEntrySetEntry>  mEntries; // cannot be unordered!
+    LedgerEntrySetEntries mEntries; // cannot be unordered!
 
     typedef hash_map<uint256, SLE::pointer> NodeToLedgerEntry;
 
@@ -318,7 +450,7 @@ private:
     bool mImmutable;
 
     LedgerEntrySet (
-        Ledger::ref ledger, const std::map<uint256, LedgerEntrySetEntry>& e,
+        Ledger::ref ledger, LedgerEntrySetEntries const& e,
         const TransactionMetaSet & s, int m) :
         mLedger (ledger), mEntries (e), mSet (s), mParams (tapNONE), mSeq (m),
         mImmutable (false)
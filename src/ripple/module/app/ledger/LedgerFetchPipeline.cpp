@@ -0,0 +1,405 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <beast/unit_test/suite.h>
+#include <set>
+
+namespace ripple {
+
+enum
+{
+    // Nodes in the first request sent to a peer
+    fetchRequestNodesInitial = 64
+
+    // Bounds on the nodes in one request
+    ,fetchRequestNodesMin = 16
+    ,fetchRequestNodesMax = 256
+
+    // The time we'd like a peer to take answering one request
+    ,fetchRequestTargetMillis = 500
+
+    // A request is given up on after four times the peer's usual
+    // answer time, but never sooner than this
+    ,fetchRequestTimeoutMillis = 2000
+
+    // Most missing nodes to look for at once
+    ,fetchWantedNodesMax = 4096
+};
+
+LedgerFetchPipeline::PeerState::PeerState ()
+    : requestSize (fetchRequestNodesInitial)
+    , latency (clock_type::duration::zero ())
+{
+}
+
+LedgerFetchPipeline::LedgerFetchPipeline (int requestsPerPeer)
+    : m_requestsPerPeer (std::max (requestsPerPeer, 1))
+{
+}
+
+std::size_t LedgerFetchPipeline::getWanted (
+    std::vector <PeerId> const& peers, clock_type::time_point now)
+{
+    expire (now);
+
+    std::size_t room = 0;
+
+    for (auto const peer : peers)
+    {
+        PeerState const& state = getPeer (peer);
+
+        if (state.inFlight.size () < m_requestsPerPeer)
+            room += (m_requestsPerPeer - state.inFlight.size ()) *
+                state.requestSize;
+    }
+
+    if (room == 0)
+        return 0;
+
+    return std::min <std::size_t> (room + m_outstanding.size (),
+        fetchWantedNodesMax);
+}
+
+std::vector <LedgerFetchPipeline::Request> LedgerFetchPipeline::assign (
+    std::vector <PeerId> const& peers,
+    std::vector <SHAMapNodeID> const& nodes, clock_type::time_point now)
+{
+    expire (now);
+
+    // Fill the fastest peers first. Peers which haven't answered yet
+    // sort first, so that they get a chance to show their speed.
+    std::vector <std::pair <clock_type::duration, PeerId>> order;
+    order.reserve (peers.size ());
+
+    for (auto const peer : peers)
+        order.push_back (std::make_pair (getPeer (peer).latency, peer));
+
+    std::sort (order.begin (), order.end ());
+
+    std::vector <Request> requests;
+    auto node = nodes.begin ();
+
+    for (auto const& entry : order)
+    {
+        PeerId const peer = entry.second;
+        PeerState& state = getPeer (peer);
+
+        while (state.inFlight.size () < m_requestsPerPeer)
+        {
+            Sent sent;
+            sent.time = now;
+
+            while ((node != nodes.end ()) &&
+                (sent.nodes.size () < state.requestSize))
+            {
+                if (m_outstanding.insert (std::make_pair (*node, peer)).second)
+                    sent.nodes.push_back (*node);
+
+                ++node;
+            }
+
+            if (sent.nodes.empty ())
+                return requests;
+
+            Request request;
+            request.peer = peer;
+            request.nodes = sent.nodes;
+            requests.push_back (std::move (request));
+
+            state.inFlight.push_back (std::move (sent));
+        }
+    }
+
+    return requests;
+}
+
+void LedgerFetchPipeline::onReply (PeerId peer,
+    std::vector <SHAMapNodeID> const& nodes, clock_type::time_point now)
+{
+    for (auto const& node : nodes)
+        m_outstanding.erase (node);
+
+    auto const iter = m_peers.find (peer);
+
+    if (iter == m_peers.end ())
+        return;
+
+    // Find the request this answers. A reply to a request we've already
+    // given up on, or to one that didn't come from us, matches none.
+    PeerState& state = iter->second;
+    std::set <SHAMapNodeID> const received (nodes.begin (), nodes.end ());
+
+    auto const sent = std::find_if (state.inFlight.begin (),
+        state.inFlight.end (), [&received](Sent const& s)
+        {
+            return std::any_of (s.nodes.begin (), s.nodes.end (),
+                [&received](SHAMapNodeID const& node)
+                {
+                    return received.count (node) != 0;
+                });
+        });
+
+    if (sent == state.inFlight.end ())
+        return;
+
+    // Anything the peer left out of its answer goes to whoever is free
+    release (peer, *sent);
+
+    clock_type::duration const elapsed = now - sent->time;
+    state.inFlight.erase (sent);
+
+    if (state.latency == clock_type::duration::zero ())
+        state.latency = elapsed;
+    else
+        state.latency = (state.latency * 3 + elapsed) / 4;
+
+    // Size the next request so it takes about the target time to answer,
+    // changing by no more than a factor of two at a time.
+    std::size_t const millis = std::max <std::size_t> (1,
+        std::chrono::duration_cast <std::chrono::milliseconds> (
+            elapsed).count ());
+    std::size_t size = state.requestSize * fetchRequestTargetMillis / millis;
+    size = std::max (size, state.requestSize / 2);
+    size = std::min (size, state.requestSize * 2);
+    state.requestSize = std::max <std::size_t> (fetchRequestNodesMin,
+        std::min <std::size_t> (size, fetchRequestNodesMax));
+}
+
+void LedgerFetchPipeline::reset ()
+{
+    for (auto& entry : m_peers)
+        entry.second.inFlight.clear ();
+
+    m_outstanding.clear ();
+}
+
+std::size_t LedgerFetchPipeline::getRequestSize (PeerId peer) const
+{
+    auto const iter = m_peers.find (peer);
+
+    if (iter == m_peers.end ())
+        return fetchRequestNodesInitial;
+
+    return iter->second.requestSize;
+}
+
+LedgerFetchPipeline::PeerState& LedgerFetchPipeline::getPeer (PeerId peer)
+{
+    return m_peers[peer];
+}
+
+LedgerFetchPipeline::clock_type::duration LedgerFetchPipeline::getTimeout (
+    PeerState const& state) const
+{
+    return std::max <clock_type::duration> (state.latency * 4,
+        std::chrono::milliseconds (fetchRequestTimeoutMillis));
+}
+
+void LedgerFetchPipeline::release (PeerId peer, Sent const& sent)
+{
+    for (auto const& node : sent.nodes)
+    {
+        auto const iter = m_outstanding.find (node);
+
+        if ((iter != m_outstanding.end ()) && (iter->second == peer))
+            m_outstanding.erase (iter);
+    }
+}
+
+void LedgerFetchPipeline::expire (clock_type::time_point now)
+{
+    for (auto& entry : m_peers)
+    {
+        PeerState& state = entry.second;
+        clock_type::duration const timeout = getTimeout (state);
+
+        while (!state.inFlight.empty () &&
+            ((now - state.inFlight.front ().time) > timeout))
+        {
+            release (entry.first, state.inFlight.front ());
+            state.inFlight.pop_front ();
+
+            // A peer which misses a request is given less to do
+            state.requestSize = std::max <std::size_t> (
+                fetchRequestNodesMin, state.requestSize / 2);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+class LedgerFetchPipeline_test : public beast::unit_test::suite
+{
+public:
+    typedef LedgerFetchPipeline::clock_type clock_type;
+
+    static std::vector <SHAMapNodeID> makeNodes (std::size_t count)
+    {
+        std::vector <SHAMapNodeID> nodes;
+        SHAMapNodeID const root;
+
+        for (int i = 0; (i < 16) && (nodes.size () < count); ++i)
+        {
+            SHAMapNodeID const child (root.getChildNodeID (i));
+
+            for (int j = 0; (j < 16) && (nodes.size () < count); ++j)
+                nodes.push_back (child.getChildNodeID (j));
+        }
+
+        return nodes;
+    }
+
+    void testAssign ()
+    {
+        testcase ("assign");
+
+        LedgerFetchPipeline pipeline (2);
+        auto const now = clock_type::now ();
+        std::vector <LedgerFetchPipeline::PeerId> const peers { 1, 2 };
+        auto const nodes = makeNodes (200);
+
+        expect (pipeline.getWanted (peers, now) == 4 * 64);
+
+        auto const requests = pipeline.assign (peers, nodes, now);
+
+        // 200 nodes in requests of 64 to two peers, two requests each
+        expect (requests.size () == 4);
+        expect (requests[0].nodes.size () == 64);
+        expect (requests[3].nodes.size () == 8);
+        expect (requests[0].nodes.front () == nodes[0]);
+        expect (requests[1].nodes.front () == nodes[64]);
+        expect (requests[0].peer == requests[1].peer);
+        expect (requests[2].peer != requests[0].peer);
+        expect (pipeline.getOutstanding () == 200);
+
+        // Every slot is in use, so nothing more goes out
+        expect (pipeline.assign (peers, nodes, now).empty ());
+    }
+
+    void testReply ()
+    {
+        testcase ("reply");
+
+        LedgerFetchPipeline pipeline (1);
+        auto const now = clock_type::now ();
+        std::vector <LedgerFetchPipeline::PeerId> const peers { 1 };
+        auto const nodes = makeNodes (64);
+
+        auto requests = pipeline.assign (peers, nodes, now);
+        expect (requests.size () == 1);
+
+        // The peer answers quickly with all but the last ten nodes
+        std::vector <SHAMapNodeID> received (
+            nodes.begin (), nodes.end () - 10);
+        pipeline.onReply (1, received, now + std::chrono::milliseconds (100));
+
+        expect (pipeline.getOutstanding () == 0);
+        expect (pipeline.getRequestSize (1) == 128);
+
+        // Only the nodes left out are requested again
+        std::vector <SHAMapNodeID> const missing (nodes.end () - 10,
+            nodes.end ());
+        requests = pipeline.assign (peers, missing, now);
+        expect (requests.size () == 1);
+        expect (requests[0].nodes == missing);
+    }
+
+    void testExpire ()
+    {
+        testcase ("expire");
+
+        LedgerFetchPipeline pipeline (1);
+        auto const now = clock_type::now ();
+        auto const nodes = makeNodes (32);
+
+        auto requests = pipeline.assign ({ 1 }, nodes, now);
+        expect (requests.size () == 1 && requests[0].peer == 1);
+
+        // Before the timeout another peer can't take the nodes
+        auto const soon = now + std::chrono::milliseconds (1000);
+        expect (pipeline.assign ({ 1, 2 }, nodes, soon).empty ());
+
+        // After it the straggling nodes go to whichever peer is free
+        auto const late = now + std::chrono::milliseconds (2500);
+        requests = pipeline.assign ({ 2 }, nodes, late);
+        expect (requests.size () == 1 && requests[0].peer == 2);
+        expect (requests[0].nodes.size () == 32);
+        expect (pipeline.getRequestSize (1) == 32);
+
+        // A late answer from the first peer still counts
+        pipeline.onReply (1, nodes, late);
+        expect (pipeline.getOutstanding () == 0);
+
+        pipeline.reset ();
+        expect (pipeline.assign ({ 2 }, nodes, late).size () == 1);
+    }
+
+    void testLateReply ()
+    {
+        testcase ("late reply");
+
+        LedgerFetchPipeline pipeline (2);
+        auto const now = clock_type::now ();
+        std::vector <LedgerFetchPipeline::PeerId> const peers { 1 };
+        auto const nodes = makeNodes (128);
+        std::vector <SHAMapNodeID> const first (
+            nodes.begin (), nodes.begin () + 64);
+        std::vector <SHAMapNodeID> const second (
+            nodes.begin () + 64, nodes.end ());
+
+        auto const later = now + std::chrono::milliseconds (1500);
+        expect (pipeline.assign (peers, first, now).size () == 1);
+        expect (pipeline.assign (peers, second, later).size () == 1);
+
+        // Only the first request is overdue
+        auto const late = now + std::chrono::milliseconds (2500);
+        expect (pipeline.getWanted (peers, late) == 32 + 64);
+        expect (pipeline.getOutstanding () == 64);
+        expect (pipeline.getRequestSize (1) == 32);
+
+        // Its answer doesn't retire the second request
+        pipeline.onReply (1, first, late);
+        expect (pipeline.getOutstanding () == 64);
+        expect (pipeline.getRequestSize (1) == 32);
+        expect (pipeline.getWanted (peers, late) == 32 + 64);
+
+        // A reply which matches nothing changes nothing
+        pipeline.onReply (1, { SHAMapNodeID () }, late);
+        expect (pipeline.getOutstanding () == 64);
+
+        // The second request's answer took 1200ms
+        auto const answered = later + std::chrono::milliseconds (1200);
+        pipeline.onReply (1, second, answered);
+        expect (pipeline.getOutstanding () == 0);
+        expect (pipeline.getRequestSize (1) == 16);
+        expect (pipeline.getWanted (peers, answered) == 2 * 16);
+    }
+
+    void run ()
+    {
+        testAssign ();
+        testReply ();
+        testExpire ();
+        testLateReply ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(LedgerFetchPipeline,ripple_app,ripple);
+
+}
@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_LEDGERFETCHPIPELINE_H_INCLUDED
+#define RIPPLE_LEDGERFETCHPIPELINE_H_INCLUDED
+
+#include <chrono>
+#include <deque>
+#include <map>
+
+namespace ripple {
+
+/** Spreads requests for the missing nodes of a map across several peers.
+
+    Each peer may have a few requests in flight at once. The number of
+    nodes put in a request to a peer follows how quickly that peer has
+    answered, so faster peers are given more of the work. Runs of
+    consecutive missing nodes, which usually belong to the same subtree,
+    go to the same peer.
+
+    A node stays assigned to its peer until a reply containing it arrives.
+    If a peer answers a request without some of its nodes, or doesn't
+    answer it in time, only those nodes are handed out again.
+
+    This class does no locking; the owning InboundLedger serializes calls.
+*/
+class LedgerFetchPipeline
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+    typedef Peer::ShortId PeerId;
+
+    /** A request to send to a peer. */
+    struct Request
+    {
+        PeerId peer;
+        std::vector <SHAMapNodeID> nodes;
+    };
+
+    /** Create a pipeline.
+        @param requestsPerPeer The number of requests kept in flight
+                               to each peer.
+    */
+    explicit LedgerFetchPipeline (int requestsPerPeer);
+
+    /** Return the number of missing nodes worth looking for.
+        This is enough to fill every request slot the peers have free,
+        plus the nodes already outstanding, which will be skipped.
+        Overdue requests are expired first.
+    */
+    std::size_t getWanted (std::vector <PeerId> const& peers,
+        clock_type::time_point now);
+
+    /** Assign missing nodes to the peers with room for another request.
+        Nodes already outstanding are skipped. Peers which have answered
+        the fastest are filled first.
+        @param peers The peers to use.
+        @param nodes The missing nodes, in the order they should be fetched.
+        @return The requests to send.
+    */
+    std::vector <Request> assign (std::vector <PeerId> const& peers,
+        std::vector <SHAMapNodeID> const& nodes, clock_type::time_point now);
+
+    /** Note a reply from a peer.
+        The nodes received are no longer outstanding, whichever peer they
+        were assigned to. The oldest request in flight to the peer which
+        asked for any of them is retired, and its answer time is used to
+        size the next request to that peer. A reply which matches no
+        request in flight only clears the nodes it holds.
+    */
+    void onReply (PeerId peer, std::vector <SHAMapNodeID> const& nodes,
+        clock_type::time_point now);
+
+    /** Forget every request in flight.
+        Used when the acquisition stalls, so that everything still
+        missing is requested again.
+    */
+    void reset ();
+
+    /** Return the number of nodes currently outstanding. */
+    std::size_t getOutstanding () const
+    {
+        return m_outstanding.size ();
+    }
+
+    /** Return the number of nodes the next request to a peer will hold. */
+    std::size_t getRequestSize (PeerId peer) const;
+
+private:
+    struct Sent
+    {
+        clock_type::time_point time;
+        std::vector <SHAMapNodeID> nodes;
+    };
+
+    struct PeerState
+    {
+        PeerState ();
+
+        std::deque <Sent> inFlight;
+        std::size_t requestSize;
+
+        // Smoothed time to answer a request, zero until the first answer
+        clock_type::duration latency;
+    };
+
+    PeerState& getPeer (PeerId peer);
+    clock_type::duration getTimeout (PeerState const& state) const;
+    void release (PeerId peer, Sent const& sent);
+    void expire (clock_type::time_point now);
+
+    std::size_t const m_requestsPerPeer;
+    std::map <PeerId, PeerState> m_peers;
+
+    // Which peer each outstanding node was requested from
+    std::map <SHAMapNodeID, PeerId> m_outstanding;
+};
+
+}
+
+#endif
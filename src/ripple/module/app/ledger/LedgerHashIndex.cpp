@@ -0,0 +1,287 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <beast/unit_test/suite.h>
+#include <fstream>
+
+namespace ripple {
+
+enum
+{
+    // Bytes used by each ledger
+    hashIndexSlotBytes = 32
+
+    // The file grows by this many ledgers at a time
+    ,hashIndexGrowLedgers = 65536
+};
+
+// Identifies the file; the rest of the header slot is zero
+static char const hashIndexMagic [] = "LedgerHashIndex1";
+
+LedgerHashIndex::LedgerHashIndex ()
+    : m_slots (0)
+{
+}
+
+LedgerHashIndex::~LedgerHashIndex ()
+{
+    if (isOpen ())
+        m_region.flush ();
+}
+
+void LedgerHashIndex::open (boost::filesystem::path const& path)
+{
+    std::lock_guard <std::mutex> lock (m_mutex);
+
+    m_path = path;
+    m_region = boost::interprocess::mapped_region ();
+
+    std::uint64_t size = 0;
+    bool valid = false;
+
+    if (boost::filesystem::exists (m_path))
+    {
+        size = boost::filesystem::file_size (m_path);
+
+        if ((size >= hashIndexSlotBytes) && ((size % hashIndexSlotBytes) == 0))
+        {
+            char header [hashIndexSlotBytes] = { 0 };
+            std::ifstream in (m_path.string ().c_str (), std::ios::binary);
+            in.read (header, sizeof (header));
+
+            valid = in && (std::memcmp (header, hashIndexMagic,
+                sizeof (hashIndexMagic)) == 0);
+        }
+
+        if (! valid)
+        {
+            WriteLog (lsWARNING, LedgerMaster) <<
+                "Ledger hash index " << m_path.string () << " is damaged, "
+                "starting over";
+        }
+    }
+
+    if (! valid)
+    {
+        create ();
+        return;
+    }
+
+    m_slots = size / hashIndexSlotBytes;
+    map ();
+}
+
+void LedgerHashIndex::clear ()
+{
+    std::lock_guard <std::mutex> lock (m_mutex);
+
+    if (! isOpen ())
+        return;
+
+    m_region = boost::interprocess::mapped_region ();
+    boost::interprocess::file_mapping ().swap (m_file);
+
+    try
+    {
+        create ();
+    }
+    catch (std::exception const& e)
+    {
+        WriteLog (lsWARNING, LedgerMaster) <<
+            "Closing ledger hash index: " << e.what ();
+        m_region = boost::interprocess::mapped_region ();
+    }
+}
+
+bool LedgerHashIndex::isOpen () const
+{
+    return m_region.get_address () != nullptr;
+}
+
+LedgerHash LedgerHashIndex::getHash (LedgerIndex ledgerIndex) const
+{
+    LedgerHash ledgerHash;
+
+    std::lock_guard <std::mutex> lock (m_mutex);
+
+    if (isOpen () && (ledgerIndex != 0) && (ledgerIndex < m_slots))
+    {
+        std::memcpy (ledgerHash.begin (),
+            static_cast <char const*> (m_region.get_address ()) +
+                std::uint64_t (ledgerIndex) * hashIndexSlotBytes,
+                    hashIndexSlotBytes);
+    }
+
+    return ledgerHash;
+}
+
+void LedgerHashIndex::setHash (LedgerIndex ledgerIndex,
+    LedgerHash const& ledgerHash)
+{
+    std::lock_guard <std::mutex> lock (m_mutex);
+
+    if (! isOpen () || (ledgerIndex == 0))
+        return;
+
+    try
+    {
+        if (ledgerIndex >= m_slots)
+            grow (ledgerIndex + 1);
+
+        std::memcpy (static_cast <char*> (m_region.get_address ()) +
+            std::uint64_t (ledgerIndex) * hashIndexSlotBytes,
+                ledgerHash.begin (), hashIndexSlotBytes);
+    }
+    catch (std::exception const& e)
+    {
+        // Lookups fall back to the other sources of ledger hashes
+        WriteLog (lsWARNING, LedgerMaster) <<
+            "Closing ledger hash index: " << e.what ();
+        m_region = boost::interprocess::mapped_region ();
+    }
+}
+
+// Write a table holding only the header, and map it
+void LedgerHashIndex::create ()
+{
+    char header [hashIndexSlotBytes] = { 0 };
+    std::memcpy (header, hashIndexMagic, sizeof (hashIndexMagic));
+
+    std::ofstream out (m_path.string ().c_str (),
+        std::ios::binary | std::ios::trunc);
+    out.write (header, sizeof (header));
+    out.close ();
+
+    if (! out)
+        throw std::runtime_error ("unable to create " + m_path.string ());
+
+    m_slots = 1;
+    map ();
+}
+
+void LedgerHashIndex::grow (std::uint64_t slots)
+{
+    slots = ((slots + hashIndexGrowLedgers - 1) / hashIndexGrowLedgers) *
+        hashIndexGrowLedgers;
+
+    m_region.flush ();
+    m_region = boost::interprocess::mapped_region ();
+    boost::interprocess::file_mapping ().swap (m_file);
+
+    boost::filesystem::resize_file (m_path, slots * hashIndexSlotBytes);
+    m_slots = slots;
+    map ();
+}
+
+void LedgerHashIndex::map ()
+{
+    using namespace boost::interprocess;
+
+    file_mapping file (m_path.string ().c_str (), read_write);
+    mapped_region region (file, read_write);
+
+    m_file.swap (file);
+    m_region.swap (region);
+}
+
+//------------------------------------------------------------------------------
+
+class LedgerHashIndex_test : public beast::unit_test::suite
+{
+public:
+    static LedgerHash makeHash (int i)
+    {
+        Serializer s;
+        s.add32 (i);
+        return s.getSHA512Half ();
+    }
+
+    void run ()
+    {
+        beast::File const file (beast::File::createTempFile ("ledger_hashes"));
+        boost::filesystem::path const path (
+            file.getFullPathName ().toStdString ());
+
+        {
+            LedgerHashIndex index;
+            expect (! index.isOpen ());
+            expect (index.getHash (5).isZero ());
+
+            index.open (path);
+            expect (index.isOpen ());
+            expect (index.getHash (5).isZero ());
+
+            // Storing a high sequence grows the file
+            index.setHash (5, makeHash (5));
+            index.setHash (100000, makeHash (100000));
+            expect (index.getHash (5) == makeHash (5));
+            expect (index.getHash (100000) == makeHash (100000));
+            expect (index.getHash (6).isZero ());
+            expect (index.getHash (1000000).isZero ());
+
+            // Slot zero holds the header
+            index.setHash (0, makeHash (0));
+            expect (index.getHash (0).isZero ());
+        }
+
+        {
+            // The hashes are still there after reopening
+            LedgerHashIndex index;
+            index.open (path);
+            expect (index.getHash (5) == makeHash (5));
+            expect (index.getHash (100000) == makeHash (100000));
+
+            index.setHash (5, makeHash (6));
+            expect (index.getHash (5) == makeHash (6));
+        }
+
+        {
+            // Clearing leaves an empty table which can still be used
+            LedgerHashIndex index;
+            index.open (path);
+            index.clear ();
+            expect (index.isOpen ());
+            expect (index.getHash (5).isZero ());
+            expect (index.getHash (100000).isZero ());
+
+            index.setHash (100000, makeHash (100000));
+            expect (index.getHash (100000) == makeHash (100000));
+        }
+
+        {
+            // A file which isn't a table is started over
+            std::ofstream out (path.string ().c_str (),
+                std::ios::binary | std::ios::trunc);
+            out << "not a ledger hash index, not at all";
+        }
+
+        {
+            LedgerHashIndex index;
+            index.open (path);
+            expect (index.isOpen ());
+            expect (index.getHash (5).isZero ());
+        }
+
+        file.deleteFile ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(LedgerHashIndex,ripple_app,ripple);
+
+}
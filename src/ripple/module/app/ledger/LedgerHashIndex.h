@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_LEDGERHASHINDEX_H_INCLUDED
+#define RIPPLE_LEDGERHASHINDEX_H_INCLUDED
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem.hpp>
+#include <mutex>
+
+namespace ripple {
+
+/** A persistent table of validated ledger hashes, indexed by sequence.
+
+    The table is a memory mapped file holding 32 bytes for each ledger
+    sequence, so a hash is found with a single array lookup however much
+    history the server has. Sequences with no known hash read as zero.
+    The first slot, which no ledger uses, holds the file header.
+
+    The file grows as higher sequences are stored. Lookups and updates
+    can be called concurrently.
+*/
+class LedgerHashIndex
+{
+public:
+    LedgerHashIndex ();
+
+    LedgerHashIndex (LedgerHashIndex const&) = delete;
+    LedgerHashIndex& operator= (LedgerHashIndex const&) = delete;
+
+    ~LedgerHashIndex ();
+
+    /** Open the table, creating it if needed.
+        A file which isn't a valid table is started over.
+        @throws std::exception if the file can't be opened or mapped.
+    */
+    void open (boost::filesystem::path const& path);
+
+    /** Discard every hash, leaving an empty table.
+        Has no effect if the table isn't open.
+    */
+    void clear ();
+
+    /** Returns `true` if the table is open. */
+    bool isOpen () const;
+
+    /** Return the hash of the ledger with the given sequence.
+        @return The hash, or zero if it isn't known or the table isn't open.
+    */
+    LedgerHash getHash (LedgerIndex ledgerIndex) const;
+
+    /** Record the hash of the ledger with the given sequence.
+        Has no effect if the table isn't open.
+    */
+    void setHash (LedgerIndex ledgerIndex, LedgerHash const& ledgerHash);
+
+private:
+    void create ();
+    void grow (std::uint64_t slots);
+    void map ();
+
+    std::mutex mutable m_mutex;
+    boost::filesystem::path m_path;
+    boost::interprocess::file_mapping m_file;
+    boost::interprocess::mapped_region m_region;
+
+    // Number of slots in the file, including the header
+    std::uint64_t m_slots;
+};
+
+}
+
+#endif
@@ -39,6 +39,66 @@ LedgerHistory::LedgerHistory ()
 {
 }
 
+void LedgerHistory::openHashIndex ()
+{
+    // A standalone server starts a new chain each run
+    if (getConfig ().RUN_STANDALONE || getConfig ().DATA_DIR.empty ())
+        return;
+
+    try
+    {
+        m_hashIndex.open (getConfig ().DATA_DIR / "ledger_hashes");
+    }
+    catch (std::exception const& e)
+    {
+        WriteLog (lsWARNING, LedgerMaster) <<
+            "Unable to open ledger hash index: " << e.what ();
+        return;
+    }
+
+    // The table outlives the process and may have been left behind by a
+    // different ledger database. Compare the newest ledgers the database
+    // has with the table, and only keep the table if they agree.
+    int matched = 0;
+    int mismatched = 0;
+
+    {
+        DatabaseCon* con = getApp().getLedgerDB ();
+        auto sl (con->lock ());
+
+        SqliteStatement pSt (con->getDB ()->getSqliteDB (),
+            "SELECT LedgerSeq,LedgerHash FROM Ledgers "
+                "ORDER BY LedgerSeq DESC LIMIT 256;");
+
+        while (pSt.isRow (pSt.step ()))
+        {
+            uint256 const indexedHash (m_hashIndex.getHash (pSt.getUInt32 (0)));
+
+            // The table may lag the database after a crash
+            if (indexedHash.isZero ())
+                continue;
+
+            uint256 hash;
+            hash.SetHexExact (pSt.peekString (1));
+
+            if (hash == indexedHash)
+                ++matched;
+            else
+                ++mismatched;
+        }
+    }
+
+    if (mismatched != 0)
+    {
+        WriteLog (lsWARNING, LedgerMaster) <<
+            "Ledger hash index does not match the ledger database, "
+            "starting over";
+    }
+
+    if ((matched == 0) || (mismatched != 0))
+        m_hashIndex.clear ();
+}
+
 bool LedgerHistory::addLedger (Ledger::pointer ledger, bool validated)
 {
     assert (ledger && ledger->isImmutable ());
@@ -48,20 +108,26 @@ bool LedgerHistory::addLedger (Ledger::pointer ledger, bool validated)
 
     const bool alreadyHad = m_ledgers_by_hash.canonicalize (ledger->getHash(), ledger, true);
     if (validated)
+    {
         mLedgersByIndex[ledger->getLedgerSeq()] = ledger->getHash();
+        m_hashIndex.setHash (ledger->getLedgerSeq(), ledger->getHash());
+    }
 
     return alreadyHad;
 }
 
 uint256 LedgerHistory::getLedgerHash (std::uint32_t index)
 {
-    LedgersByHash::ScopedLockType sl (m_ledgers_by_hash.peekMutex ());
-    std::map<std::uint32_t, uint256>::iterator it (mLedgersByIndex.find (index));
+    {
+        LedgersByHash::ScopedLockType sl (m_ledgers_by_hash.peekMutex ());
+        std::map<std::uint32_t, uint256>::iterator it (mLedgersByIndex.find (index));
 
-    if (it != mLedgersByIndex.end ())
-        return it->second;
+        if (it != mLedgersByIndex.end ())
+            return it->second;
+    }
 
-    return uint256 ();
+    // Checked against the ledger database when it was opened
+    return m_hashIndex.getHash (index);
 }
 
 Ledger::pointer LedgerHistory::getLedgerBySeq (std::uint32_t index)
@@ -78,7 +144,24 @@ Ledger::pointer LedgerHistory::getLedgerBySeq (std::uint32_t index)
         }
     }
 
-    Ledger::pointer ret (Ledger::loadByIndex (index));
+    Ledger::pointer ret;
+    uint256 const indexedHash (m_hashIndex.getHash (index));
+
+    if (indexedHash.isNonZero ())
+    {
+        ret = getLedgerByHash (indexedHash);
+
+        if (ret && (ret->getLedgerSeq () != index))
+        {
+            WriteLog (lsWARNING, LedgerMaster) <<
+                "Ledger hash index has wrong hash for " << index;
+            m_hashIndex.setHash (index, uint256 ());
+            ret.reset ();
+        }
+    }
+
+    if (!ret)
+        ret = Ledger::loadByIndex (index);
 
     if (!ret)
         return ret;
@@ -92,6 +175,7 @@ Ledger::pointer LedgerHistory::getLedgerBySeq (std::uint32_t index)
         assert (ret->isImmutable ());
         m_ledgers_by_hash.canonicalize (ret->getHash (), ret);
         mLedgersByIndex[ret->getLedgerSeq ()] = ret->getHash ();
+        m_hashIndex.setHash (ret->getLedgerSeq (), ret->getHash ());
         return (ret->getLedgerSeq () == index) ? ret : Ledger::pointer ();
     }
 }
@@ -177,12 +261,25 @@ bool LedgerHistory::fixIndex (LedgerIndex ledgerIndex, LedgerHash const& ledgerH
     LedgersByHash::ScopedLockType sl (m_ledgers_by_hash.peekMutex ());
     std::map<std::uint32_t, uint256>::iterator it (mLedgersByIndex.find (ledgerIndex));
 
+    bool ret = true;
+
     if ((it != mLedgersByIndex.end ()) && (it->second != ledgerHash) )
     {
         it->second = ledgerHash;
-        return false;
+        ret = false;
     }
-    return true;
+
+    LedgerHash const indexedHash (m_hashIndex.getHash (ledgerIndex));
+
+    if (indexedHash != ledgerHash)
+    {
+        m_hashIndex.setHash (ledgerIndex, ledgerHash);
+
+        if (indexedHash.isNonZero ())
+            ret = false;
+    }
+
+    return ret;
 }
 
 void LedgerHistory::tune (int size, int age)
@@ -30,6 +30,12 @@ class LedgerHistory : beast::LeakChecked <LedgerHistory>
 public:
     LedgerHistory ();
 
+    /** Open the persistent table of ledger hashes.
+        This must be called after the ledger database is open. The table
+        is checked against the database, and started over if they differ.
+    */
+    void openHashIndex ();
+
     /** Track a ledger
         @return `true` if the ledger was already tracked
     */
@@ -105,6 +111,9 @@ private:
 
     // Maps ledger indexes to the corresponding hash.
     std::map <LedgerIndex, LedgerHash> mLedgersByIndex; // validated ledgers
+
+    // Persistent copy of the above covering all of history
+    LedgerHashIndex m_hashIndex;
 };
 
 } // ripple
@@ -1292,6 +1292,11 @@ public:
         mMinValidations = v;
     }
 
+    void openHashIndex ()
+    {
+        mLedgerHistory.openHashIndex ();
+    }
+
     std::string getCompleteLedgers ()
     {
         ScopedLockType sl (mCompleteLock);
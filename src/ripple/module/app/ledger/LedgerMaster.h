@@ -76,6 +76,11 @@ public:
 
     virtual void setMinValidations (int v) = 0;
 
+    /** Open the persistent table of ledger hashes.
+        Call once the ledger database is open, it is used to check the table.
+    */
+    virtual void openHashIndex () = 0;
+
     virtual std::uint32_t getEarliestFetch () = 0;
 
     virtual void pushLedger (Ledger::pointer newLedger) = 0;
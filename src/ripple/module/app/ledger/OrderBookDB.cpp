@@ -22,6 +22,7 @@ namespace ripple {
 OrderBookDB::OrderBookDB (Stoppable& parent)
     : Stoppable ("OrderBookDB", parent)
     , mSeq (0)
+    , mRebuilding (false)
 {
 }
 
@@ -37,21 +38,19 @@ void OrderBookDB::setup (Ledger::ref ledger)
         ScopedLockType sl (mLock);
         auto seq = ledger->getLedgerSeq ();
 
-        // Do a full update every 256 ledgers
-        if (mSeq != 0)
-        {
-            if (seq == mSeq)
-                return;
-            if ((seq > mSeq) && ((seq - mSeq) < 256))
-                return;
-            if ((seq < mSeq) && ((mSeq - seq) < 16))
-                return;
-        }
+        // Newer ledgers are applied incrementally by applyLedger, so a
+        // full scan is only needed when the index is missing or has a gap.
+        if (mRebuilding)
+            return;
+
+        if ((mSeq != 0) && (seq <= mSeq) && ((mSeq - seq) < 16))
+            return;
 
         WriteLog (lsDEBUG, OrderBookDB)
-            << "Advancing from " << mSeq << " to " << seq;
+            << "Rebuilding from " << mSeq << " at " << seq;
 
-        mSeq = seq;
+        mRebuilding = true;
+        mPending.clear ();
     }
 
     if (getConfig().RUN_STANDALONE)
@@ -61,39 +60,52 @@ void OrderBookDB::setup (Ledger::ref ledger)
             std::bind(&OrderBookDB::update, this, ledger));
 }
 
+// Describe the book of a quality directory. Fields left out of
+// metadata because they are zero are taken as zero.
+static Book getBookFromFields (STObject const& fields)
+{
+    auto h160 = [&fields] (SField::ref field)
+    {
+        return fields.isFieldPresent (field) ?
+            fields.getFieldH160 (field) : uint160 ();
+    };
+
+    Book book;
+    book.in.currency.copyFrom (h160 (sfTakerPaysCurrency));
+    book.in.account.copyFrom (h160 (sfTakerPaysIssuer));
+    book.out.account.copyFrom (h160 (sfTakerGetsIssuer));
+    book.out.currency.copyFrom (h160 (sfTakerGetsCurrency));
+    return book;
+}
+
 static void updateHelper (SLE::ref entry,
-    hash_set< uint256 >& seen,
+    hash_map< uint256, OrderBook::pointer >& books,
     OrderBookDB::IssueToOrderBook& destMap,
     OrderBookDB::IssueToOrderBook& sourceMap,
-    hash_set< Issue >& XRPBooks,
-    int& books)
+    hash_set< Issue >& XRPBooks)
 {
     if (entry->getType () == ltDIR_NODE &&
         entry->isFieldPresent (sfExchangeRate) &&
         entry->getFieldH256 (sfRootIndex) == entry->getIndex())
     {
-        Book book;
-        book.in.currency.copyFrom (entry->getFieldH160 (sfTakerPaysCurrency));
-        book.in.account.copyFrom (entry->getFieldH160 (sfTakerPaysIssuer));
-        book.out.account.copyFrom (entry->getFieldH160 (sfTakerGetsIssuer));
-        book.out.currency.copyFrom (entry->getFieldH160 (sfTakerGetsCurrency));
+        Book const book (getBookFromFields (*entry));
 
         uint256 index = Ledger::getBookBase (book);
-        if (seen.insert (index).second)
+        if (books.find (index) == books.end ())
         {
             auto orderBook = std::make_shared<OrderBook> (index, book);
+            books.emplace (index, orderBook);
             sourceMap[book.in].push_back (orderBook);
             destMap[book.out].push_back (orderBook);
             if (isXRP(book.out))
                 XRPBooks.insert(book.in);
-            ++books;
         }
     }
 }
 
 void OrderBookDB::update (Ledger::pointer ledger)
 {
-    hash_set< uint256 > seen;
+    hash_map< uint256, OrderBook::pointer > books;
     OrderBookDB::IssueToOrderBook destMap;
     OrderBookDB::IssueToOrderBook sourceMap;
     hash_set< Issue > XRPBooks;
@@ -101,13 +113,11 @@ void OrderBookDB::update (Ledger::pointer ledger)
     WriteLog (lsDEBUG, OrderBookDB) << "OrderBookDB::update>";
 
     // walk through the entire ledger looking for orderbook entries
-    int books = 0;
-
     try
     {
         ledger->visitStateItems(std::bind(&updateHelper, std::placeholders::_1,
-                                          std::ref(seen), std::ref(destMap),
-            std::ref(sourceMap), std::ref(XRPBooks), std::ref(books)));
+            std::ref(books), std::ref(destMap),
+            std::ref(sourceMap), std::ref(XRPBooks)));
     }
     catch (const SHAMapMissingNode&)
     {
@@ -115,56 +125,204 @@ void OrderBookDB::update (Ledger::pointer ledger)
             << "OrderBookDB::update encountered a missing node";
         ScopedLockType sl (mLock);
         mSeq = 0;
+        mRebuilding = false;
+        mPending.clear ();
         return;
     }
 
     WriteLog (lsDEBUG, OrderBookDB)
-        << "OrderBookDB::update< " << books << " books found";
+        << "OrderBookDB::update< " << books.size () << " books found";
     {
         ScopedLockType sl (mLock);
 
+        mBooks.swap(books);
         mXRPBooks.swap(XRPBooks);
         mSourceMap.swap(sourceMap);
         mDestMap.swap(destMap);
+
+        // An open ledger holds the state of the ledger before it
+        mSeq = ledger->getLedgerSeq ();
+        if (!ledger->isClosed ())
+            --mSeq;
+
+        mRebuilding = false;
+
+        // Catch up with the ledgers published during the scan
+        for (auto const& pending : mPending)
+        {
+            std::uint32_t const seq = pending->getLedgerSeq ();
+
+            if (seq <= mSeq)
+                continue;
+
+            if ((seq != mSeq + 1) || !applyDeltas (*pending))
+            {
+                // The next published ledger will start a new rebuild
+                mSeq = 0;
+                break;
+            }
+
+            mSeq = seq;
+        }
+
+        mPending.clear ();
     }
     getApp().getLedgerMaster().newOrderBookDB();
 }
 
-void OrderBookDB::addOrderBook(Book const& book)
+void OrderBookDB::applyLedger (AcceptedLedger::pointer const& ledger)
 {
-    bool toXRP = isXRP (book.out);
-    ScopedLockType sl (mLock);
+    std::uint32_t const seq = ledger->getLedgerSeq ();
 
-    if (toXRP)
     {
-        // We don't want to search through all the to-XRP or from-XRP order
-        // books!
-        for (auto ob: mSourceMap[book.in])
+        ScopedLockType sl (mLock);
+
+        if (mRebuilding)
         {
-            if (isXRP (ob->getCurrencyOut ())) // also to XRP
-                return;
+            mPending.push_back (ledger);
+            return;
         }
+
+        if ((mSeq != 0) && (seq <= mSeq))
+            return;
+
+        if ((mSeq != 0) && (seq == mSeq + 1) && applyDeltas (*ledger))
+        {
+            mSeq = seq;
+            return;
+        }
+
+        WriteLog (lsDEBUG, OrderBookDB)
+            << "Cannot advance from " << mSeq << " to " << seq;
+
+        mSeq = 0;
     }
-    else
+
+    setup (ledger->getLedger ());
+}
+
+bool OrderBookDB::applyDeltas (AcceptedLedger const& ledger)
+{
+    std::vector <Book> created;
+    std::vector <Book> deleted;
+
+    for (auto const& item : ledger.getMap ())
     {
-        for (auto ob: mDestMap[book.out])
+        for (auto& node : item.second->getMeta ()->getNodes ())
         {
-            if (ob->getCurrencyIn() == book.in.currency &&
-                ob->getIssuerIn() == book.in.account)
-            {
-                return;
-            }
+            if (node.getFieldU16 (sfLedgerEntryType) != ltDIR_NODE)
+                continue;
+
+            bool const isCreated = (node.getFName () == sfCreatedNode);
+
+            if (!isCreated && (node.getFName () != sfDeletedNode))
+                continue;
+
+            auto fields = dynamic_cast <STObject const*> (node.peekAtPField (
+                isCreated ? sfNewFields : sfFinalFields));
+
+            // Only the root of a quality directory describes a book
+            if (!fields ||
+                !fields->isFieldPresent (sfExchangeRate) ||
+                !fields->isFieldPresent (sfRootIndex) ||
+                (fields->getFieldH256 (sfRootIndex) !=
+                    node.getFieldH256 (sfLedgerIndex)))
+                continue;
+
+            if (isCreated)
+                created.push_back (getBookFromFields (*fields));
+            else
+                deleted.push_back (getBookFromFields (*fields));
+        }
+    }
+
+    try
+    {
+        for (auto const& book : deleted)
+        {
+            // The book is gone when none of its quality directories are left
+            uint256 const base = Ledger::getBookBase (book);
+
+            if (ledger.getLedger ()->getNextLedgerIndex (
+                    base, Ledger::getQualityNext (base)).isZero ())
+                rawRemoveBook (base);
         }
     }
+    catch (const SHAMapMissingNode&)
+    {
+        WriteLog (lsINFO, OrderBookDB)
+            << "OrderBookDB::applyDeltas encountered a missing node";
+        return false;
+    }
+
+    for (auto const& book : created)
+        rawAddBook (book);
+
+    if (!created.empty () || !deleted.empty ())
+    {
+        WriteLog (lsDEBUG, OrderBookDB) << "Ledger " << ledger.getLedgerSeq ()
+            << " created " << created.size () << " and deleted "
+            << deleted.size () << " book directories";
+    }
+
+    return true;
+}
+
+void OrderBookDB::addOrderBook(Book const& book)
+{
+    ScopedLockType sl (mLock);
+    rawAddBook (book);
+}
+
+void OrderBookDB::rawAddBook (Book const& book)
+{
     uint256 index = Ledger::getBookBase(book);
+
+    if (mBooks.find (index) != mBooks.end ())
+        return;
+
     auto orderBook = std::make_shared<OrderBook> (index, book);
 
+    mBooks.emplace (index, orderBook);
     mSourceMap[book.in].push_back (orderBook);
     mDestMap[book.out].push_back (orderBook);
-    if (toXRP)
+    if (isXRP (book.out))
         mXRPBooks.insert(book.in);
 }
 
+void OrderBookDB::rawRemoveBook (uint256 const& bookBase)
+{
+    auto it = mBooks.find (bookBase);
+
+    if (it == mBooks.end ())
+        return;
+
+    OrderBook::pointer const orderBook = it->second;
+    Book const& book = orderBook->book ();
+    mBooks.erase (it);
+
+    auto removeFrom = [&orderBook] (IssueToOrderBook& map, Issue const& issue)
+    {
+        auto list = map.find (issue);
+
+        if (list == map.end ())
+            return;
+
+        list->second.erase (std::remove (list->second.begin (),
+            list->second.end (), orderBook), list->second.end ());
+
+        if (list->second.empty ())
+            map.erase (list);
+    };
+
+    removeFrom (mSourceMap, book.in);
+    removeFrom (mDestMap, book.out);
+
+    // There is only one book from an issue to XRP
+    if (isXRP (book.out))
+        mXRPBooks.erase (book.in);
+}
+
 // return list of all orderbooks that want this issuerID and currencyID
 OrderBook::List OrderBookDB::getBooksByTakerPays (Issue const& issue)
 {
@@ -216,12 +374,19 @@ BookListeners::pointer OrderBookDB::getBookListeners (Book const& book)
 // Based on the meta, send the meta to the streams that are listening.
 // We need to determine which streams a given meta effects.
 void OrderBookDB::processTxn (
-    Ledger::ref ledger, const AcceptedLedgerTx& alTx, Json::Value const& jvObj)
+    Ledger::ref ledger, const AcceptedLedgerTx& alTx,
+    Json::Value const& jvObj, std::string const& sObj)
 {
-    ScopedLockType sl (mLock);
+    if (alTx.getResult () != tesSUCCESS)
+        return;
+
+    // A transaction can touch several offers in the same book, but the
+    // book's listeners only need to hear about it once.
+    hash_set <BookListeners::pointer> books;
 
-    if (alTx.getResult () == tesSUCCESS)
     {
+        ScopedLockType sl (mLock);
+
         // Check if this is an offer or an offer cancel or a payment that
         // consumes an offer.
         // Check to see what the meta looks like.
@@ -255,7 +420,7 @@ void OrderBookDB::processTxn (
                                  data->getFieldAmount (sfTakerPays).issue()});
 
                             if (listeners)
-                                listeners->publish (jvObj);
+                                books.insert (listeners);
                         }
                     }
                 }
@@ -267,6 +432,9 @@ void OrderBookDB::processTxn (
             }
         }
     }
+
+    for (auto const& listeners : books)
+        listeners->publish (jvObj, sObj);
 }
 
 } // ripple
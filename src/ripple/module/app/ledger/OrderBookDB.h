@@ -31,8 +31,21 @@ class OrderBookDB
 public:
     explicit OrderBookDB (Stoppable& parent);
 
+    /** Rebuild the book index from a ledger if it is missing or stale.
+        The rebuild scans the whole state map and runs on the job queue.
+    */
     void setup (Ledger::ref ledger);
+
+    /** Scan every entry in a ledger for order books. */
     void update (Ledger::pointer ledger);
+
+    /** Bring the book index forward to a newly published ledger.
+        Books whose directories the ledger's transactions created or
+        deleted are added or removed. If the index is not at the
+        previous ledger a full rebuild is started instead.
+    */
+    void applyLedger (AcceptedLedger::pointer const& ledger);
+
     void invalidate ();
 
     void addOrderBook(Book const&);
@@ -53,12 +66,18 @@ public:
     // see if this txn effects any orderbook
     void processTxn (
         Ledger::ref ledger, const AcceptedLedgerTx& alTx,
-        Json::Value const& jvObj);
+        Json::Value const& jvObj, std::string const& sObj);
 
     typedef hash_map <Issue, OrderBook::List> IssueToOrderBook;
 
 private:
-    void rawAddBook(Book const&);
+    // These require that mLock is held
+    void rawAddBook (Book const&);
+    void rawRemoveBook (uint256 const& bookBase);
+    bool applyDeltas (AcceptedLedger const& ledger);
+
+    // by book base
+    hash_map <uint256, OrderBook::pointer> mBooks;
 
     // by ci/ii
     IssueToOrderBook mSourceMap;
@@ -78,7 +97,12 @@ private:
 
     BookToListenersMap mListeners;
 
+    // The ledger the index reflects, 0 if there is no usable index
     std::uint32_t mSeq;
+
+    // Ledgers published while a rebuild is running, applied after it
+    bool mRebuilding;
+    std::vector <AcceptedLedger::pointer> mPending;
 };
 
 } // ripple
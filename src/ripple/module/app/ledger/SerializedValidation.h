@@ -88,6 +88,21 @@ public:
     }
 
 private:
+    SerializedValidation* duplicate () const
+    {
+        return new SerializedValidation (*this);
+    }
+
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
+
     static SOTemplate const& getFormat ();
 
     void setNode ();
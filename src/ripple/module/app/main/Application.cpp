@@ -155,6 +155,7 @@ public:
     std::unique_ptr <CollectorManager> m_collectorManager;
     std::unique_ptr <Resource::Manager> m_resourceManager;
     std::unique_ptr <FullBelowCache> m_fullBelowCache;
+    FullBelowCache::clock_type::time_point m_fullBelowSaved;
 
     // These are Stoppable-related
     NodeStoreScheduler m_nodeStoreScheduler;
@@ -178,6 +179,7 @@ public:
     std::unique_ptr <AmendmentTable> m_amendmentTable;
     std::unique_ptr <LoadFeeTrack> mFeeTrack;
     std::unique_ptr <IHashRouter> mHashRouter;
+    std::unique_ptr <SignatureVerifier> m_signatureVerifier;
     std::unique_ptr <Validations> mValidations;
     std::unique_ptr <ProofOfWorkFactory> mProofOfWorkFactory;
     std::unique_ptr <LoadManager> m_loadManager;
@@ -326,6 +328,9 @@ public:
 
         , mHashRouter (IHashRouter::New (IHashRouter::getDefaultHoldTime ()))
 
+        , m_signatureVerifier (make_SignatureVerifier (*m_jobQueue,
+            *mHashRouter, m_logs.journal("SignatureVerifier")))
+
         , mValidations (Validations::New ())
 
         , mProofOfWorkFactory (ProofOfWorkFactory::New ())
@@ -451,6 +456,11 @@ public:
         return m_masterMutex;
     }
 
+    SignatureVerifier& getSignatureVerifier ()
+    {
+        return *m_signatureVerifier;
+    }
+
     LoadManager& getLoadManager ()
     {
         return *m_loadManager;
@@ -644,6 +654,7 @@ public:
         Pathfinder::initPathTable ();
 
         m_ledgerMaster->setMinValidations (getConfig ().VALIDATION_QUORUM);
+        m_ledgerMaster->openHashIndex ();
 
         auto const startUp = getConfig ().START_UP;
         if (startUp == Config::FRESH)
@@ -702,6 +713,8 @@ public:
         m_treeNodeCache.setTargetSize (getConfig ().getSize (siTreeCacheSize));
         m_treeNodeCache.setTargetAge (getConfig ().getSize (siTreeCacheAge));
 
+        if (getConfig ().FULL_BELOW_PERSIST)
+            loadFullBelowCache ();
 
         //----------------------------------------------------------------------
         //
@@ -911,6 +924,9 @@ public:
 
         m_sweepTimer.cancel ();
 
+        if (getConfig ().FULL_BELOW_PERSIST)
+            saveFullBelowCache ();
+
         // VFALCO TODO get rid of this flag
         mShutdown = true;
 
@@ -1034,6 +1050,134 @@ public:
         }
     }
 
+    //--------------------------------------------------------------------------
+    //
+    // The full below cache is saved as a marker, the name of the node store
+    // it was built against, then the keys. A file saved against a different
+    // node store is ignored.
+    //
+
+    static char const* getFullBelowMarker ()
+    {
+        return "FULLBLW1";
+    }
+
+    boost::filesystem::path getFullBelowPath () const
+    {
+        return getConfig ().DATA_DIR / "full_below";
+    }
+
+    void loadFullBelowCache ()
+    {
+        m_fullBelowSaved = m_fullBelowCache->clock ().now ();
+
+        std::ifstream in (getFullBelowPath ().string ().c_str (), std::ios::binary);
+
+        if (! in)
+            return;
+
+        char marker [8];
+        std::uint32_t nameSize (0);
+        std::uint64_t count (0);
+
+        in.read (marker, sizeof (marker));
+        in.read (reinterpret_cast <char*> (&nameSize), sizeof (nameSize));
+
+        std::string name (std::min <std::uint32_t> (nameSize, 4096), '\0');
+        in.read (&name [0], name.size ());
+        in.read (reinterpret_cast <char*> (&count), sizeof (count));
+
+        if (! in || std::memcmp (marker, getFullBelowMarker (), sizeof (marker)) != 0 ||
+            name != m_nodeStore->getName ().toStdString ())
+        {
+            m_journal.warning << "Ignoring saved full below cache " <<
+                getFullBelowPath ().string ();
+            return;
+        }
+
+        auto keys (std::make_shared <std::vector <uint256>> ());
+        keys->reserve (std::min <std::uint64_t> (count, fullBelowTargetSize));
+
+        uint256 key;
+        while (keys->size () < count &&
+            in.read (reinterpret_cast <char*> (key.begin ()), key.size ()))
+        {
+            keys->push_back (key);
+        }
+
+        m_journal.info << "Loaded " << keys->size () << " full below keys";
+
+        if (! keys->empty ())
+            m_jobQueue->addJob (jtSWEEP, "FullBelowCache::load", std::bind (
+                &ApplicationImp::checkFullBelowKeys, this,
+                    std::placeholders::_1, keys, 0));
+    }
+
+    // A loaded key is trusted once its own node is found in the node store.
+    // The keys are checked a batch at a time, each batch in its own job, and
+    // go into the cache as they pass.
+    void checkFullBelowKeys (Job&,
+        std::shared_ptr <std::vector <uint256>> const& keys, std::size_t first)
+    {
+        std::size_t const last (std::min <std::size_t> (
+            keys->size (), first + fullBelowCheckBatchSize));
+        std::vector <uint256> const batch (
+            keys->begin () + first, keys->begin () + last);
+        std::vector <NodeObject::pointer> const objects (
+            m_nodeStore->fetchBatch (batch));
+
+        for (std::size_t i = 0; i < batch.size (); ++i)
+        {
+            if (objects [i] != nullptr)
+                m_fullBelowCache->insert (batch [i]);
+        }
+
+        if ((last < keys->size ()) && ! m_jobQueue->isStopping ())
+            m_jobQueue->addJob (jtSWEEP, "FullBelowCache::load", std::bind (
+                &ApplicationImp::checkFullBelowKeys, this,
+                    std::placeholders::_1, keys, last));
+    }
+
+    void saveFullBelowCache ()
+    {
+        m_fullBelowSaved = m_fullBelowCache->clock ().now ();
+
+        std::vector <uint256> const keys (m_fullBelowCache->getKeys ());
+        std::string const name (m_nodeStore->getName ().toStdString ());
+        std::uint32_t const nameSize (name.size ());
+        std::uint64_t const count (keys.size ());
+
+        boost::filesystem::path const path (getFullBelowPath ());
+        boost::filesystem::path const temp (path.string () + ".tmp");
+
+        {
+            std::ofstream out (temp.string ().c_str (),
+                std::ios::binary | std::ios::trunc);
+
+            out.write (getFullBelowMarker (), 8);
+            out.write (reinterpret_cast <char const*> (&nameSize), sizeof (nameSize));
+            out.write (name.data (), name.size ());
+            out.write (reinterpret_cast <char const*> (&count), sizeof (count));
+
+            for (auto const& key : keys)
+                out.write (reinterpret_cast <char const*> (key.begin ()), key.size ());
+
+            if (! out)
+            {
+                m_journal.warning << "Unable to write " << temp.string ();
+                return;
+            }
+        }
+
+        // Replace the old file only once the new one is complete
+        boost::system::error_code ec;
+        boost::filesystem::rename (temp, path, ec);
+
+        if (ec)
+            m_journal.warning << "Unable to replace " << path.string () <<
+                ": " << ec.message ();
+    }
+
     void doSweep (Job& j)
     {
         // VFALCO NOTE Does the order of calls matter?
@@ -1043,6 +1187,14 @@ public:
 
         m_fullBelowCache->sweep ();
 
+        if (getConfig ().FULL_BELOW_PERSIST &&
+            (m_fullBelowCache->clock ().now () - m_fullBelowSaved >=
+                std::chrono::seconds (fullBelowSaveSeconds)))
+        {
+            logTimedCall (m_journal.warning, "FullBelowCache::save", __FILE__, __LINE__,
+                std::bind (&ApplicationImp::saveFullBelowCache, this));
+        }
+
         logTimedCall (m_journal.warning, "TransactionMaster::sweep", __FILE__, __LINE__, std::bind (
             &TransactionMaster::sweep, &m_txMaster));
 
@@ -1503,6 +1655,73 @@ static void addTxnSeqField ()
     db->executeSQL ("END TRANSACTION;");
 }
 
+static void convertAccountField ()
+{
+    // Accounts used to be stored as base58 text
+    if (!schemaHas (getApp().getTxnDB (), "AccountTransactions", 0, "Account     CHARACTER"))
+        return;
+
+    WriteLog (lsWARNING, Application) << "Converting AccountTransactions accounts to binary";
+
+    Database* db = getApp().getTxnDB ()->getDB ();
+
+    db->executeSQL ("BEGIN TRANSACTION;");
+
+    // Map each distinct account to its binary form, then let SQLite copy
+    // the rows across through the map.
+    db->executeSQL ("CREATE TEMP TABLE AccountMap (Human TEXT PRIMARY KEY, ID BLOB);");
+
+    {
+        SqliteStatement insert (db->getSqliteDB (),
+            "INSERT INTO AccountMap (Human, ID) VALUES (?, ?);");
+
+        std::vector <std::string> humans;
+
+        SQL_FOREACH (db, "SELECT DISTINCT Account FROM AccountTransactions;")
+        {
+            std::string human;
+            db->getStr ("Account", human);
+            humans.push_back (human);
+        }
+
+        WriteLog (lsINFO, Application) << humans.size () << " accounts found";
+
+        for (auto const& human : humans)
+        {
+            RippleAddress address;
+
+            if (!address.setAccountID (human))
+            {
+                WriteLog (lsWARNING, Application) << "Dropping bad account " << human;
+                continue;
+            }
+
+            Account const id (address.getAccountID ());
+
+            insert.bind (1, human);
+            insert.bind (2, id.begin (), id.size ());
+            insert.step ();
+            insert.reset ();
+        }
+    }
+
+    WriteLog (lsINFO, Application) << "Copying rows";
+    db->executeSQL ("ALTER TABLE AccountTransactions RENAME TO AccountTransactionsOld;");
+    db->executeSQL ("CREATE TABLE AccountTransactions (TransID CHARACTER(64), "
+        "Account BLOB, LedgerSeq BIGINT UNSIGNED, TxnSeq INTEGER);");
+    db->executeSQL ("INSERT INTO AccountTransactions "
+        "SELECT TransID, ID, LedgerSeq, TxnSeq FROM AccountTransactionsOld "
+        "INNER JOIN AccountMap ON AccountMap.Human = AccountTransactionsOld.Account;");
+    db->executeSQL ("DROP TABLE AccountMap;");
+
+    WriteLog (lsINFO, Application) << "Building new indexes";
+    db->executeSQL ("DROP TABLE AccountTransactionsOld;");
+    db->executeSQL ("CREATE INDEX AcctTxIDIndex ON AccountTransactions(TransID);");
+    db->executeSQL ("CREATE INDEX AcctTxIndex ON AccountTransactions(Account, LedgerSeq, TxnSeq, TransID);");
+    db->executeSQL ("CREATE INDEX AcctLgrIndex ON AccountTransactions(LedgerSeq, Account, TransID);");
+    db->executeSQL ("END TRANSACTION;");
+}
+
 void ApplicationImp::updateTables ()
 {
     if (getConfig ().nodeDatabase.size () <= 0)
@@ -1516,6 +1735,7 @@ void ApplicationImp::updateTables ()
     assert (schemaHas (getApp().getTxnDB (), "AccountTransactions", 0, "TransID"));
     assert (!schemaHas (getApp().getTxnDB (), "AccountTransactions", 0, "foobar"));
     addTxnSeqField ();
+    convertAccountField ();
 
     if (schemaHas (getApp().getTxnDB (), "AccountTransactions", 0, "PRIMARY"))
     {
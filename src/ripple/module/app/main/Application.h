@@ -45,6 +45,7 @@ class LoadManager;
 class NetworkOPs;
 class OrderBookDB;
 class ProofOfWorkFactory;
+class SignatureVerifier;
 class SerializedLedgerEntry;
 class TransactionMaster;
 class TxQueue;
@@ -54,7 +55,7 @@ class PathRequests;
 class DatabaseCon;
 
 using NodeCache     = TaggedCache <uint256, Blob>;
-using SLECache      = TaggedCache <uint256, SerializedLedgerEntry>;
+using SLECache      = ShardedTaggedCache <uint256, SerializedLedgerEntry>;
 
 class Application : public beast::PropertyStream::Source
 {
@@ -98,6 +99,7 @@ public:
     virtual Validators::Manager&    getValidators () = 0;
     virtual AmendmentTable&         getAmendmentTable() = 0;
     virtual IHashRouter&            getHashRouter () = 0;
+    virtual SignatureVerifier&      getSignatureVerifier () = 0;
     virtual LoadFeeTrack&           getFeeTrack () = 0;
     virtual LoadManager&            getLoadManager () = 0;
     virtual Overlay&                overlay () = 0;
@@ -27,6 +27,13 @@ enum
     fullBelowTargetSize = 524288
 
     ,fullBelowExpirationSeconds = 600
+
+    // How often the full below cache is saved, if it is persisted
+    ,fullBelowSaveSeconds = 300
+
+    // How many loaded full below keys are checked against the node store
+    // in one read
+    ,fullBelowCheckBatchSize = 256
 };
 
 }
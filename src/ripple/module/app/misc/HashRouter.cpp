@@ -17,6 +17,9 @@
 */
 //==============================================================================
 
+#include <beast/unit_test/suite.h>
+#include <deque>
+
 namespace ripple {
 
 // VFALCO TODO Inline the function definitions
@@ -24,6 +27,11 @@ class HashRouter : public IHashRouter
 {
 private:
     /** An entry in the routing table.
+
+        The peers which relayed the hash are kept in a small inline array,
+        spilling into a sorted vector only when a hash has been heard from
+        more peers than fit inline. Most hashes are seen by a handful of
+        peers so this avoids a tree node allocation per peer.
     */
     class Entry : public CountedObject <Entry>
     {
@@ -32,23 +40,36 @@ private:
 
         Entry ()
             : mFlags (0)
+            , mInlineCount (0)
         {
         }
 
-        std::set <PeerShortID> const& peekPeers () const
-        {
-            return mPeers;
-        }
-
         void addPeer (PeerShortID peer)
         {
-            if (peer != 0)
-                mPeers.insert (peer);
+            if (peer == 0 || hasPeer (peer))
+                return;
+
+            if (mInlineCount < inlinePeers)
+            {
+                mInline [mInlineCount++] = peer;
+            }
+            else
+            {
+                mOverflow.insert (std::lower_bound (mOverflow.begin (),
+                    mOverflow.end (), peer), peer);
+            }
         }
 
         bool hasPeer (PeerShortID peer) const
         {
-            return mPeers.count (peer) > 0;
+            for (std::uint32_t i = 0; i < mInlineCount; ++i)
+            {
+                if (mInline [i] == peer)
+                    return true;
+            }
+
+            return std::binary_search (mOverflow.begin (),
+                mOverflow.end (), peer);
         }
 
         int getFlags (void) const
@@ -71,19 +92,67 @@ private:
             mFlags &= ~flagsToClear;
         }
 
+        /** Exchange our peers with the contents of a set. */
         void swapSet (std::set <PeerShortID>& other)
         {
-            mPeers.swap (other);
+            std::set <PeerShortID> peers (mInline, mInline + mInlineCount);
+            peers.insert (mOverflow.begin (), mOverflow.end ());
+
+            mInlineCount = 0;
+            mOverflow.clear ();
+
+            for (auto const peer : other)
+                addPeer (peer);
+
+            other.swap (peers);
         }
 
     private:
+        static std::uint32_t const inlinePeers = 6;
+
         int mFlags;
-        std::set <PeerShortID> mPeers;
+        std::uint32_t mInlineCount;
+        PeerShortID mInline [inlinePeers];
+        std::vector <PeerShortID> mOverflow;
+    };
+
+    /** Hashes created during one span of time.
+        Entries carry no timestamp of their own, a whole generation is
+        retired at once when its newest possible entry has been held
+        long enough.
+    */
+    struct Generation
+    {
+        explicit Generation (int start_)
+            : start (start_)
+        {
+        }
+
+        int start;
+        std::vector <uint256> hashes;
+    };
+
+    typedef RippleMutex LockType;
+    typedef std::lock_guard <LockType> ScopedLockType;
+
+    /** A slice of the table, selected by hash, with its own lock. */
+    struct Shard
+    {
+        LockType mutex;
+        hash_map <uint256, Entry> entries;
+        std::deque <Generation> generations;
     };
 
+    // Must be a power of two
+    static std::size_t const shardCount = 16;
+
+    // How many generations make up one hold time
+    static int const generationsPerHold = 8;
+
 public:
     explicit HashRouter (int holdTime)
         : mHoldTime (holdTime)
+        , mGenerationTime (std::max (1, holdTime / generationsPerHold))
     {
     }
 
@@ -98,30 +167,28 @@ public:
     bool swapSet (uint256 const& index, std::set<PeerShortID>& peers, int flag);
 
 private:
-    Entry getEntry (uint256 const& );
-
-    Entry& findCreateEntry (uint256 const& , bool& created);
-
-    typedef RippleMutex LockType;
-    typedef std::lock_guard <LockType> ScopedLockType;
-    LockType mLock;
+    Shard& getShard (uint256 const& index)
+    {
+        return mShards [index.begin () [uint256::bytes - 1] & (shardCount - 1)];
+    }
 
-    // Stores all suppressed hashes and their expiration time
-    hash_map <uint256, Entry> mSuppressionMap;
+    // The caller must hold the shard's lock
+    Entry& findCreateEntry (Shard& shard, uint256 const& index, bool& created);
 
-    // Stores all expiration times and the hashes indexed for them
-    std::map< int, std::list<uint256> > mSuppressionTimes;
+    Shard mShards [shardCount];
 
-    int mHoldTime;
+    int const mHoldTime;
+    int const mGenerationTime;
 };
 
 //------------------------------------------------------------------------------
 
-HashRouter::Entry& HashRouter::findCreateEntry (uint256 const& index, bool& created)
+HashRouter::Entry& HashRouter::findCreateEntry (Shard& shard,
+    uint256 const& index, bool& created)
 {
-    hash_map<uint256, Entry>::iterator fit = mSuppressionMap.find (index);
+    hash_map<uint256, Entry>::iterator fit = shard.entries.find (index);
 
-    if (fit != mSuppressionMap.end ())
+    if (fit != shard.entries.end ())
     {
         created = false;
         return fit->second;
@@ -129,55 +196,53 @@ HashRouter::Entry& HashRouter::findCreateEntry (uint256 const& index, bool& crea
 
     created = true;
 
-    int now = UptimeTimer::getInstance ().getElapsedSeconds ();
-    int expireTime = now - mHoldTime;
+    int const now = UptimeTimer::getInstance ().getElapsedSeconds ();
 
-    // See if any supressions need to be expired
-    std::map< int, std::list<uint256> >::iterator it = mSuppressionTimes.begin ();
-
-    if ((it != mSuppressionTimes.end ()) && (it->first <= expireTime))
+    // Retire the generations whose newest entries have been held long enough
+    while (! shard.generations.empty () &&
+        (shard.generations.front ().start + mGenerationTime + mHoldTime <= now))
     {
-        BOOST_FOREACH (uint256 const& lit, it->second)
-        mSuppressionMap.erase (lit);
-        mSuppressionTimes.erase (it);
+        for (auto const& hash : shard.generations.front ().hashes)
+            shard.entries.erase (hash);
+
+        shard.generations.pop_front ();
     }
 
-    mSuppressionTimes[now].push_back (index);
-    return mSuppressionMap.emplace (index, Entry ()).first->second;
+    if (shard.generations.empty () ||
+        (now >= shard.generations.back ().start + mGenerationTime))
+        shard.generations.emplace_back (now);
+
+    shard.generations.back ().hashes.push_back (index);
+    return shard.entries.emplace (index, Entry ()).first->second;
 }
 
 bool HashRouter::addSuppression (uint256 const& index)
 {
-    ScopedLockType sl (mLock);
+    Shard& shard (getShard (index));
+    ScopedLockType sl (shard.mutex);
 
     bool created;
-    findCreateEntry (index, created);
+    findCreateEntry (shard, index, created);
     return created;
 }
 
-HashRouter::Entry HashRouter::getEntry (uint256 const& index)
-{
-    ScopedLockType sl (mLock);
-
-    bool created;
-    return findCreateEntry (index, created);
-}
-
 bool HashRouter::addSuppressionPeer (uint256 const& index, PeerShortID peer)
 {
-    ScopedLockType sl (mLock);
+    Shard& shard (getShard (index));
+    ScopedLockType sl (shard.mutex);
 
     bool created;
-    findCreateEntry (index, created).addPeer (peer);
+    findCreateEntry (shard, index, created).addPeer (peer);
     return created;
 }
 
 bool HashRouter::addSuppressionPeer (uint256 const& index, PeerShortID peer, int& flags)
 {
-    ScopedLockType sl (mLock);
+    Shard& shard (getShard (index));
+    ScopedLockType sl (shard.mutex);
 
     bool created;
-    Entry& s = findCreateEntry (index, created);
+    Entry& s = findCreateEntry (shard, index, created);
     s.addPeer (peer);
     flags = s.getFlags ();
     return created;
@@ -185,18 +250,20 @@ bool HashRouter::addSuppressionPeer (uint256 const& index, PeerShortID peer, int
 
 int HashRouter::getFlags (uint256 const& index)
 {
-    ScopedLockType sl (mLock);
+    Shard& shard (getShard (index));
+    ScopedLockType sl (shard.mutex);
 
     bool created;
-    return findCreateEntry (index, created).getFlags ();
+    return findCreateEntry (shard, index, created).getFlags ();
 }
 
 bool HashRouter::addSuppressionFlags (uint256 const& index, int flag)
 {
-    ScopedLockType sl (mLock);
+    Shard& shard (getShard (index));
+    ScopedLockType sl (shard.mutex);
 
     bool created;
-    findCreateEntry (index, created).setFlag (flag);
+    findCreateEntry (shard, index, created).setFlag (flag);
     return created;
 }
 
@@ -209,10 +276,11 @@ bool HashRouter::setFlag (uint256 const& index, int flag)
     // return: true = changed, false = unchanged
     assert (flag != 0);
 
-    ScopedLockType sl (mLock);
+    Shard& shard (getShard (index));
+    ScopedLockType sl (shard.mutex);
 
     bool created;
-    Entry& s = findCreateEntry (index, created);
+    Entry& s = findCreateEntry (shard, index, created);
 
     if ((s.getFlags () & flag) == flag)
         return false;
@@ -223,10 +291,11 @@ bool HashRouter::setFlag (uint256 const& index, int flag)
 
 bool HashRouter::swapSet (uint256 const& index, std::set<PeerShortID>& peers, int flag)
 {
-    ScopedLockType sl (mLock);
+    Shard& shard (getShard (index));
+    ScopedLockType sl (shard.mutex);
 
     bool created;
-    Entry& s = findCreateEntry (index, created);
+    Entry& s = findCreateEntry (shard, index, created);
 
     if ((s.getFlags () & flag) == flag)
         return false;
@@ -242,4 +311,76 @@ IHashRouter* IHashRouter::New (int holdTime)
     return new HashRouter (holdTime);
 }
 
+//------------------------------------------------------------------------------
+
+class HashRouter_test : public beast::unit_test::suite
+{
+public:
+    void testPeers ()
+    {
+        HashRouter router (IHashRouter::getDefaultHoldTime ());
+        uint256 const hash (1);
+
+        expect (router.addSuppressionPeer (hash, 0), "Created");
+        expect (! router.addSuppressionPeer (hash, 0), "Not created");
+
+        // Enough peers to spill out of the inline array, some twice
+        for (IHashRouter::PeerShortID peer = 20; peer > 0; --peer)
+        {
+            router.addSuppressionPeer (hash, peer);
+            router.addSuppressionPeer (hash, peer);
+        }
+
+        std::set <IHashRouter::PeerShortID> peers;
+        peers.insert (100);
+
+        expect (router.swapSet (hash, peers, SF_RELAYED), "Swapped");
+        expect (peers.size () == 20, "Twenty peers");
+        expect (*peers.begin () == 1 && *peers.rbegin () == 20, "Peer range");
+        expect (router.getFlags (hash) == SF_RELAYED, "Relayed");
+
+        // Already relayed, nothing is swapped
+        peers.clear ();
+        expect (! router.swapSet (hash, peers, SF_RELAYED), "Not swapped");
+        expect (peers.empty (), "Untouched");
+
+        router.setFlag (hash, SF_BAD);
+        router.setFlag (hash, SF_BAD | SF_RELAYED);
+        peers.clear ();
+        expect (router.swapSet (hash, peers, SF_SIGGOOD), "Swapped again");
+        expect (peers.size () == 1 && *peers.begin () == 100, "Our peer");
+    }
+
+    void testFlags ()
+    {
+        HashRouter router (IHashRouter::getDefaultHoldTime ());
+
+        for (int i = 0; i < 64; ++i)
+        {
+            uint256 const hash (i);
+            int flags = -1;
+
+            expect (router.addSuppressionPeer (hash, i + 1, flags), "Created");
+            expect (flags == 0, "No flags");
+            expect (router.setFlag (hash, SF_TRUSTED), "Changed");
+            expect (! router.setFlag (hash, SF_TRUSTED), "Unchanged");
+            expect (! router.addSuppressionFlags (hash, SF_SAVED), "Existing");
+        }
+
+        for (int i = 0; i < 64; ++i)
+        {
+            expect (router.getFlags (uint256 (i)) == (SF_TRUSTED | SF_SAVED),
+                "Flags kept");
+        }
+    }
+
+    void run ()
+    {
+        testPeers ();
+        testFlags ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(HashRouter,ripple_app,ripple);
+
 } // ripple
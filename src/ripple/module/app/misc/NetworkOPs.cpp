@@ -26,6 +26,8 @@
 
 namespace ripple {
 
+class FetchPackStream;
+
 class NetworkOPsImp
     : public NetworkOPs
     , public beast::DeadlineTimer::Listener
@@ -482,11 +484,25 @@ private:
     void pubValidatedTransaction (
         Ledger::ref alAccepted, const AcceptedLedgerTx& alTransaction);
     void pubAccountTransaction (
-        Ledger::ref lpCurrent, const AcceptedLedgerTx& alTransaction,
-        bool isAccepted);
+        const AcceptedLedgerTx& alTransaction, bool isAccepted,
+        Json::Value const& jvObj, std::string const& sObj);
 
     void pubServer ();
 
+    // Add the next ledger to a fetch pack being streamed to a peer
+    void streamFetchPack (Job&, std::shared_ptr <FetchPackStream> stream);
+
+    typedef std::vector <InfoSub::pointer> SubscriberList;
+
+    // Append the live subscribers in the map to the list, removing those
+    // which have gone away. The caller must hold mLock.
+    static void collectSubscribers (SubMapType& subMap, SubscriberList& list);
+
+    // Send a published message to each subscriber in the list. This is
+    // called without holding mLock, since a send can block.
+    static void sendSubscribers (SubscriberList const& list,
+        Json::Value const& jvObj, std::string const& sObj);
+
 private:
     clock_type& m_clock;
 
@@ -1769,15 +1785,15 @@ void NetworkOPsImp::consensusViewChange ()
 
 void NetworkOPsImp::pubServer ()
 {
-    // VFALCO TODO Don't hold the lock across calls to send...make a copy of the
-    //             list into a local array while holding the lock then release the
-    //             lock and call send on everyone.
-    //
-    ScopedLockType sl (mLock);
+    Json::Value jvObj (Json::objectValue);
+    SubscriberList subs;
 
-    if (!mSubServer.empty ())
     {
-        Json::Value jvObj (Json::objectValue);
+        ScopedLockType sl (mLock);
+
+        if (mSubServer.empty ())
+            return;
+
 
         jvObj [jss::type]          = "serverStatus";
         jvObj [jss::server_status] = strOperatingMode ();
@@ -1786,28 +1802,11 @@ void NetworkOPsImp::pubServer ()
         jvObj [jss::load_factor]   =
                 (mLastLoadFactor = getApp().getFeeTrack ().getLoadFactor ());
 
-        Json::FastWriter w;
-        std::string sObj = w.write (jvObj);
-
-
-        for (auto i = mSubServer.begin (); i != mSubServer.end (); )
-        {
-            InfoSub::pointer p = i->second.lock ();
-
-            // VFALCO TODO research the possibility of using thread queues and
-            //             linearizing the deletion of subscribers with the
-            //             sending of JSON data.
-            if (p)
-            {
-                p->send (jvObj, sObj, true);
-                ++i;
-            }
-            else
-            {
-                i = mSubServer.erase (i);
-            }
-        }
+        collectSubscribers (mSubServer, subs);
     }
+
+    Json::FastWriter w;
+    sendSubscribers (subs, jvObj, w.write (jvObj));
 }
 
 void NetworkOPsImp::setMode (OperatingMode om)
@@ -1894,9 +1893,9 @@ NetworkOPsImp::transactionsSQL (
         sql =
             boost::str (boost::format (
                 "SELECT %s FROM AccountTransactions "
-                "WHERE Account = '%s' %s %s LIMIT %u, %u;")
+                "WHERE Account = X'%s' %s %s LIMIT %u, %u;")
             % selection
-            % account.humanAccountID ()
+            % to_string (account.getAccountID ())
             % maxClause
             % minClause
             % beast::lexicalCastThrow <std::string> (offset)
@@ -1908,12 +1907,12 @@ NetworkOPsImp::transactionsSQL (
                 "SELECT %s FROM "
                 "AccountTransactions INNER JOIN Transactions "
                 "ON Transactions.TransID = AccountTransactions.TransID "
-                "WHERE Account = '%s' %s %s "
+                "WHERE Account = X'%s' %s %s "
                 "ORDER BY AccountTransactions.LedgerSeq %s, "
                 "AccountTransactions.TxnSeq %s, AccountTransactions.TransID %s "
                 "LIMIT %u, %u;")
                     % selection
-                    % account.humanAccountID ()
+                    % to_string (account.getAccountID ())
                     % maxClause
                     % minClause
                     % (descending ? "DESC" : "ASC")
@@ -2032,6 +2031,63 @@ std::vector<NetworkOPsImp::txnMetaLedgerType> NetworkOPsImp::getAccountTxsB (
 }
 
 
+// Build the query for one page of an account's transactions. A page that
+// resumes from a marker starts at the marker's ledger and transaction
+// sequence through the index, instead of reading and skipping the rows
+// before it.
+static std::string accountTxPageSQL (bool forward, bool resume)
+{
+    char const* const order = forward ? "ASC" : "DESC";
+    char const* const after = forward ? ">" : "<";
+
+    std::string sql (
+        "SELECT AccountTransactions.LedgerSeq,AccountTransactions.TxnSeq,"
+        "Status,RawTxn,TxnMeta "
+        "FROM AccountTransactions INNER JOIN Transactions "
+        "ON Transactions.TransID = AccountTransactions.TransID "
+        "WHERE AccountTransactions.Account = ?1 "
+        "AND AccountTransactions.LedgerSeq BETWEEN ?2 AND ?3 ");
+
+    if (resume)
+        sql += boost::str (boost::format (
+            "AND (AccountTransactions.LedgerSeq %s ?4 OR "
+            "(AccountTransactions.LedgerSeq = ?4 AND "
+            "AccountTransactions.TxnSeq %s= ?5)) ")
+                % after
+                % after);
+
+    sql += boost::str (boost::format (
+        "ORDER BY AccountTransactions.LedgerSeq %s, "
+        "AccountTransactions.TxnSeq %s, AccountTransactions.TransID %s "
+        "LIMIT ?6;")
+            % order
+            % order
+            % order);
+
+    return sql;
+}
+
+// Bind the parameters of a query from accountTxPageSQL.
+static void bindAccountTxPage (SqliteStatement& statement,
+    RippleAddress const& account, std::uint32_t minLedger,
+    std::uint32_t maxLedger, bool resume, std::uint32_t findLedger,
+    std::uint32_t findSeq, std::uint32_t limit)
+{
+    Account const& id (account.getAccountID ());
+
+    statement.bind (1, id.begin (), id.size ());
+    statement.bind (2, minLedger);
+    statement.bind (3, maxLedger);
+
+    if (resume)
+    {
+        statement.bind (4, findLedger);
+        statement.bind (5, findSeq);
+    }
+
+    statement.bind (6, limit);
+}
+
 NetworkOPsImp::AccountTxs NetworkOPsImp::getTxsAccount (
     RippleAddress const& account, std::int32_t minLedger,
     std::int32_t maxLedger, bool forward, Json::Value& token,
@@ -2040,21 +2096,19 @@ NetworkOPsImp::AccountTxs NetworkOPsImp::getTxsAccount (
     AccountTxs ret;
 
     std::uint32_t NONBINARY_PAGE_LENGTH = 200;
-    std::uint32_t EXTRA_LENGTH = 100;
 
-    bool foundResume = token.isNull() || !token.isObject();
+    bool const resume = !token.isNull() && token.isObject();
 
-    std::uint32_t numberOfResults, queryLimit;
+    std::uint32_t numberOfResults;
     if (limit <= 0)
         numberOfResults = NONBINARY_PAGE_LENGTH;
     else if (!bAdmin && (limit > NONBINARY_PAGE_LENGTH))
         numberOfResults = NONBINARY_PAGE_LENGTH;
     else
         numberOfResults = limit;
-    queryLimit = numberOfResults + 1 + (foundResume ? 0 : EXTRA_LENGTH);
 
     std::uint32_t findLedger = 0, findSeq = 0;
-    if (!foundResume)
+    if (resume)
     {
         try
         {
@@ -2073,80 +2127,51 @@ NetworkOPsImp::AccountTxs NetworkOPsImp::getTxsAccount (
     //         outputs, so we need to clear it in between.
     token = Json::nullValue;
 
-    std::string sql = boost::str (boost::format
-        ("SELECT AccountTransactions.LedgerSeq,AccountTransactions.TxnSeq,"
-         "Status,RawTxn,TxnMeta "
-         "FROM AccountTransactions INNER JOIN Transactions "
-         "ON Transactions.TransID = AccountTransactions.TransID "
-         "WHERE AccountTransactions.Account = '%s' "
-         "AND AccountTransactions.LedgerSeq BETWEEN '%u' AND '%u' "
-         "ORDER BY AccountTransactions.LedgerSeq %s, "
-         "AccountTransactions.TxnSeq %s, AccountTransactions.TransID %s "
-         "LIMIT %u;")
-             % account.humanAccountID()
-             % ((forward && (findLedger != 0)) ? findLedger : minLedger)
-             % ((!forward && (findLedger != 0)) ? findLedger: maxLedger)
-             % (forward ? "ASC" : "DESC")
-             % (forward ? "ASC" : "DESC")
-             % (forward ? "ASC" : "DESC")
-             % queryLimit);
     {
-        Database* db = getApp().getTxnDB ()->getDB ();
         auto sl (getApp().getTxnDB ()->lock ());
+        SqliteStatement& statement (getApp().getTxnDB ()->getDB ()->
+            getSqliteDB ()->getStatement (accountTxPageSQL (forward, resume)));
 
-        SQL_FOREACH (db, sql)
+        bindAccountTxPage (statement, account,
+            (forward && resume) ? findLedger : minLedger,
+            (!forward && resume) ? findLedger : maxLedger,
+            resume, findLedger, findSeq, numberOfResults + 1);
+
+        while (statement.isRow (statement.step ()))
         {
-            if (!foundResume)
-            {
-                foundResume = (findLedger == db->getInt("LedgerSeq") &&
-                               findSeq == db->getInt("TxnSeq"));
-            }
-            else if (numberOfResults == 0)
+            if (numberOfResults == 0)
             {
                 token = Json::objectValue;
-                token[jss::ledger] = db->getInt("LedgerSeq");
-                token[jss::seq] = db->getInt("TxnSeq");
+                token[jss::ledger] = static_cast<int> (statement.getInt64 (0));
+                token[jss::seq] = static_cast<int> (statement.getInt64 (1));
                 break;
             }
 
-            if (foundResume)
-            {
-                auto txn = Transaction::transactionFromSQL (db, false);
+            std::uint32_t const ledgerSeq = statement.getUInt32 (0);
 
-                Serializer rawMeta;
-                int metaSize = 2048;
-                rawMeta.resize (metaSize);
-                metaSize = db->getBinary (
-                    "TxnMeta", &*rawMeta.begin (), rawMeta.getLength ());
+            auto txn = Transaction::transactionFromSQL (statement.getBlob (3),
+                statement.getString (2), ledgerSeq, false);
 
-                if (metaSize > rawMeta.getLength ())
-                {
-                    rawMeta.resize (metaSize);
-                    db->getBinary (
-                        "TxnMeta", &*rawMeta.begin (), rawMeta.getLength ());
-                }
-                else
-                    rawMeta.resize (metaSize);
+            Blob rawMeta (statement.getBlob (4));
 
-                if (rawMeta.getLength() == 0)
-                {
-                    // Work around a bug that could leave the metadata missing
-                    auto seq = static_cast<std::uint32_t>(
-                        db->getBigInt("LedgerSeq"));
-                    m_journal.warning << "Recovering ledger " << seq
-                                      << ", txn " << txn->getID();
-                    Ledger::pointer ledger = getLedgerBySeq(seq);
-                    if (ledger)
-                        ledger->pendSaveValidated(false, false);
-                }
+            if (rawMeta.empty ())
+            {
+                // Work around a bug that could leave the metadata missing
+                m_journal.warning << "Recovering ledger " << ledgerSeq
+                                  << ", txn " << txn->getID();
+                Ledger::pointer ledger = getLedgerBySeq(ledgerSeq);
+                if (ledger)
+                    ledger->pendSaveValidated(false, false);
+            }
 
-                --numberOfResults;
+            --numberOfResults;
 
-                ret.emplace_back (std::move (txn),
-                    std::make_shared<TransactionMetaSet> (
-                        txn->getID (), txn->getLedger (), rawMeta.getData ()));
-            }
+            auto meta = std::make_shared<TransactionMetaSet> (
+                txn->getID (), txn->getLedger (), rawMeta);
+            ret.emplace_back (std::move (txn), std::move (meta));
         }
+
+        statement.reset ();
     }
 
     return ret;
@@ -2160,21 +2185,19 @@ NetworkOPsImp::MetaTxsList NetworkOPsImp::getTxsAccountB (
     MetaTxsList ret;
 
     std::uint32_t BINARY_PAGE_LENGTH = 500;
-    std::uint32_t EXTRA_LENGTH = 100;
 
-    bool foundResume = token.isNull() || !token.isObject();
+    bool const resume = !token.isNull() && token.isObject();
 
-    std::uint32_t numberOfResults, queryLimit;
+    std::uint32_t numberOfResults;
     if (limit <= 0)
         numberOfResults = BINARY_PAGE_LENGTH;
     else if (!bAdmin && (limit > BINARY_PAGE_LENGTH))
         numberOfResults = BINARY_PAGE_LENGTH;
     else
         numberOfResults = limit;
-    queryLimit = numberOfResults + 1 + (foundResume ? 0 : EXTRA_LENGTH);
 
     std::uint32_t findLedger = 0, findSeq = 0;
-    if (!foundResume)
+    if (resume)
     {
         try
         {
@@ -2191,80 +2214,33 @@ NetworkOPsImp::MetaTxsList NetworkOPsImp::getTxsAccountB (
 
     token = Json::nullValue;
 
-    std::string sql = boost::str (boost::format
-        ("SELECT AccountTransactions.LedgerSeq,AccountTransactions.TxnSeq,"
-         "Status,RawTxn,TxnMeta "
-         "FROM AccountTransactions INNER JOIN Transactions "
-         "ON Transactions.TransID = AccountTransactions.TransID "
-         "WHERE AccountTransactions.Account = '%s' "
-         "AND AccountTransactions.LedgerSeq BETWEEN '%u' AND '%u' "
-         "ORDER BY AccountTransactions.LedgerSeq %s, "
-         "AccountTransactions.TxnSeq %s, AccountTransactions.TransID %s "
-         "LIMIT %u;")
-             % account.humanAccountID()
-             % ((forward && (findLedger != 0)) ? findLedger : minLedger)
-             % ((!forward && (findLedger != 0)) ? findLedger: maxLedger)
-             % (forward ? "ASC" : "DESC")
-             % (forward ? "ASC" : "DESC")
-             % (forward ? "ASC" : "DESC")
-             % queryLimit);
     {
-        Database* db = getApp().getTxnDB ()->getDB ();
         auto sl (getApp().getTxnDB ()->lock ());
+        SqliteStatement& statement (getApp().getTxnDB ()->getDB ()->
+            getSqliteDB ()->getStatement (accountTxPageSQL (forward, resume)));
 
-        SQL_FOREACH (db, sql)
+        bindAccountTxPage (statement, account,
+            (forward && resume) ? findLedger : minLedger,
+            (!forward && resume) ? findLedger : maxLedger,
+            resume, findLedger, findSeq, numberOfResults + 1);
+
+        while (statement.isRow (statement.step ()))
         {
-            if (!foundResume)
-            {
-                if (findLedger == db->getInt("LedgerSeq") &&
-                    findSeq == db->getInt("TxnSeq"))
-                {
-                    foundResume = true;
-                }
-            }
-            else if (numberOfResults == 0)
+            if (numberOfResults == 0)
             {
                 token = Json::objectValue;
-                token[jss::ledger] = db->getInt("LedgerSeq");
-                token[jss::seq] = db->getInt("TxnSeq");
+                token[jss::ledger] = static_cast<int> (statement.getInt64 (0));
+                token[jss::seq] = static_cast<int> (statement.getInt64 (1));
                 break;
             }
 
-            if (foundResume)
-            {
-                int txnSize = 2048;
-                Blob rawTxn (txnSize);
-                txnSize = db->getBinary ("RawTxn", &rawTxn[0], rawTxn.size ());
-
-                if (txnSize > rawTxn.size ())
-                {
-                    rawTxn.resize (txnSize);
-                    db->getBinary ("RawTxn", &*rawTxn.begin (), rawTxn.size ());
-                }
-                else
-                    rawTxn.resize (txnSize);
-
-                int metaSize = 2048;
-                Blob rawMeta (metaSize);
-                metaSize = db->getBinary (
-                    "TxnMeta", &rawMeta[0], rawMeta.size ());
-
-                if (metaSize > rawMeta.size ())
-                {
-                    rawMeta.resize (metaSize);
-                    db->getBinary (
-                        "TxnMeta", &*rawMeta.begin (), rawMeta.size ());
-                }
-                else
-                {
-                    rawMeta.resize (metaSize);
-                }
-
-                ret.emplace_back (strHex (rawTxn), strHex (rawMeta),
-                                  db->getInt ("LedgerSeq"));
-                --numberOfResults;
-            }
+            ret.emplace_back (strHex (statement.getBlob (3)),
+                strHex (statement.getBlob (4)),
+                static_cast<int> (statement.getInt64 (0)));
+            --numberOfResults;
         }
+
+        statement.reset ();
     }
 
     return ret;
@@ -2285,8 +2261,13 @@ NetworkOPsImp::getLedgerAffectedAccounts (std::uint32_t ledgerSeq)
         auto sl (getApp().getTxnDB ()->lock ());
         SQL_FOREACH (db, sql)
         {
-            if (acct.setAccountID (db->getStrBinary ("Account")))
+            Blob const id (db->getBinary ("Account"));
+
+            if (id.size () == Account::bytes)
+            {
+                acct.setAccountID (Account::fromVoid (id.data ()));
                 accounts.push_back (acct);
+            }
         }
     }
     return accounts;
@@ -2524,30 +2505,28 @@ Json::Value NetworkOPsImp::pubBootstrapAccountInfo (
 void NetworkOPsImp::pubProposedTransaction (
     Ledger::ref lpCurrent, SerializedTransaction::ref stTxn, TER terResult)
 {
-    Json::Value jvObj   = transJson (*stTxn, terResult, false, lpCurrent);
+    SubscriberList subs;
 
     {
         ScopedLockType sl (mLock);
 
-        auto it = mSubRTTransactions.begin ();
-        while (it != mSubRTTransactions.end ())
-        {
-            InfoSub::pointer p = it->second.lock ();
+        if (mSubRTTransactions.empty () && mSubRTAccount.empty ())
+            return;
 
-            if (p)
-            {
-                p->send (jvObj, true);
-                ++it;
-            }
-            else
-            {
-                it = mSubRTTransactions.erase (it);
-            }
-        }
+        collectSubscribers (mSubRTTransactions, subs);
     }
+
+    Json::Value jvObj   = transJson (*stTxn, terResult, false, lpCurrent);
+
+    // Serialized once, shared by every stream this is published to
+    Json::FastWriter w;
+    std::string const sObj = w.write (jvObj);
+
+    sendSubscribers (subs, jvObj, sObj);
+
     AcceptedLedgerTx alt (lpCurrent, stTxn, terResult);
     m_journal.trace << "pubProposed: " << alt.getJson ();
-    pubAccountTransaction (lpCurrent, alt, false);
+    pubAccountTransaction (alt, false, jvObj, sObj);
 }
 
 void NetworkOPsImp::pubLedger (Ledger::ref accepted)
@@ -2558,13 +2537,14 @@ void NetworkOPsImp::pubLedger (Ledger::ref accepted)
     auto alpAccepted = AcceptedLedger::makeAcceptedLedger (accepted);
     Ledger::ref lpAccepted = alpAccepted->getLedger ();
 
+    Json::Value jvObj (Json::objectValue);
+    SubscriberList subs;
+
     {
         ScopedLockType sl (mLock);
 
         if (!mSubLedger.empty ())
         {
-            Json::Value jvObj (Json::objectValue);
-
             jvObj[jss::type] = jss::ledgerClosed;
             jvObj[jss::ledger_index] = lpAccepted->getLedgerSeq ();
             jvObj[jss::ledger_hash] = to_string (lpAccepted->getHash ());
@@ -2585,21 +2565,20 @@ void NetworkOPsImp::pubLedger (Ledger::ref accepted)
                         = getApp().getLedgerMaster ().getCompleteLedgers ();
             }
 
-            auto it = mSubLedger.begin ();
-            while (it != mSubLedger.end ())
-            {
-                InfoSub::pointer p = it->second.lock ();
-                if (p)
-                {
-                    p->send (jvObj, true);
-                    ++it;
-                }
-                else
-                    it = mSubLedger.erase (it);
-            }
+            collectSubscribers (mSubLedger, subs);
         }
     }
 
+    if (!subs.empty ())
+    {
+        Json::FastWriter w;
+        sendSubscribers (subs, jvObj, w.write (jvObj));
+    }
+
+    // Pick up books created or emptied by this ledger before its
+    // transactions go out to the book streams
+    getApp().getOrderBookDB ().applyLedger (alpAccepted);
+
     // Don't lock since pubAcceptedTransaction is locking.
     BOOST_FOREACH (const AcceptedLedger::value_type & vt, alpAccepted->getMap ())
     {
@@ -2680,47 +2659,27 @@ void NetworkOPsImp::pubValidatedTransaction (
         *alTx.getTxn (), alTx.getResult (), true, alAccepted);
     jvObj[jss::meta] = alTx.getMeta ()->getJson (0);
 
+    // Serialized once, shared by every stream this is published to
     Json::FastWriter w;
-    std::string sObj = w.write (jvObj);
+    std::string const sObj = w.write (jvObj);
+
+    SubscriberList subs;
 
     {
         ScopedLockType sl (mLock);
+        collectSubscribers (mSubTransactions, subs);
+        collectSubscribers (mSubRTTransactions, subs);
+    }
 
-        auto it = mSubTransactions.begin ();
-        while (it != mSubTransactions.end ())
-        {
-            InfoSub::pointer p = it->second.lock ();
-
-            if (p)
-            {
-                p->send (jvObj, sObj, true);
-                ++it;
-            }
-            else
-                it = mSubTransactions.erase (it);
-        }
-
-        it = mSubRTTransactions.begin ();
+    sendSubscribers (subs, jvObj, sObj);
 
-        while (it != mSubRTTransactions.end ())
-        {
-            InfoSub::pointer p = it->second.lock ();
-
-            if (p)
-            {
-                p->send (jvObj, sObj, true);
-                ++it;
-            }
-            else
-                it = mSubRTTransactions.erase (it);
-        }
-    }
-    getApp().getOrderBookDB ().processTxn (alAccepted, alTx, jvObj);
-    pubAccountTransaction (alAccepted, alTx, true);
+    getApp().getOrderBookDB ().processTxn (alAccepted, alTx, jvObj, sObj);
+    pubAccountTransaction (alTx, true, jvObj, sObj);
 }
 
 void NetworkOPsImp::pubAccountTransaction (
-    Ledger::ref lpCurrent, const AcceptedLedgerTx& alTx, bool bAccepted)
+    const AcceptedLedgerTx& alTx, bool bAccepted,
+    Json::Value const& jvObj, std::string const& sObj)
 {
     hash_set<InfoSub::pointer>  notify;
     int                             iProposed   = 0;
@@ -2785,24 +2744,38 @@ void NetworkOPsImp::pubAccountTransaction (
         " iProposed=" << iProposed <<
         " iAccepted=" << iAccepted;
 
-    if (!notify.empty ())
+    BOOST_FOREACH (InfoSub::ref isrListener, notify)
     {
-        Json::Value jvObj = transJson (
-            *alTx.getTxn (), alTx.getResult (), bAccepted, lpCurrent);
+        isrListener->send (jvObj, sObj, true);
+    }
+}
 
-        if (alTx.isApplied ())
-            jvObj[jss::meta] = alTx.getMeta ()->getJson (0);
+void NetworkOPsImp::collectSubscribers (
+    SubMapType& subMap, SubscriberList& list)
+{
+    auto it = subMap.begin ();
 
-        Json::FastWriter w;
-        std::string sObj = w.write (jvObj);
+    while (it != subMap.end ())
+    {
+        InfoSub::pointer p = it->second.lock ();
 
-        BOOST_FOREACH (InfoSub::ref isrListener, notify)
+        if (p)
         {
-            isrListener->send (jvObj, sObj, true);
+            list.push_back (p);
+            ++it;
         }
+        else
+            it = subMap.erase (it);
     }
 }
 
+void NetworkOPsImp::sendSubscribers (SubscriberList const& list,
+    Json::Value const& jvObj, std::string const& sObj)
+{
+    for (auto const& p : list)
+        p->send (jvObj, sObj, true);
+}
+
 //
 // Monitoring
 //
@@ -3425,18 +3398,89 @@ void NetworkOPsImp::getBookPage (
 
 #endif
 
-static void fpAppender (
-    protocol::TMGetObjectByHash* reply, std::uint32_t ledgerSeq,
-    uint256 const& hash, const Blob& blob)
+enum
 {
-    protocol::TMIndexedObject& newObj = * (reply->add_objects ());
-    newObj.set_ledgerseq (ledgerSeq);
-    newObj.set_hash (hash.begin (), 256 / 8);
-    newObj.set_data (&blob[0], blob.size ());
-}
+    // Objects in each message of a streamed fetch pack
+    fetchPackChunkObjects = 256
+
+    // Stop adding ledgers to a fetch pack once it holds this many objects
+    ,fetchPackMaxObjects = 4096
+
+    // The limit used instead when the server is under local load
+    ,fetchPackLoadedObjects = 256
+
+    // Stop adding ledgers to a fetch pack after this long
+    ,fetchPackBuildSeconds = 2
+};
+
+/** A fetch pack being sent to a peer.
+
+    The pack is sent as a series of messages of at most
+    fetchPackChunkObjects objects each, so only one chunk is held in memory
+    no matter how many ledgers the pack covers. One ledger is added per job,
+    letting other work interleave with a large pack.
+*/
+class FetchPackStream
+{
+public:
+    FetchPackStream (std::weak_ptr <Peer> peer,
+        protocol::TMGetObjectByHash const& request,
+            Ledger::pointer haveLedger, Ledger::pointer wantLedger)
+        : m_peer (std::move (peer))
+        , m_haveLedger (std::move (haveLedger))
+        , m_wantLedger (std::move (wantLedger))
+        , m_started (UptimeTimer::getInstance ().getElapsedSeconds ())
+        , m_objects (0)
+        , m_messages (0)
+    {
+        m_reply.set_query (false);
+
+        if (request.has_seq ())
+            m_reply.set_seq (request.seq ());
+
+        m_reply.set_ledgerhash (request.ledgerhash ());
+        m_reply.set_type (protocol::TMGetObjectByHash::otFETCH_PACK);
+    }
+
+    void add (Peer& peer, std::uint32_t ledgerSeq,
+        uint256 const& hash, void const* data, std::size_t size)
+    {
+        protocol::TMIndexedObject& newObj = *m_reply.add_objects ();
+        newObj.set_ledgerseq (ledgerSeq);
+        newObj.set_hash (hash.begin (), 256 / 8);
+        newObj.set_data (data, size);
+
+        ++m_objects;
+
+        if (m_reply.objects_size () >= fetchPackChunkObjects)
+            flush (peer);
+    }
+
+    /** Send whatever objects are pending. */
+    void flush (Peer& peer)
+    {
+        if (m_reply.objects_size () == 0)
+            return;
+
+        peer.send (std::make_shared <Message> (
+            m_reply, protocol::mtGET_OBJECTS));
+        m_reply.clear_objects ();
+        ++m_messages;
+    }
+
+    std::weak_ptr <Peer> m_peer;
+    Ledger::pointer m_haveLedger;
+    Ledger::pointer m_wantLedger;
+    int const m_started;
+    int m_objects;
+    int m_messages;
+
+private:
+    protocol::TMGetObjectByHash m_reply;
+};
 
 void NetworkOPsImp::makeFetchPack (
-    Job&, std::weak_ptr<Peer> wPeer,
+    Job& job, std::weak_ptr<Peer> wPeer,
     std::shared_ptr<protocol::TMGetObjectByHash> request,
     uint256 haveLedgerHash, std::uint32_t uUptime)
 {
@@ -3446,8 +3490,8 @@ void NetworkOPsImp::makeFetchPack (
         return;
     }
 
-    if (getApp().getFeeTrack ().isLoadedLocal () ||
-        (m_ledgerMaster.getValidatedLedgerAge() > 40))
+    // A server that is behind the network has nothing useful to send
+    if (m_ledgerMaster.getValidatedLedgerAge() > 40)
     {
         m_journal.info << "Too busy to make fetch pack";
         return;
@@ -3496,68 +3540,88 @@ void NetworkOPsImp::makeFetchPack (
         return;
     }
 
+    streamFetchPack (job, std::make_shared <FetchPackStream> (
+        std::move (wPeer), *request,
+            std::move (haveLedger), std::move (wantLedger)));
+}
+
+void NetworkOPsImp::streamFetchPack (
+    Job&, std::shared_ptr <FetchPackStream> stream)
+{
+    Peer::ptr peer = stream->m_peer.lock ();
+
+    if (!peer)
+        return;
+
+    // Adding a ledger to the pack:
+    //  1. Add the header for the wanted ledger.
+    //  2. Add the nodes for the AccountStateMap of that ledger which
+    //     are not in the AccountStateMap of the ledger the peer has.
+    //  3. If there are transactions, add the nodes for the
+    //     transactions of the ledger.
+    // Objects go out in fixed size chunks as they are added. If the pack
+    // is still under its limit and not much time has elapsed, a job is
+    // queued to add the previous ledger.
     try
     {
-        protocol::TMGetObjectByHash reply;
-        reply.set_query (false);
-
-        if (request->has_seq ())
-            reply.set_seq (request->seq ());
+        Ledger::ref wantLedger = stream->m_wantLedger;
+        std::uint32_t const lSeq = wantLedger->getLedgerSeq ();
 
-        reply.set_ledgerhash (request->ledgerhash ());
-        reply.set_type (protocol::TMGetObjectByHash::otFETCH_PACK);
+        Serializer s (256);
+        s.add32 (HashPrefix::ledgerMaster);
+        wantLedger->addRaw (s);
+        stream->add (*peer, lSeq, wantLedger->getHash (),
+            s.getDataPtr (), s.getLength ());
 
-        // Building a fetch pack:
-        //  1. Add the header for the requested ledger.
-        //  2. Add the nodes for the AccountStateMap of that ledger.
-        //  3. If there are transactions, add the nodes for the
-        //     transactions of the ledger.
-        //  4. If the FetchPack now contains greater than or equal to
-        //     256 entries then stop.
-        //  5. If not very much time has elapsed, then loop back and repeat
-        //     the same process adding the previous ledger to the FetchPack.
-        do
+        auto appender = [&](uint256 const& hash, Blob const& blob)
         {
-            std::uint32_t lSeq = wantLedger->getLedgerSeq ();
-
-            protocol::TMIndexedObject& newObj = *reply.add_objects ();
-            newObj.set_hash (wantLedger->getHash ().begin (), 256 / 8);
-            Serializer s (256);
-            s.add32 (HashPrefix::ledgerMaster);
-            wantLedger->addRaw (s);
-            newObj.set_data (s.getDataPtr (), s.getLength ());
-            newObj.set_ledgerseq (lSeq);
-
-            wantLedger->peekAccountStateMap ()->getFetchPack
-                (haveLedger->peekAccountStateMap ().get (), true, 1024,
-                    std::bind (fpAppender, &reply, lSeq, std::placeholders::_1,
-                               std::placeholders::_2));
-
-            if (wantLedger->getTransHash ().isNonZero ())
-                wantLedger->peekTransactionMap ()->getFetchPack (
-                    nullptr, true, 256,
-                    std::bind (fpAppender, &reply, lSeq, std::placeholders::_1,
-                               std::placeholders::_2));
-
-            if (reply.objects ().size () >= 256)
-                break;
+            stream->add (*peer, lSeq, hash, &blob[0], blob.size ());
+        };
 
-            // move may save a ref/unref
-            haveLedger = std::move (wantLedger);
-            wantLedger = getLedgerByHash (haveLedger->getParentHash ());
-        }
-        while (wantLedger &&
-               UptimeTimer::getInstance ().getElapsedSeconds () <= uUptime + 1);
+        wantLedger->peekAccountStateMap ()->getFetchPack (
+            stream->m_haveLedger->peekAccountStateMap ().get (), true, 1024,
+                appender);
 
-        m_journal.info
-            << "Built fetch pack with " << reply.objects ().size () << " nodes";
-        auto msg = std::make_shared<Message> (reply, protocol::mtGET_OBJECTS);
-        peer->send (msg);
+        if (wantLedger->getTransHash ().isNonZero ())
+            wantLedger->peekTransactionMap ()->getFetchPack (
+                nullptr, true, 256, appender);
     }
     catch (...)
     {
-        m_journal.warning << "Exception building fetch pach";
+        m_journal.warning << "Exception building fetch pack";
+        stream->flush (*peer);
+        return;
+    }
+
+    // Under local load the pack is made smaller rather than refused
+    int const limit = getApp().getFeeTrack ().isLoadedLocal ()
+        ? fetchPackLoadedObjects
+        : fetchPackMaxObjects;
+
+    // move may save a ref/unref
+    stream->m_haveLedger = std::move (stream->m_wantLedger);
+
+    if ((stream->m_objects < limit) &&
+        (UptimeTimer::getInstance ().getElapsedSeconds () <=
+            stream->m_started + fetchPackBuildSeconds))
+    {
+        stream->m_wantLedger = getLedgerByHash (
+            stream->m_haveLedger->getParentHash ());
+    }
+
+    if (stream->m_wantLedger)
+    {
+        getApp().getJobQueue ().addJob (jtPACK, "MakeFetchPack",
+            std::bind (&NetworkOPsImp::streamFetchPack, this,
+                std::placeholders::_1, std::move (stream)));
+        return;
     }
+
+    stream->flush (*peer);
+
+    m_journal.info
+        << "Built fetch pack with " << stream->m_objects << " nodes in "
+        << stream->m_messages << " messages";
 }
 
 void NetworkOPsImp::sweepFetchPack ()
@@ -3580,12 +3644,7 @@ bool NetworkOPsImp::getFetchPack (uint256 const& hash, Blob& data)
 
     mFetchPack.del (hash, false);
 
-    if (hash != Serializer::getSHA512Half (data))
-    {
-        m_journal.warning << "Bad entry in fetch pack";
-        return false;
-    }
-
+    // Entries were checked against their hashes when they arrived
     return true;
 }
 
@@ -229,6 +229,7 @@ public:
 
     virtual bool shouldFetchPack (std::uint32_t seq) = 0;
     virtual void gotFetchPack (bool progress, std::uint32_t seq) = 0;
+    // The caller must have checked that hash is the hash of data
     virtual void addFetchPack (
         uint256 const& hash, std::shared_ptr< Blob >& data) = 0;
     virtual bool getFetchPack (uint256 const& hash, Blob& data) = 0;
@@ -112,6 +112,16 @@ private:
         return new SerializedLedgerEntry (*this);
     }
 
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
+
     /** Make STObject comply with the template for this SLE type
         Can throw
     */
@@ -108,7 +108,7 @@ std::vector<RippleAddress> SerializedTransaction::getMentionedAccounts () const
 {
     std::vector<RippleAddress> accounts;
 
-    BOOST_FOREACH (const SerializedType & it, peekData ())
+    BOOST_FOREACH (const SerializedType & it, *this)
     {
         const STAccount* sa = dynamic_cast<const STAccount*> (&it);
 
@@ -149,6 +149,16 @@ private:
         return new SerializedTransaction (*this);
     }
 
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
+
     mutable bool mSigGood;
     mutable bool mSigBad;
 };
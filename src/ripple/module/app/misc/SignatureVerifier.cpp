@@ -0,0 +1,177 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/module/app/misc/SignatureVerifier.h>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+
+class SignatureVerifierImp : public SignatureVerifier
+{
+public:
+    // The most checks a job takes from the queue at once
+    static std::size_t const batchSize = 16;
+
+    struct Item
+    {
+        uint256 hash;
+        Check check;
+        Handler handler;
+    };
+
+    typedef std::lock_guard <std::mutex> ScopedLock;
+
+    JobQueue& m_jobQueue;
+    IHashRouter& m_router;
+    beast::Journal m_journal;
+    std::mutex m_mutex;
+    std::deque <Item> m_queue;
+
+    SignatureVerifierImp (JobQueue& jobQueue, IHashRouter& router,
+        beast::Journal journal)
+        : SignatureVerifier (jobQueue)
+        , m_jobQueue (jobQueue)
+        , m_router (router)
+        , m_journal (journal)
+    {
+    }
+
+    ~SignatureVerifierImp ()
+    {
+    }
+
+    void verify (uint256 const& hash,
+        Check const& check, Handler const& handler)
+    {
+        if (isStopping ())
+            return;
+
+        bool signal;
+
+        {
+            ScopedLock lock (m_mutex);
+
+            Item item = { hash, check, handler };
+            m_queue.push_back (std::move (item));
+
+            // One job for every batch that is started. A job takes up
+            // to a full batch, so every queued check has a job waiting
+            // to run it.
+            signal = (m_queue.size () % batchSize) == 1;
+        }
+
+        if (signal)
+            m_jobQueue.addJob (jtSIGCHECK, "SignatureVerifier",
+                std::bind (&SignatureVerifierImp::processBatch, this,
+                    std::placeholders::_1));
+    }
+
+    std::size_t size ()
+    {
+        ScopedLock lock (m_mutex);
+        return m_queue.size ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void processBatch (Job&)
+    {
+        std::vector <Item> batch;
+        batch.reserve (batchSize);
+
+        {
+            ScopedLock lock (m_mutex);
+
+            while (! m_queue.empty () && batch.size () < batchSize)
+            {
+                batch.push_back (std::move (m_queue.front ()));
+                m_queue.pop_front ();
+            }
+        }
+
+        for (auto& item : batch)
+        {
+            if (isStopping ())
+                return;
+
+            item.handler (process (item));
+        }
+    }
+
+    bool process (Item const& item)
+    {
+        // Another check of the same hash may have finished first
+        int const flags (m_router.getFlags (item.hash));
+
+        if (flags & SF_BAD)
+            return false;
+
+        if (flags & SF_SIGGOOD)
+            return true;
+
+        bool good;
+
+        try
+        {
+            good = item.check ();
+        }
+        catch (...)
+        {
+            m_journal.warning << "Exception checking signature of " <<
+                item.hash;
+            good = false;
+        }
+
+        m_router.setFlag (item.hash, good ? SF_SIGGOOD : SF_BAD);
+
+        return good;
+    }
+
+    //--------------------------------------------------------------------------
+
+    void onStop ()
+    {
+        // A batch job already queued finds nothing to do. The JobQueue,
+        // our parent, waits for any batch that is running.
+        {
+            ScopedLock lock (m_mutex);
+            m_queue.clear ();
+        }
+
+        stopped ();
+    }
+};
+
+//------------------------------------------------------------------------------
+
+SignatureVerifier::SignatureVerifier (Stoppable& parent)
+    : Stoppable ("SignatureVerifier", parent)
+{
+}
+
+std::unique_ptr <SignatureVerifier> make_SignatureVerifier (
+    JobQueue& jobQueue, IHashRouter& router, beast::Journal journal)
+{
+    return std::make_unique <SignatureVerifierImp> (jobQueue, router, journal);
+}
+
+}
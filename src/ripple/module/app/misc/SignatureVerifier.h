@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_SIGNATUREVERIFIER_H_INCLUDED
+#define RIPPLE_SIGNATUREVERIFIER_H_INCLUDED
+
+#include <beast/threads/Stoppable.h>
+#include <beast/utility/Journal.h>
+
+#include <functional>
+#include <memory>
+
+namespace ripple {
+
+class IHashRouter;
+class JobQueue;
+
+/** Checks signatures of inbound objects in batches on the JobQueue.
+
+    Signature checks are the most expensive part of accepting a transaction
+    or validation from a peer. Pending checks are grouped into batches of
+    up to 16, and each batch runs as one jtSIGCHECK job. The limit on that
+    job type bounds how many batches run at once, leaving the remaining
+    JobQueue threads free for ledger work.
+
+    Each signature in a batch is still verified on its own. Batching only
+    saves queueing a job per check and spreads a burst over the threads
+    the limit allows.
+
+    Results are recorded in the HashRouter using SF_SIGGOOD and SF_BAD, so a
+    hash that has already been checked is never checked again.
+*/
+class SignatureVerifier : public beast::Stoppable
+{
+protected:
+    explicit SignatureVerifier (Stoppable& parent);
+
+public:
+    /** Performs the signature check, returning `true` if it passed. */
+    typedef std::function <bool (void)> Check;
+
+    /** Receives the outcome of a check.
+        This is called from the batch's job and should return quickly,
+        typically by adding a job to the JobQueue.
+    */
+    typedef std::function <void (bool)> Handler;
+
+    virtual ~SignatureVerifier () { }
+
+    /** Queue a signature check.
+
+        If the HashRouter already has a result for the hash, the check is
+        not performed and the recorded result is passed to the handler.
+        Once the verifier is stopping new checks are discarded and their
+        handlers are never called.
+
+        @note This function is thread-safe.
+        @param hash The HashRouter key of the object being checked.
+        @param check The function which performs the check.
+        @param handler The function which receives the result.
+    */
+    virtual void verify (uint256 const& hash,
+        Check const& check, Handler const& handler) = 0;
+
+    /** Returns the number of checks waiting for a job to run them. */
+    virtual std::size_t size () = 0;
+};
+
+std::unique_ptr <SignatureVerifier> make_SignatureVerifier (
+    JobQueue& jobQueue, IHashRouter& router, beast::Journal journal);
+
+}
+
+#endif
@@ -111,6 +111,44 @@ public:
         return result;
     }
 
+    NodeStore::Status fetchBatch (std::vector <uint256 const*> const& keys,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        objects.clear ();
+        objects.reserve (keys.size ());
+
+        {
+            // Take the lock once for the whole batch instead of per key
+            auto sl (m_db->lock());
+
+            static SqliteStatement pSt (m_db->getDB()->getSqliteDB(),
+                "SELECT ObjType,LedgerIndex,Object FROM CommittedObjects WHERE Hash = ?;");
+
+            for (auto const key : keys)
+            {
+                NodeObject::Ptr object;
+
+                pSt.bind (1, to_string (*key));
+
+                if (pSt.isRow (pSt.step()))
+                {
+                    Blob data (pSt.getBlob (2));
+                    object = NodeObject::createObject (
+                        getTypeFromString (pSt.peekString (0)),
+                        pSt.getUInt32 (1),
+                        std::move(data),
+                        *key);
+                }
+
+                pSt.reset();
+
+                objects.push_back (object);
+            }
+        }
+
+        return NodeStore::ok;
+    }
+
     void store (NodeObject::ref object)
     {
         NodeStore::Batch batch;
@@ -120,6 +158,11 @@ public:
         storeBatch (batch);
     }
 
+    void queueBatch (NodeStore::Batch const& batch)
+    {
+        storeBatch (batch);
+    }
+
     void storeBatch (NodeStore::Batch const& batch)
     {
         // VFALCO TODO Rewrite this to use Beast::db
@@ -34,8 +34,21 @@ RippleLineCache::pointer PathRequests::getLineCache (Ledger::pointer& ledger, bo
          (authoritative && ((lgrSeq + 8)  < lineSeq)) ||   // we jumped way back for some reason
          (lgrSeq > (lineSeq + 8)))                         // we jumped way forward for some reason
     {
+        hash_set <Account> changed;
+
+        // If this ledger directly follows the cached one, keep the
+        // lines of every account its transactions didn't touch
+        bool const follows = (lineSeq != 0) && (lgrSeq == (lineSeq + 1)) &&
+            (ledger->getParentHash () == mLineCache->getLedger ()->getHash ()) &&
+            RippleLineCache::getChangedAccounts (ledger, changed);
+
         ledger = std::make_shared<Ledger>(*ledger, false); // Take a snapshot of the ledger
-        mLineCache = std::make_shared<RippleLineCache> (ledger);
+
+        if (follows)
+            mLineCache = std::make_shared<RippleLineCache> (
+                ledger, *mLineCache, changed);
+        else
+            mLineCache = std::make_shared<RippleLineCache> (ledger);
     }
     else
     {
@@ -44,6 +57,125 @@ RippleLineCache::pointer PathRequests::getLineCache (Ledger::pointer& ledger, bo
     return mLineCache;
 }
 
+// One pass over the path requests, shared by the threads working on it
+struct PathRequests::UpdatePass
+{
+    UpdatePass (std::vector<PathRequest::wptr> const& requests_,
+            RippleLineCache::ref cache_, LedgerIndex ledgerSeq_, bool newRequests_)
+        : requests (requests_)
+        , cache (cache_)
+        , ledgerSeq (ledgerSeq_)
+        , newRequests (newRequests_)
+        , next (0)
+        , stop (false)
+        , mustBreak (false)
+        , processed (0)
+        , removed (0)
+        , active (0)
+    {
+    }
+
+    std::vector<PathRequest::wptr> const requests;
+    RippleLineCache::pointer const cache;
+    LedgerIndex const ledgerSeq;
+    bool const newRequests;
+
+    std::atomic<std::size_t> next;          // next request to claim
+    std::atomic<bool> stop;                 // claim no more requests
+    std::atomic<bool> mustBreak;            // a new request came in
+    std::atomic<int> processed;
+    std::atomic<int> removed;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    int active;                             // threads working on the pass
+};
+
+void PathRequests::updatePass (UpdatePass& pass, Job::CancelCallback shouldCancel)
+{
+    {
+        std::lock_guard<std::mutex> sl (pass.mutex);
+        ++pass.active;
+    }
+
+    while (!pass.stop)
+    {
+        std::size_t const i = pass.next++;
+
+        if (i >= pass.requests.size ())
+            break;
+
+        if (shouldCancel ())
+        {
+            pass.stop = true;
+            break;
+        }
+
+        updateRequest (pass, pass.requests[i]);
+
+        if (!pass.newRequests && getApp().getLedgerMaster().isNewPathRequest())
+        {
+            // We weren't handling new requests and then there was a new request
+            pass.mustBreak = true;
+            pass.stop = true;
+        }
+    }
+
+    std::lock_guard<std::mutex> sl (pass.mutex);
+    if (--pass.active == 0)
+        pass.cond.notify_all ();
+}
+
+void PathRequests::updateRequest (UpdatePass& pass, PathRequest::wref wRequest)
+{
+    bool remove = true;
+    PathRequest::pointer pRequest = wRequest.lock ();
+
+    if (pRequest)
+    {
+        if (!pRequest->needsUpdate (pass.newRequests, pass.ledgerSeq))
+            remove = false;
+        else
+        {
+            InfoSub::pointer ipSub = pRequest->getSubscriber ();
+            if (ipSub)
+            {
+                ipSub->getConsumer ().charge (Resource::feePathFindUpdate);
+                if (!ipSub->getConsumer ().warn ())
+                {
+                    Json::Value update = pRequest->doUpdate (pass.cache, false);
+                    pRequest->updateComplete ();
+                    update["type"] = "path_find";
+                    ipSub->send (update, false);
+                    remove = false;
+                    ++pass.processed;
+                }
+            }
+        }
+    }
+
+    if (remove)
+    {
+        PathRequest::pointer pRequest = wRequest.lock ();
+
+        ScopedLockType sl (mLock);
+
+        // Remove any dangling weak pointers or weak pointers that refer to this path request.
+        std::vector<PathRequest::wptr>::iterator it = mRequests.begin();
+        while (it != mRequests.end())
+        {
+            PathRequest::pointer itRequest = it->lock ();
+            if (!itRequest || (itRequest == pRequest))
+            {
+                ++pass.removed;
+                it = mRequests.erase (it);
+            }
+            else
+                ++it;
+        }
+    }
+}
+
 void PathRequests::updateAll (Ledger::ref inLedger,
                               Job::CancelCallback shouldCancel)
 {
@@ -61,7 +193,6 @@ void PathRequests::updateAll (Ledger::ref inLedger,
     }
 
     bool newRequests = getApp().getLedgerMaster().isNewPathRequest();
-    bool mustBreak = false;
 
     mJournal.trace << "updateAll seq=" << ledger->getLedgerSeq() << ", " <<
         requests.size() << " requests";
@@ -69,66 +200,35 @@ void PathRequests::updateAll (Ledger::ref inLedger,
 
     do
     {
+        auto pass = std::make_shared<UpdatePass> (
+            requests, cache, ledger->getLedgerSeq (), newRequests);
 
-        BOOST_FOREACH (PathRequest::wref wRequest, requests)
-        {
-            if (shouldCancel())
-                break;
-
-            bool remove = true;
-            PathRequest::pointer pRequest = wRequest.lock ();
-
-            if (pRequest)
-            {
-                if (!pRequest->needsUpdate (newRequests, ledger->getLedgerSeq ()))
-                    remove = false;
-                else
-                {
-                    InfoSub::pointer ipSub = pRequest->getSubscriber ();
-                    if (ipSub)
-                    {
-                        ipSub->getConsumer ().charge (Resource::feePathFindUpdate);
-                        if (!ipSub->getConsumer ().warn ())
-                        {
-                            Json::Value update = pRequest->doUpdate (cache, false);
-                            pRequest->updateComplete ();
-                            update["type"] = "path_find";
-                            ipSub->send (update, false);
-                            remove = false;
-                            ++processed;
-                        }
-                    }
-                }
-            }
-
-            if (remove)
-            {
-                PathRequest::pointer pRequest = wRequest.lock ();
-
-                ScopedLockType sl (mLock);
+        // Requests are claimed one at a time in list order, so new
+        // requests, which are kept at the front, are still started first.
+        // Helpers that start after the pass is over find nothing to do.
+        std::size_t const threads = std::min <std::size_t> (
+            requests.size (), std::thread::hardware_concurrency ());
 
-                // Remove any dangling weak pointers or weak pointers that refer to this path request.
-                std::vector<PathRequest::wptr>::iterator it = mRequests.begin();
-                while (it != mRequests.end())
+        for (std::size_t i = 1; i < threads; ++i)
+        {
+            getApp().getJobQueue().addJob (jtUPDATE_PF, "PathRequests::update",
+                [this, pass] (Job& job)
                 {
-                    PathRequest::pointer itRequest = it->lock ();
-                    if (!itRequest || (itRequest == pRequest))
-                    {
-                        ++removed;
-                        it = mRequests.erase (it);
-                    }
-                    else
-                        ++it;
-                }
-            }
+                    updatePass (*pass, job.getCancelCallback ());
+                });
+        }
 
-            mustBreak = !newRequests && getApp().getLedgerMaster().isNewPathRequest();
-            if (mustBreak) // We weren't handling new requests and then there was a new request
-                break;
+        updatePass (*pass, shouldCancel);
 
+        {
+            std::unique_lock<std::mutex> sl (pass->mutex);
+            pass->cond.wait (sl, [&pass] { return pass->active == 0; });
         }
 
-        if (mustBreak)
+        processed += pass->processed;
+        removed += pass->removed;
+
+        if (pass->mustBreak)
         { // a new request came in while we were working
             newRequests = true;
         }
@@ -21,6 +21,8 @@
 #define RIPPLE_PATHREQUESTS_H
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace ripple {
 
@@ -35,6 +37,10 @@ public:
         mFull = collector->make_event ("pathfind_full");
     }
 
+    /** Update the path requests that need it for a ledger.
+        The requests are shared out between this thread and helper jobs.
+        This returns once all of them are done or the job is cancelled.
+    */
     void updateAll (const std::shared_ptr<Ledger>& ledger,
                     Job::CancelCallback shouldCancel);
 
@@ -57,6 +63,13 @@ public:
     }
 
 private:
+    struct UpdatePass;
+
+    // Claim and update requests until the pass runs out of them
+    void updatePass (UpdatePass& pass, Job::CancelCallback shouldCancel);
+
+    void updateRequest (UpdatePass& pass, PathRequest::wref request);
+
     beast::Journal                   mJournal;
 
     beast::insight::Event            mFast;
@@ -17,6 +17,8 @@
 */
 //==============================================================================
 
+#include <beast/unit_test/suite.h>
+
 namespace ripple {
 
 RippleLineCache::RippleLineCache (Ledger::ref l)
@@ -24,6 +26,73 @@ RippleLineCache::RippleLineCache (Ledger::ref l)
 {
 }
 
+RippleLineCache::RippleLineCache (Ledger::ref l, RippleLineCache& previous,
+    hash_set <Account> const& changed)
+    : mLedger (l)
+{
+    ScopedLockType sl (previous.mLock);
+
+    for (auto const& lines : previous.mRLMap)
+    {
+        if (changed.find (lines.first) == changed.end ())
+            mRLMap.insert (lines);
+    }
+}
+
+bool RippleLineCache::getChangedAccounts (Ledger::ref ledger,
+    hash_set <Account>& changed)
+{
+    if (!ledger->isClosed ())
+        return false;
+
+    try
+    {
+        auto const accepted = AcceptedLedger::makeAcceptedLedger (ledger);
+
+        for (auto const& item : accepted->getMap ())
+        {
+            if (!getChangedAccounts (item.second->getMeta ()->getNodes (), changed))
+                return false;
+        }
+    }
+    catch (std::exception const&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool RippleLineCache::getChangedAccounts (STArray const& nodes,
+    hash_set <Account>& changed)
+{
+    for (auto const& node : nodes)
+    {
+        if (!node.isFieldPresent (sfLedgerEntryType))
+            return false;
+
+        if (node.getFieldU16 (sfLedgerEntryType) != ltRIPPLE_STATE)
+            continue;
+
+        // A deleted or modified line has final fields, a new one
+        // only has new fields
+        auto fields = dynamic_cast <STObject const*> (node.peekAtPField (
+            (node.getFName () == sfCreatedNode) ? sfNewFields : sfFinalFields));
+
+        if ((fields == nullptr) ||
+            !fields->isFieldPresent (sfLowLimit) ||
+            !fields->isFieldPresent (sfHighLimit))
+        {
+            return false;
+        }
+
+        changed.insert (fields->getFieldAmount (sfLowLimit).getIssuer ());
+        changed.insert (fields->getFieldAmount (sfHighLimit).getIssuer ());
+    }
+
+    return true;
+}
+
 std::vector<RippleState::pointer> const&
 RippleLineCache::getRippleLines (Account const& accountID)
 {
@@ -38,4 +107,81 @@ RippleLineCache::getRippleLines (Account const& accountID)
     return it->second;
 }
 
+//------------------------------------------------------------------------------
+
+class RippleLineCache_test : public beast::unit_test::suite
+{
+public:
+    static STObject line (SField::ref type, SField::ref fields,
+        Account const& low, Account const& high)
+    {
+        Currency const usd (1);
+
+        STObject limits (fields);
+        limits.setFieldAmount (sfLowLimit, STAmount (Issue (usd, low), 100));
+        limits.setFieldAmount (sfHighLimit, STAmount (Issue (usd, high), 0));
+
+        STObject node (type);
+        node.setFieldU16 (sfLedgerEntryType, ltRIPPLE_STATE);
+        node.addObject (limits);
+        return node;
+    }
+
+    void testCarryOver ()
+    {
+        testcase ("carry over");
+
+        Account const alice (1), bob (2), carol (3), dan (4);
+
+        STArray nodes;
+        nodes.push_back (line (sfCreatedNode, sfNewFields, alice, bob));
+        nodes.push_back (line (sfModifiedNode, sfFinalFields, carol, bob));
+
+        STObject root (sfModifiedNode);
+        root.setFieldU16 (sfLedgerEntryType, ltACCOUNT_ROOT);
+        nodes.push_back (root);
+
+        hash_set <Account> changed;
+        expect (RippleLineCache::getChangedAccounts (nodes, changed));
+
+        // Only the accounts on a changed line are loaded again
+        expect (changed.size () == 3);
+        expect (changed.count (alice) == 1);
+        expect (changed.count (bob) == 1);
+        expect (changed.count (carol) == 1);
+        expect (changed.count (dan) == 0);
+    }
+
+    void testMissingFields ()
+    {
+        testcase ("missing fields");
+
+        // A deleted line only has final fields
+        STArray nodes;
+        nodes.push_back (line (sfDeletedNode, sfNewFields, Account (1), Account (2)));
+
+        hash_set <Account> changed;
+        expect (!RippleLineCache::getChangedAccounts (nodes, changed));
+
+        STObject limits (sfFinalFields);
+        limits.setFieldAmount (sfLowLimit, STAmount (Issue (Currency (1), Account (1)), 100));
+
+        STObject node (sfModifiedNode);
+        node.setFieldU16 (sfLedgerEntryType, ltRIPPLE_STATE);
+        node.addObject (limits);
+
+        nodes.clear ();
+        nodes.push_back (node);
+        expect (!RippleLineCache::getChangedAccounts (nodes, changed));
+    }
+
+    void run ()
+    {
+        testCarryOver ();
+        testMissingFields ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(RippleLineCache,ripple_app,ripple);
+
 } // ripple
@@ -31,6 +31,27 @@ public:
 
     explicit RippleLineCache (Ledger::ref l);
 
+    /** Create a cache for a ledger that follows another cache's ledger.
+        The lines already loaded into `previous` are carried over, except
+        for accounts in `changed`. Those are loaded again when asked for.
+    */
+    RippleLineCache (Ledger::ref l, RippleLineCache& previous,
+        hash_set <Account> const& changed);
+
+    /** Collect the accounts on either end of the trust lines that a
+        closed ledger's transactions created, modified or deleted.
+        @return `false` if the ledger's metadata could not be read.
+    */
+    static bool getChangedAccounts (Ledger::ref ledger,
+        hash_set <Account>& changed);
+
+    /** Collect the changed trust line accounts from one transaction's
+        affected nodes.
+        @return `false` if a trust line node lacks its limits.
+    */
+    static bool getChangedAccounts (STArray const& nodes,
+        hash_set <Account>& changed);
+
     Ledger::ref getLedger () // VFALCO TODO const?
     {
         return mLedger;
@@ -18,6 +18,10 @@
 //==============================================================================
 
 #include <ripple/nodestore/Database.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <beast/unit_test/suite.h>
 #include <beast/chrono/manual_clock.h>
 
@@ -46,13 +50,9 @@ SHAMap::SHAMap (
     , m_missing_node_handler (missing_node_handler)
 {
     assert (mSeq != 0);
-    if (t == smtSTATE)
-        mTNByID.rehash (STATE_MAP_BUCKETS);
 
-    SHAMapNodeID rootID{};
     root = std::make_shared<SHAMapTreeNode> (mSeq);
     root->makeInner ();
-    mTNByID.replace(rootID, root);
 }
 
 SHAMap::SHAMap (
@@ -70,23 +70,14 @@ SHAMap::SHAMap (
     , mTXMap (false)
     , m_missing_node_handler (missing_node_handler)
 {
-    if (t == smtSTATE)
-        mTNByID.rehash (STATE_MAP_BUCKETS);
-
-    SHAMapNodeID rootID{};
     root = std::make_shared<SHAMapTreeNode> (mSeq);
     root->makeInner ();
-    mTNByID.replace(rootID, root);
 }
 
 SHAMap::~SHAMap ()
 {
     mState = smsInvalid;
 
-    logTimedDestroy <SHAMap> (mTNByID,
-        beast::String ("mTNByID with ") +
-            beast::String::fromNumber (mTNByID.size ()) + " items");
-
     if (mDirtyNodes)
     {
         logTimedDestroy <SHAMap> (mDirtyNodes,
@@ -116,6 +107,34 @@ void SHAMapNodeID::setMHash () const
     mHash = h;
 }
 
+std::size_t SHAMap::size () const
+{
+    ScopedReadLockType sl (mLock);
+
+    std::size_t count = 0;
+    std::stack<SHAMapTreeNode*> stack;
+    stack.push (root.get ());
+
+    while (!stack.empty ())
+    {
+        SHAMapTreeNode* node = stack.top ();
+        stack.pop ();
+        ++count;
+
+        if (node->isInner ())
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                SHAMapTreeNode* child = node->getChildPointer (i);
+                if (child)
+                    stack.push (child);
+            }
+        }
+    }
+
+    return count;
+}
+
 SHAMap::pointer SHAMap::snapShot (bool isMutable)
 {
     SHAMap::pointer ret = std::make_shared<SHAMap> (mType,
@@ -123,47 +142,33 @@ SHAMap::pointer SHAMap::snapShot (bool isMutable)
     SHAMap& newMap = *ret;
 
     // Return a new SHAMap that is a snapshot of this one
-    // Initially most nodes are shared and CoW is forced where needed
+    // All nodes are shared and CoW is forced where needed
     {
-        ScopedReadLockType sl (mLock);
+        ScopedWriteLockType sl (mLock);
+
+        // A map only modifies in place the nodes whose sequence number
+        // matches its own. Moving both maps past every node in the tree
+        // makes all of them shared, so each map copies a node the first
+        // time it writes to it. Nothing needs to be copied now.
+        ++mSeq;
         newMap.mSeq = mSeq;
-        newMap.mTNByID = mTNByID;
         newMap.root = root;
 
         if (!isMutable)
             newMap.mState = smsImmutable;
-
-        // If the existing map has any nodes it might modify, unshare ours now
-        if (mState != smsImmutable)
-        {
-            for (NodeMap::value_type& nodeIt : mTNByID.peekMap())
-            {
-                if (nodeIt.second->getSeq() == mSeq)
-                { // We might modify this node, so duplicate it in the snapShot
-                    SHAMapTreeNode::pointer newNode = std::make_shared<SHAMapTreeNode> (*nodeIt.second, mSeq);
-                    SHAMapNodeID const& newNodeID = nodeIt.first;
-                    newMap.mTNByID.replace (newNodeID, newNode);
-                    if (newNodeID.isRoot ())
-                        newMap.root = newNode;
-                }
-            }
-        }
-        else if (isMutable) // Need to unshare on changes to the snapshot
-            ++newMap.mSeq;
     }
 
     return ret;
 }
 
-std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>>
+SHAMap::SharedPtrNodeStack
 SHAMap::getStack (uint256 const& id, bool include_nonmatching_leaf)
 {
     // Walk the tree as far as possible to the specified identifier
     // produce a stack of nodes along the way, with the terminal node at the top
-    std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>> stack;
+    SharedPtrNodeStack stack;
     SHAMapTreeNode::pointer node = root;
     SHAMapNodeID nodeID;
-    uint256 nodeHash;
 
     while (!node->isLeaf ())
     {
@@ -172,10 +177,11 @@ SHAMap::getStack (uint256 const& id, bool include_nonmatching_leaf)
         int branch = nodeID.selectBranch (id);
         assert (branch >= 0);
 
-        if (!node->descend (branch, nodeID, nodeHash))
+        if (node->isEmptyBranch (branch))
             return stack;
 
-        node = getNode (nodeID, nodeHash, false);
+        node = descendThrow (node, nodeID, branch);
+        nodeID = nodeID.getChildNodeID (branch);
     }
 
     if (include_nonmatching_leaf || (node->peekItem ()->getTag () == id))
@@ -185,13 +191,14 @@ SHAMap::getStack (uint256 const& id, bool include_nonmatching_leaf)
 }
 
 void
-SHAMap::dirtyUp (std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>>& stack,
-                 uint256 const& target, uint256 prevHash)
+SHAMap::dirtyUp (SharedPtrNodeStack& stack,
+                 uint256 const& target, SHAMapTreeNode::pointer child)
 {
     // walk the tree up from through the inner nodes to the root
-    // update linking hashes and add nodes to dirty list
+    // update linking hashes and child pointers, add nodes to dirty list
 
     assert ((mState != smsSynching) && (mState != smsImmutable));
+    assert (child && (child->getSeq () == mSeq));
 
     while (!stack.empty ())
     {
@@ -203,169 +210,143 @@ SHAMap::dirtyUp (std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>>& s
         int branch = nodeID.selectBranch (target);
         assert (branch >= 0);
 
-        returnNode (node, nodeID, true);
+        unshareNode (node, nodeID);
 
-        if (!node->setChildHash (branch, prevHash))
-        {
-            WriteLog (lsFATAL, SHAMap) << "dirtyUp terminates early";
-            assert (false);
-            return;
-        }
+        // Even if the hash is unchanged, the child may be a new copy
+        // so we must keep linking all the way up to the root
+        node->setChild (branch, child->getNodeHash (), child);
 
 #ifdef ST_DEBUG
-        WriteLog (lsTRACE, SHAMap) << "dirtyUp sets branch " << branch << " to " << prevHash;
+        WriteLog (lsTRACE, SHAMap) << "dirtyUp sets branch " << branch << " to " << child->getNodeHash ();
 #endif
-        prevHash = node->getNodeHash ();
-        assert (prevHash.isNonZero ());
+        child = std::move (node);
+        assert (child->getNodeHash ().isNonZero ());
     }
-}
 
-SHAMapTreeNode::pointer SHAMap::checkCacheNode (const SHAMapNodeID& iNode)
-{
-    SHAMapTreeNode::pointer ret = mTNByID.retrieve(iNode);
-    if (ret && (ret->getSeq()!= 0))
-        ret->touch (mSeq);
-    return ret;
-}
-
-SHAMapTreeNode::pointer SHAMap::walkTo (uint256 const& id, bool modify)
-{
-    // walk down to the terminal node for this ID
-
-    SHAMapTreeNode::pointer inNode = root;
-    SHAMapNodeID nodeID;
-    uint256 nodeHash;
-
-    while (!inNode->isLeaf ())
-    {
-        int branch = nodeID.selectBranch (id);
-
-        if (!inNode->descend (branch, nodeID, nodeHash))
-            return inNode;
-
-        inNode = getNode (nodeID, nodeHash, false);
-    }
-
-    if (inNode->getTag () != id)
-        return SHAMapTreeNode::pointer ();
-
-    if (modify)
-        returnNode (inNode, nodeID, true);
-
-    return inNode;
+    root = std::move (child);
 }
 
 SHAMapTreeNode* SHAMap::walkToPointer (uint256 const& id)
 {
     SHAMapTreeNode* inNode = root.get ();
     SHAMapNodeID nodeID;
-    uint256 nodeHash;
 
     while (!inNode->isLeaf ())
     {
         int branch = nodeID.selectBranch (id);
 
-        if (!inNode->descend (branch, nodeID, nodeHash))
+        if (inNode->isEmptyBranch (branch))
             return nullptr;
 
-        inNode = getNodePointer (nodeID, nodeHash);
-        assert (inNode);
+        inNode = descendThrow (inNode, nodeID, branch);
+        nodeID = nodeID.getChildNodeID (branch);
     }
 
     return (inNode->getTag () == id) ? inNode : nullptr;
 }
 
-SHAMapTreeNode::pointer SHAMap::getNode (const SHAMapNodeID& id, uint256 const& hash, bool modify)
+SHAMapTreeNode::pointer SHAMap::fetchNodeExternal (const SHAMapNodeID& id, uint256 const& hash)
 {
-    // retrieve a node whose node hash is known
-    SHAMapTreeNode::pointer node = checkCacheNode (id);
+    SHAMapTreeNode::pointer ret = fetchNodeExternalNT (hash);
 
-    if (node)
-    {
-#if BEAST_DEBUG
-
-        if (node->getNodeHash () != hash)
-        {
-            WriteLog (lsFATAL, SHAMap) << "Attempt to get node, hash not in tree";
-            WriteLog (lsFATAL, SHAMap) << "ID: " << id;
-            WriteLog (lsFATAL, SHAMap) << "TgtHash " << hash;
-            WriteLog (lsFATAL, SHAMap) << "NodHash " << node->getNodeHash ();
-            throw std::runtime_error ("invalid node");
-        }
-
-#endif
-        returnNode (node, id, modify);
-        return node;
-    }
+    if (!ret)
+        throw (SHAMapMissingNode (mType, id, hash));
 
-    return fetchNodeExternal (id, hash);
+    return ret;
 }
 
-SHAMapTreeNode* SHAMap::getNodePointer (const SHAMapNodeID& id, uint256 const& hash)
+SHAMapTreeNode*
+SHAMap::descendThrow (SHAMapTreeNode* parent, SHAMapNodeID const& parentID, int branch)
 {
-    // fast, but you do not hold a reference
-    SHAMapTreeNode* ret = getNodePointerNT (id, hash);
+    SHAMapTreeNode* ret = descend (parent, branch);
 
-    if (!ret)
-        throw (SHAMapMissingNode (mType, id, hash));
+    if (!ret && !parent->isEmptyBranch (branch))
+        throw (SHAMapMissingNode (mType, parentID.getChildNodeID (branch),
+                                  parent->getChildHash (branch)));
 
     return ret;
 }
 
-SHAMapTreeNode* SHAMap::getNodePointerNT (const SHAMapNodeID& id, uint256 const& hash)
+SHAMapTreeNode::pointer
+SHAMap::descendThrow (SHAMapTreeNode::ref parent, SHAMapNodeID const& parentID, int branch)
 {
-    SHAMapTreeNode::pointer ret = mTNByID.retrieve (id);
-    if (!ret)
-        ret = fetchNodeExternalNT (id, hash);
-    return ret ? ret.get() : nullptr;
+    SHAMapTreeNode::pointer ret = parent->getChild (branch);
+
+    if (!ret && !parent->isEmptyBranch (branch))
+    {
+        ret = fetchNodeExternal (parentID.getChildNodeID (branch),
+                                 parent->getChildHash (branch));
+        parent->canonicalizeChild (branch, ret);
+    }
+
+    return ret;
 }
 
-SHAMapTreeNode* SHAMap::getNodePointer (const SHAMapNodeID& id, uint256 const& hash, SHAMapSyncFilter* filter)
+SHAMapTreeNode* SHAMap::descend (SHAMapTreeNode* parent, int branch)
 {
-    SHAMapTreeNode* ret = getNodePointerNT (id, hash, filter);
+    SHAMapTreeNode* ret = parent->getChildPointer (branch);
 
-    if (!ret)
-        throw (SHAMapMissingNode (mType, id, hash));
+    if (ret || parent->isEmptyBranch (branch))
+        return ret;
 
-    return ret;
+    SHAMapTreeNode::pointer node = fetchNodeExternalNT (parent->getChildHash (branch));
+
+    if (!node)
+        return nullptr;
+
+    parent->canonicalizeChild (branch, node);
+    return node.get ();
 }
 
-SHAMapTreeNode* SHAMap::getNodePointerNT (const SHAMapNodeID& id, uint256 const& hash, SHAMapSyncFilter* filter)
+SHAMapTreeNode*
+SHAMap::descend (SHAMapTreeNode* parent, SHAMapNodeID const& childID,
+                 int branch, SHAMapSyncFilter* filter)
 {
-    SHAMapTreeNode* node = getNodePointerNT (id, hash);
+    SHAMapTreeNode* ret = descend (parent, branch);
 
-    if (!node && filter)
+    if (!ret && filter && !parent->isEmptyBranch (branch))
     { // Our regular node store didn't have the node. See if the filter does
+        uint256 const& childHash = parent->getChildHash (branch);
         Blob nodeData;
 
-        if (filter->haveNode (id, hash, nodeData))
+        if (filter->haveNode (childID, childHash, nodeData))
         {
             SHAMapTreeNode::pointer node = std::make_shared<SHAMapTreeNode> (
-                    nodeData, 0, snfPREFIX, hash, true);
-            canonicalize (hash, node);
+                    nodeData, 0, snfPREFIX, childHash, true);
+            canonicalize (childHash, node);
 
-            // Canonicalize the node with mTNByID to make sure all threads gets the same node
-            // If the node is new, tell the filter
-            if (mTNByID.canonicalize (id, &node))
-                filter->gotNode (true, id, hash, nodeData, node->getType ());
+            // Canonicalize the node with its parent to make sure all threads
+            // get the same node. If the node is new, tell the filter
+            if (parent->canonicalizeChild (branch, node))
+                filter->gotNode (true, childID, childHash, nodeData, node->getType ());
 
-            return node.get ();
+            ret = node.get ();
         }
     }
 
-    return node;
+    return ret;
 }
 
+SHAMapTreeNode::pointer
+SHAMap::descendNoStore (SHAMapTreeNode::ref parent, SHAMapNodeID const& parentID, int branch)
+{
+    SHAMapTreeNode::pointer ret = parent->getChild (branch);
+
+    if (!ret && !parent->isEmptyBranch (branch))
+        ret = fetchNodeExternal (parentID.getChildNodeID (branch),
+                                 parent->getChildHash (branch));
+
+    return ret;
+}
 
 void
-SHAMap::returnNode (SHAMapTreeNode::pointer& node, SHAMapNodeID const& nodeID,
-                                                                    bool modify)
+SHAMap::unshareNode (SHAMapTreeNode::pointer& node, SHAMapNodeID const& nodeID)
 {
     // make sure the node is suitable for the intended operation (copy on write)
     assert (node->isValid ());
     assert (node->getSeq () <= mSeq);
 
-    if (node && modify && (node->getSeq () != mSeq))
+    if (node->getSeq () != mSeq)
     {
         // have a CoW
         assert (node->getSeq () < mSeq);
@@ -374,20 +355,13 @@ SHAMap::returnNode (SHAMapTreeNode::pointer& node, SHAMapNodeID const& nodeID,
         node = std::make_shared<SHAMapTreeNode> (*node, mSeq); // here's to the new node, same as the old node
         assert (node->isValid ());
 
-        mTNByID.replace (nodeID, node);
-
-        if (nodeID.isRoot ())
-            root = node;
-
         if (mDirtyNodes)
             mDirtyNodes->insert (nodeID);
     }
 }
 
-void SHAMap::trackNewNode (SHAMapTreeNode::pointer& node,
-                           SHAMapNodeID const& nodeID)
+void SHAMap::trackNewNode (SHAMapNodeID const& nodeID)
 {
-    assert (node->getSeq() == mSeq);
     if (mDirtyNodes)
         mDirtyNodes->insert (nodeID);
 }
@@ -405,10 +379,10 @@ SHAMap::firstBelow (SHAMapTreeNode* node, SHAMapNodeID nodeID)
         bool foundNode = false;
         for (int i = 0; i < 16; ++i)
         {
-            uint256 nodeHash;
-            if (node->descend (i, nodeID, nodeHash))
+            if (!node->isEmptyBranch (i))
             {
-                node = getNodePointer (nodeID, nodeHash);
+                node = descendThrow (node, nodeID, i);
+                nodeID = nodeID.getChildNodeID (i);
                 foundNode = true;
                 break;
             }
@@ -430,10 +404,10 @@ SHAMap::lastBelow (SHAMapTreeNode* node, SHAMapNodeID nodeID)
         bool foundNode = false;
         for (int i = 15; i >= 0; --i)
         {
-            uint256 nodeHash;
-            if (node->descend (i, nodeID, nodeHash))
+            if (!node->isEmptyBranch (i))
             {
-                node = getNodePointer (nodeID, nodeHash);
+                node = descendThrow (node, nodeID, i);
+                nodeID = nodeID.getChildNodeID (i);
                 foundNode = true;
                 break;
             }
@@ -454,14 +428,12 @@ SHAMap::onlyBelow (SHAMapTreeNode* node, SHAMapNodeID nodeID)
         SHAMapNodeID nextNodeID;
         for (int i = 0; i < 16; ++i)
         {
-            SHAMapNodeID tempNodeID = nodeID;
-            uint256 nodeHash;
-            if (node->descend (i, tempNodeID, nodeHash))
+            if (!node->isEmptyBranch (i))
             {
                 if (nextNode)
                     return SHAMapItem::pointer (); // two leaves below
-                nextNode = getNodePointer (tempNodeID, nodeHash);
-                nextNodeID = tempNodeID;
+                nextNode = descendThrow (node, nodeID, i);
+                nextNodeID = nodeID.getChildNodeID (i);
             }
         }
         if (!nextNode)
@@ -479,45 +451,6 @@ SHAMap::onlyBelow (SHAMapTreeNode* node, SHAMapNodeID nodeID)
     return node->peekItem ();
 }
 
-void
-SHAMap::eraseChildren (SHAMapTreeNode::pointer node, SHAMapNodeID nodeID)
-{
-    // this node has only one item below it, erase its children
-    bool erase = false;
-    while (node->isInner ())
-    {
-        for (int i = 0; i < 16; ++i)
-        {
-            uint256 nodeHash;
-            SHAMapNodeID nextNodeID = nodeID;
-            if (node->descend (i, nextNodeID, nodeHash))
-            {
-                SHAMapTreeNode::pointer nextNode = getNode (nextNodeID,
-                                                               nodeHash, false);
-                if (erase)
-                {
-                    returnNode (node, nodeID, true);
-
-                    if (mTNByID.erase (nodeID))
-                        assert (false);
-                }
-
-                erase = true;
-                node = nextNode;
-                nodeID = nextNodeID;
-                break;
-            }
-        }
-    }
-
-    returnNode (node, nodeID, true);
-
-    if (mTNByID.erase (nodeID) == 0)
-        assert (false);
-
-    return;
-}
-
 static const SHAMapItem::pointer no_item;
 
 SHAMapItem::pointer SHAMap::peekFirstItem ()
@@ -569,8 +502,7 @@ SHAMapItem::pointer SHAMap::peekNextItem (uint256 const& id, SHAMapTreeNode::TNT
     // Get a pointer to the next item in the tree after a given item - item need not be in tree
     ScopedReadLockType sl (mLock);
 
-    std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>> stack =
-                                                            getStack (id, true);
+    SharedPtrNodeStack stack = getStack (id, true);
     while (!stack.empty ())
     {
         SHAMapTreeNode::pointer node = stack.top ().first;
@@ -587,17 +519,15 @@ SHAMapItem::pointer SHAMap::peekNextItem (uint256 const& id, SHAMapTreeNode::TNT
         }
         else
         {
-            uint256 nodeHash;
             // breadth-first
             for (int i = nodeID.selectBranch (id) + 1; i < 16; ++i)
             {
-                SHAMapNodeID childNodeID = nodeID;
-                if (node->descend (i, childNodeID, nodeHash))
+                if (!node->isEmptyBranch (i))
                 {
-                    SHAMapTreeNode* firstNode = getNodePointer (
-                        childNodeID, nodeHash);
+                    SHAMapTreeNode* firstNode = descendThrow (node.get (),
+                                                              nodeID, i);
                     assert (firstNode);
-                    firstNode = firstBelow (firstNode, childNodeID);
+                    firstNode = firstBelow (firstNode, nodeID.getChildNodeID (i));
 
                     if (!firstNode || firstNode->isInner ())
                         throw (std::runtime_error ("missing/corrupt node"));
@@ -618,8 +548,7 @@ SHAMapItem::pointer SHAMap::peekPrevItem (uint256 const& id)
 {
     ScopedReadLockType sl (mLock);
 
-    std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>> stack =
-                                                            getStack (id, true);
+    SharedPtrNodeStack stack = getStack (id, true);
     while (!stack.empty ())
     {
         SHAMapTreeNode::pointer node = stack.top ().first;
@@ -633,13 +562,13 @@ SHAMapItem::pointer SHAMap::peekPrevItem (uint256 const& id)
         }
         else
         {
-            uint256 nodeHash;
             for (int i = nodeID.selectBranch (id) - 1; i >= 0; --i)
             {
-                if (node->descend (i, nodeID, nodeHash))
+                if (!node->isEmptyBranch (i))
                 {
-                    node = getNode (nodeID, nodeHash, false);
-                    SHAMapTreeNode* item = firstBelow (node.get (), nodeID);
+                    SHAMapTreeNode* item = firstBelow (
+                        descendThrow (node.get (), nodeID, i),
+                        nodeID.getChildNodeID (i));
 
                     if (!item)
                         throw (std::runtime_error ("missing node"));
@@ -708,38 +637,31 @@ bool SHAMap::delItem (uint256 const& id)
     ScopedWriteLockType sl (mLock);
     assert (mState != smsImmutable);
 
-    std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>> stack =
-                                                            getStack (id, true);
+    SharedPtrNodeStack stack = getStack (id, true);
     if (stack.empty ())
         throw (std::runtime_error ("missing node"));
 
     SHAMapTreeNode::pointer leaf = stack.top ().first;
-    SHAMapNodeID leafID = stack.top ().second;
     stack.pop ();
 
     if (!leaf || !leaf->hasItem () || (leaf->peekItem ()->getTag () != id))
         return false;
 
     SHAMapTreeNode::TNType type = leaf->getType ();
-    returnNode (leaf, leafID, true);
 
-    if (mTNByID.erase (leafID) == 0)
-        assert (false);
-
-    uint256 prevHash;
+    // What gets linked into the parent, null if the branch is now empty
+    SHAMapTreeNode::pointer prevNode;
 
     while (!stack.empty ())
     {
         SHAMapTreeNode::pointer node = stack.top ().first;
         SHAMapNodeID nodeID = stack.top ().second;
         stack.pop ();
-        returnNode (node, nodeID, true);
+        unshareNode (node, nodeID);
         assert (node->isInner ());
-        if (!node->setChildHash (nodeID.selectBranch (id), prevHash))
-        {
-            assert (false);
-            return true;
-        }
+
+        node->setChild (nodeID.selectBranch (id),
+            prevNode ? prevNode->getNodeHash () : uint256 (), prevNode);
 
         if (!nodeID.isRoot ())
         {
@@ -748,10 +670,7 @@ bool SHAMap::delItem (uint256 const& id)
 
             if (bc == 0)
             {
-                prevHash = uint256 ();
-
-                if (!mTNByID.erase (nodeID))
-                    assert (false);
+                prevNode.reset ();
             }
             else if (bc == 1)
             {
@@ -759,22 +678,22 @@ bool SHAMap::delItem (uint256 const& id)
                 SHAMapItem::pointer item = onlyBelow (node.get (), nodeID);
 
                 if (item)
-                {
-                    returnNode (node, nodeID, true);
-                    eraseChildren (node, nodeID);
                     node->setItem (item, type);
-                }
 
-                prevHash = node->getNodeHash ();
-                assert (prevHash.isNonZero ());
+                prevNode = node;
+                assert (prevNode->getNodeHash ().isNonZero ());
             }
             else
             {
-                prevHash = node->getNodeHash ();
-                assert (prevHash.isNonZero ());
+                prevNode = node;
+                assert (prevNode->getNodeHash ().isNonZero ());
             }
         }
-        else assert (stack.empty ());
+        else
+        {
+            assert (stack.empty ());
+            root = node;
+        }
     }
 
     return true;
@@ -790,8 +709,7 @@ bool SHAMap::addGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasMeta
     ScopedWriteLockType sl (mLock);
     assert (mState != smsImmutable);
 
-    std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>> stack =
-                                                           getStack (tag, true);
+    SharedPtrNodeStack stack = getStack (tag, true);
     if (stack.empty ())
         throw (std::runtime_error ("missing node"));
 
@@ -802,28 +720,17 @@ bool SHAMap::addGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasMeta
     if (node->isLeaf () && (node->peekItem ()->getTag () == tag))
         return false;
 
-    uint256 prevHash;
-    returnNode (node, nodeID, true);
+    unshareNode (node, nodeID);
     if (node->isInner ())
     {
         // easy case, we end on an inner node
         int branch = nodeID.selectBranch (tag);
         assert (node->isEmptyBranch (branch));
-        SHAMapNodeID newNodeID = nodeID.getChildNodeID (branch);
         SHAMapTreeNode::pointer newNode =
             std::make_shared<SHAMapTreeNode> (item, type, mSeq);
 
-        if (!mTNByID.peekMap().emplace (newNodeID, newNode).second)
-        {
-            WriteLog (lsFATAL, SHAMap) << "Node: " << nodeID;
-            WriteLog (lsFATAL, SHAMap) << "NewNode: " << newNodeID;
-            dump ();
-            assert (false);
-            throw (std::runtime_error ("invalid inner node"));
-        }
-
-        trackNewNode (newNode, newNodeID);
-        node->setChildHash (branch, newNode->getNodeHash ());
+        trackNewNode (nodeID.getChildNodeID (branch));
+        node->setChild (branch, newNode->getNodeHash (), newNode);
     }
     else
     {
@@ -839,44 +746,28 @@ bool SHAMap::addGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasMeta
                (b2 = nodeID.selectBranch (otherItem->getTag ())))
         {
             // we need a new inner node, since both go on same branch at this level
-            SHAMapNodeID newNodeID = nodeID.getChildNodeID (b1);
-            SHAMapTreeNode::pointer newNode =
-                std::make_shared<SHAMapTreeNode> (mSeq);
-            newNode->makeInner ();
-
-            if (!mTNByID.peekMap().emplace (newNodeID, newNode).second)
-                assert (false);
-
             stack.push ({node, nodeID});
-            node = newNode;
-            nodeID = newNodeID;
-            trackNewNode (node, nodeID);
+            nodeID = nodeID.getChildNodeID (b1);
+            node = std::make_shared<SHAMapTreeNode> (mSeq);
+            node->makeInner ();
+            trackNewNode (nodeID);
         }
 
         // we can add the two leaf nodes here
         assert (node->isInner ());
-        SHAMapNodeID newNodeID = nodeID.getChildNodeID (b1);
         SHAMapTreeNode::pointer newNode =
             std::make_shared<SHAMapTreeNode> (item, type, mSeq);
         assert (newNode->isValid () && newNode->isLeaf ());
+        node->setChild (b1, newNode->getNodeHash (), newNode); // OPTIMIZEME hash op not needed
+        trackNewNode (nodeID.getChildNodeID (b1));
 
-        if (!mTNByID.peekMap().emplace (newNodeID, newNode).second)
-            assert (false);
-
-        node->setChildHash (b1, newNode->getNodeHash ()); // OPTIMIZEME hash op not needed
-        trackNewNode (newNode, newNodeID);
-        newNodeID = nodeID.getChildNodeID (b2);
         newNode = std::make_shared<SHAMapTreeNode> (otherItem, type, mSeq);
         assert (newNode->isValid () && newNode->isLeaf ());
-
-        if (!mTNByID.peekMap().emplace (newNodeID, newNode).second)
-            assert (false);
-
-        node->setChildHash (b2, newNode->getNodeHash ());
-        trackNewNode (newNode, newNodeID);
+        node->setChild (b2, newNode->getNodeHash (), newNode);
+        trackNewNode (nodeID.getChildNodeID (b2));
     }
 
-    dirtyUp (stack, tag, node->getNodeHash ());
+    dirtyUp (stack, tag, node);
     return true;
 }
 
@@ -893,8 +784,7 @@ bool SHAMap::updateGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasM
     ScopedWriteLockType sl (mLock);
     assert (mState != smsImmutable);
 
-    std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>> stack =
-                                                           getStack (tag, true);
+    SharedPtrNodeStack stack = getStack (tag, true);
     if (stack.empty ())
         throw (std::runtime_error ("missing node"));
 
@@ -908,7 +798,7 @@ bool SHAMap::updateGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasM
         return false;
     }
 
-    returnNode (node, nodeID, true);
+    unshareNode (node, nodeID);
 
     if (!node->setItem (item, !isTransaction ? SHAMapTreeNode::tnACCOUNT_STATE :
                         (hasMeta ? SHAMapTreeNode::tnTRANSACTION_MD : SHAMapTreeNode::tnTRANSACTION_NM)))
@@ -917,7 +807,7 @@ bool SHAMap::updateGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasM
         return true;
     }
 
-    dirtyUp (stack, tag, node->getNodeHash ());
+    dirtyUp (stack, tag, node);
     return true;
 }
 
@@ -926,32 +816,25 @@ void SHAMapItem::dump ()
     WriteLog (lsINFO, SHAMap) << "SHAMapItem(" << mTag << ") " << mData.size () << "bytes";
 }
 
-SHAMapTreeNode::pointer SHAMap::fetchNodeExternal (const SHAMapNodeID& id, uint256 const& hash)
-{
-    SHAMapTreeNode::pointer ret = fetchNodeExternalNT (id, hash);
-
-    if (!ret)
-        throw (SHAMapMissingNode (mType, id, hash));
-
-    return ret;
-}
-
 // Non-blocking version
-SHAMapTreeNode* SHAMap::getNodeAsync (
-    const SHAMapNodeID& id,
-    uint256 const& hash,
+SHAMapTreeNode* SHAMap::descendAsync (
+    SHAMapTreeNode* parent,
+    int branch,
+    SHAMapNodeID const& childID,
     SHAMapSyncFilter *filter,
     bool& pending)
 {
     pending = false;
 
-    // If the node is in mTNByID, return it
-    SHAMapTreeNode::pointer ptr = mTNByID.retrieve (id);
-    if (ptr)
-        return ptr.get ();
+    // If the node is already hooked up, return it
+    SHAMapTreeNode* ret = parent->getChildPointer (branch);
+    if (ret)
+        return ret;
+
+    uint256 const& hash = parent->getChildHash (branch);
 
     // Try the tree node cache
-    ptr = getCache (hash);
+    SHAMapTreeNode::pointer ptr = getCache (hash);
 
     if (!ptr)
     {
@@ -960,11 +843,11 @@ SHAMapTreeNode* SHAMap::getNodeAsync (
         if (filter)
         {
             Blob nodeData;
-            if (filter->haveNode (id, hash, nodeData))
+            if (filter->haveNode (childID, hash, nodeData))
             {
                 ptr = std::make_shared <SHAMapTreeNode> (
                     nodeData, 0, snfPREFIX, hash, true);
-                filter->gotNode (true, id, hash, nodeData, ptr->getType ());
+                filter->gotNode (true, childID, hash, nodeData, ptr->getType ());
             }
         }
 
@@ -978,7 +861,9 @@ SHAMapTreeNode* SHAMap::getNodeAsync (
 
             NodeObject::pointer obj;
 
-            if (!getApp().getNodeStore().asyncFetch (hash, obj))
+            // The caller reads deferred nodes in one batch, so don't
+            // schedule a read here as well
+            if (!getApp().getNodeStore().fetchIfCached (hash, obj))
             { // We would have to block
                 pending = true;
                 assert (!obj);
@@ -996,26 +881,18 @@ SHAMapTreeNode* SHAMap::getNodeAsync (
         canonicalize (hash, ptr);
     }
 
-    if (id.isRoot ())
-    {
-        // It is legal to replace the root
-        mTNByID.replace (id, ptr);
-        root = ptr;
-    }
-    else
-        mTNByID.canonicalize (id, &ptr);
-
+    parent->canonicalizeChild (branch, ptr);
     return ptr.get ();
 }
 
 /** Look at the cache and back end (things external to this SHAMap) to
-    find a tree node. Only a read lock is required because mTNByID has its
-    own, internal synchronization. Every thread calling this function must
-    get a shared pointer to the same underlying node.
+    find a tree node. Only a read lock is required because the caller
+    hooks the node up with SHAMapTreeNode::canonicalizeChild, which has
+    its own, internal synchronization.
     This function does not throw.
 */
 SHAMapTreeNode::pointer
-SHAMap::fetchNodeExternalNT (const SHAMapNodeID& id, uint256 const& hash)
+SHAMap::fetchNodeExternalNT (uint256 const& hash)
 {
     SHAMapTreeNode::pointer ret;
 
@@ -1067,13 +944,6 @@ SHAMap::fetchNodeExternalNT (const SHAMapNodeID& id, uint256 const& hash)
         }
     }
 
-    if (id.isRoot ()) // it is legal to replace an existing root
-    {
-        mTNByID.replace(id, ret);
-        root = ret;
-    }
-    else // Make sure other threads get pointers to the same underlying object
-       mTNByID.canonicalize (id, &ret);
     return ret;
 }
 
@@ -1092,7 +962,7 @@ bool SHAMap::fetchRoot (uint256 const& hash, SHAMapSyncFilter* filter)
             WriteLog (lsTRACE, SHAMap) << "Fetch root SHAMap node " << hash;
     }
 
-    SHAMapTreeNode::pointer newRoot = fetchNodeExternalNT(SHAMapNodeID(), hash);
+    SHAMapTreeNode::pointer newRoot = fetchNodeExternalNT (hash);
 
     if (newRoot)
     {
@@ -1107,7 +977,6 @@ bool SHAMap::fetchRoot (uint256 const& hash, SHAMapSyncFilter* filter)
 
         root = std::make_shared<SHAMapTreeNode> (nodeData,
                 mSeq - 1, snfPREFIX, hash, true);
-        mTNByID.replace(SHAMapNodeID (), root);
         filter->gotNode (true, SHAMapNodeID (), hash, nodeData, root->getType ());
     }
 
@@ -1127,52 +996,218 @@ int
 SHAMap::flushDirty (DirtySet& set, int maxNodes, NodeObjectType t, std::uint32_t seq)
 {
     int flushed = 0;
-    Serializer s;
+    NodeStore::Batch batch;
 
     ScopedWriteLockType sl (mLock);
 
-    for (DirtySet::iterator it = set.begin (); it != set.end (); it = set.erase (it))
+    // Flush deeper nodes first. A node is only made shareable once the
+    // nodes below it are, so a shareable node never links a mutable one.
+    std::vector<SHAMapNodeID> nodeIDs (set.begin (), set.end ());
+    std::sort (nodeIDs.begin (), nodeIDs.end (),
+        [](SHAMapNodeID const& a, SHAMapNodeID const& b)
+        {
+            return a.getDepth () > b.getDepth ();
+        });
+
+    for (auto const& nodeID : nodeIDs)
     {
-        SHAMapNodeID nodeID = *it;
-        SHAMapTreeNode::pointer node = checkCacheNode (nodeID);
+        set.erase (nodeID);
+
+        NodeObject::Ptr object = flushNode (nodeID, t, seq);
 
         // Check if node was deleted
-        if (!node)
+        if (!object)
             continue;
 
-        uint256 const nodeHash = node->getNodeHash();
+        batch.push_back (std::move (object));
+
+        if (flushed++ >= maxNodes)
+            break;
+    }
+
+    getApp().getNodeStore ().storeBatch (batch);
 
-        s.erase ();
-        node->addRaw (s, snfPREFIX);
+    return flushed;
+}
 
-#ifdef BEAST_DEBUG
+int
+SHAMap::flushDirtyBatch (DirtySet& set, NodeObjectType t, std::uint32_t seq)
+{
+    // Below this many nodes it isn't worth queueing jobs
+    std::size_t const parallelThreshold = 256;
+
+    // State shared with the jobs, which may start after we return
+    struct Flush
+    {
+        std::array <std::vector <SHAMapNodeID>, 16> subtrees;
+        std::array <NodeStore::Batch, 16> batches;
+        std::atomic <int> nextBranch;
+        std::mutex mutex;
+        std::condition_variable done;
+        int finished;
+    };
+
+    auto const flush = std::make_shared <Flush> ();
+    flush->nextBranch = 0;
+    flush->finished = 0;
+
+    ScopedWriteLockType sl (mLock);
+
+    bool rootDirty = false;
+    int busyBranches = 0;
 
-        if (s.getSHA512Half () != nodeHash)
+    for (auto const& nodeID : set)
+    {
+        if (nodeID.isRoot ())
         {
-            WriteLog (lsFATAL, SHAMap) << nodeID;
-            WriteLog (lsFATAL, SHAMap) << beast::lexicalCast <std::string> (s.getDataLength ());
-            WriteLog (lsFATAL, SHAMap) << s.getSHA512Half () << " != " << nodeHash;
-            assert (false);
+            rootDirty = true;
         }
+        else
+        {
+            auto& nodeIDs = flush->subtrees[
+                SHAMapNodeID ().selectBranch (nodeID.getNodeID ())];
 
-#endif
+            if (nodeIDs.empty ())
+                ++busyBranches;
+
+            nodeIDs.push_back (nodeID);
+        }
+    }
+
+    std::size_t const total = set.size ();
+    set.clear ();
+
+    // Each subtree only changes its own nodes and its slot in the root,
+    // which shareChild guards, so the subtrees don't need mLock between
+    // them. We hold it until every subtree is done. A job which starts
+    // after all the branches were claimed returns without touching us.
+    auto const worker = [this, t, seq] (Flush& f)
+    {
+        int branch;
 
-        if (node->getSeq () != 0)
+        while ((branch = f.nextBranch++) < 16)
         {
-            // Node is not shareable
-            // Make and share a shareable copy
-            node = std::make_shared <SHAMapTreeNode> (*node, 0);
-            canonicalize (node->getNodeHash(), node);
-            mTNByID.replace (nodeID, node);
+            auto& nodeIDs = f.subtrees[branch];
+
+            std::sort (nodeIDs.begin (), nodeIDs.end (),
+                [](SHAMapNodeID const& a, SHAMapNodeID const& b)
+                {
+                    return a.getDepth () > b.getDepth ();
+                });
+
+            for (auto const& nodeID : nodeIDs)
+            {
+                NodeObject::Ptr object = flushNode (nodeID, t, seq);
+
+                if (object)
+                    f.batches[branch].push_back (std::move (object));
+            }
+
+            std::lock_guard <std::mutex> lock (f.mutex);
+
+            if (++f.finished == 16)
+                f.done.notify_all ();
         }
+    };
 
-        getApp().getNodeStore ().store (t, seq, std::move (s.modData ()), nodeHash);
+    // The calling thread works too, so this finishes even if no job
+    // thread is free.
+    if (total >= parallelThreshold)
+    {
+        for (int i = 1; i < busyBranches; ++i)
+        {
+            getApp().getJobQueue ().addJob (jtFLUSH, "SHAMap::flushDirty",
+                [flush, worker] (Job&)
+                {
+                    worker (*flush);
+                });
+        }
+    }
 
-        if (flushed++ >= maxNodes)
-            return flushed;
+    worker (*flush);
+
+    {
+        std::unique_lock <std::mutex> lock (flush->mutex);
+
+        while (flush->finished != 16)
+            flush->done.wait (lock);
     }
 
-    return flushed;
+    NodeStore::Batch batch;
+    batch.reserve (total);
+
+    for (auto& b : flush->batches)
+        batch.insert (batch.end (), b.begin (), b.end ());
+
+    // The root goes last, once all of its children are shareable
+    if (rootDirty)
+    {
+        NodeObject::Ptr object = flushNode (SHAMapNodeID (), t, seq);
+
+        if (object)
+            batch.push_back (std::move (object));
+    }
+
+    getApp().getNodeStore ().storeBatch (batch);
+
+    return batch.size ();
+}
+
+NodeObject::Ptr
+SHAMap::flushNode (SHAMapNodeID const& nodeID, NodeObjectType t, std::uint32_t seq)
+{
+    // Walk down to the node, only following children in memory. A
+    // dirty node and all of its parents are always in memory.
+    SHAMapTreeNode::pointer parent;
+    SHAMapTreeNode::pointer node = root;
+    SHAMapNodeID currentID;
+    int branch = -1;
+
+    while (node && (currentID != nodeID))
+    {
+        if (!node->isInner ())
+            return NodeObject::Ptr ();
+
+        branch = currentID.selectBranch (nodeID.getNodeID ());
+        parent = std::move (node);
+        node = parent->getChild (branch);
+        currentID = currentID.getChildNodeID (branch);
+    }
+
+    if (!node)
+        return NodeObject::Ptr ();
+
+    uint256 const nodeHash = node->getNodeHash();
+
+    Serializer s;
+    node->addRaw (s, snfPREFIX);
+
+#ifdef BEAST_DEBUG
+
+    if (s.getSHA512Half () != nodeHash)
+    {
+        WriteLog (lsFATAL, SHAMap) << nodeID;
+        WriteLog (lsFATAL, SHAMap) << beast::lexicalCast <std::string> (s.getDataLength ());
+        WriteLog (lsFATAL, SHAMap) << s.getSHA512Half () << " != " << nodeHash;
+        assert (false);
+    }
+
+#endif
+
+    if (node->getSeq () != 0)
+    {
+        // Node is not shareable
+        // Make and share a shareable copy
+        node = std::make_shared <SHAMapTreeNode> (*node, 0);
+        canonicalize (node->getNodeHash(), node);
+
+        if (!parent)
+            root = node;
+        else if (parent->getSeq () == mSeq)
+            parent->shareChild (branch, node);
+    }
+
+    return NodeObject::createObject (t, seq, std::move (s.modData ()), nodeHash);
 }
 
 /** Stop saving dirty nodes */
@@ -1187,22 +1222,22 @@ std::shared_ptr<SHAMap::DirtySet> SHAMap::disarmDirty ()
 
 SHAMapTreeNode::pointer SHAMap::getNode (const SHAMapNodeID& nodeID)
 {
-
-    SHAMapTreeNode::pointer node = checkCacheNode (nodeID);
-
-    if (node)
-        return node;
-
-    node = root;
+    SHAMapTreeNode::pointer node = root;
     SHAMapNodeID currentID;
+
     while (nodeID != currentID)
     {
+        if (node->isLeaf ())
+            return SHAMapTreeNode::pointer ();
+
         int branch = currentID.selectBranch (nodeID.getNodeID ());
         assert (branch >= 0);
-        uint256 currentHash;
-        if (!node->descend (branch, currentID, currentHash))
+
+        if (node->isEmptyBranch (branch))
             return SHAMapTreeNode::pointer ();
-        node = getNode (currentID, currentHash, false);
+
+        node = descendThrow (node, currentID, branch);
+        currentID = currentID.getChildNodeID (branch);
         assert (node);
     }
 
@@ -1213,16 +1248,9 @@ SHAMapTreeNode::pointer SHAMap::getNode (const SHAMapNodeID& nodeID)
 // It throws if the map is incomplete
 SHAMapTreeNode* SHAMap::getNodePointer (const SHAMapNodeID& nodeID)
 {
-    SHAMapTreeNode::pointer nodeptr = mTNByID.retrieve (nodeID);
-    if (nodeptr)
-    {
-        SHAMapTreeNode* ret = nodeptr.get ();
-        ret->touch(mSeq);
-        return ret;
-    }
-
     SHAMapTreeNode* node = root.get();
     SHAMapNodeID currentID;
+
     while (nodeID != currentID)
     {
         if (node->isLeaf ())
@@ -1230,10 +1258,12 @@ SHAMapTreeNode* SHAMap::getNodePointer (const SHAMapNodeID& nodeID)
 
         int branch = currentID.selectBranch (nodeID.getNodeID ());
         assert (branch >= 0);
-        uint256 currentHash;
-        if (!node->descend (branch, currentID, currentHash))
+
+        if (node->isEmptyBranch (branch))
             return nullptr;
-        node = getNodePointer (currentID, currentHash);
+
+        node = descendThrow (node, currentID, branch);
+        currentID = currentID.getChildNodeID (branch);
         assert (node);
     }
 
@@ -1256,11 +1286,11 @@ bool SHAMap::getPath (uint256 const& index, std::vector< Blob >& nodes, SHANodeF
         nodes.push_back (s.peekData ());
 
         int branch = nodeID.selectBranch (index);
-        uint256 nodeHash;
-        if (!inNode->descend (branch, nodeID, nodeHash)) // paths leads to empty branch
+        if (inNode->isEmptyBranch (branch)) // paths leads to empty branch
             return false;
 
-        inNode = getNodePointer (nodeID, nodeHash);
+        inNode = descendThrow (inNode, nodeID, branch);
+        nodeID = nodeID.getChildNodeID (branch);
         assert (inNode);
     }
 
@@ -1279,21 +1309,12 @@ void SHAMap::dropCache ()
     ScopedWriteLockType sl (mLock);
     assert (mState == smsImmutable);
 
-    mTNByID.clear ();
-
-    if (root)
-        mTNByID.canonicalize(SHAMapNodeID{}, &root);
-}
-
-void SHAMap::dropBelow (SHAMapTreeNode* d, SHAMapNodeID nodeID)
-{
-    if (d->isInner ())
+    // Let go of everything below the root, a shareable root may also be
+    // in use elsewhere so we replace it rather than changing it
+    if (root && root->isInner ())
     {
-        for (int i = 0 ; i < 16; ++i)
-        {
-            if (!d->isEmptyBranch (i))
-                mTNByID.erase (nodeID.getChildNodeID (i));
-        }
+        root = std::make_shared<SHAMapTreeNode> (*root, root->getSeq ());
+        root->clearChildren ();
     }
 }
 
@@ -1302,12 +1323,29 @@ void SHAMap::dump (bool hash)
     WriteLog (lsINFO, SHAMap) << " MAP Contains";
     ScopedWriteLockType sl (mLock);
 
-    for (auto const& p : mTNByID.peekMap())
+    std::stack<std::pair<SHAMapTreeNode*, SHAMapNodeID>> stack;
+    stack.push ({root.get (), SHAMapNodeID ()});
+
+    while (!stack.empty ())
     {
-        WriteLog (lsINFO, SHAMap) << p.second->getString (p.first);
-        CondLog (hash, lsINFO, SHAMap) << p.second->getNodeHash ();
-    }
+        SHAMapTreeNode* node;
+        SHAMapNodeID nodeID;
+        std::tie (node, nodeID) = stack.top ();
+        stack.pop ();
+
+        WriteLog (lsINFO, SHAMap) << node->getString (nodeID);
+        CondLog (hash, lsINFO, SHAMap) << node->getNodeHash ();
 
+        if (node->isInner ())
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                SHAMapTreeNode* child = node->getChildPointer (i);
+                if (child)
+                    stack.push ({child, nodeID.getChildNodeID (i)});
+            }
+        }
+    }
 }
 
 SHAMapTreeNode::pointer SHAMap::getCache (uint256 const& hash)
@@ -1416,6 +1454,106 @@ public:
         unexpected (sMap.getHash () == mapHash, "bad snapshot");
 
         unexpected (map2->getHash () != mapHash, "bad snapshot");
+
+        testcase ("mutable snapshot");
+
+        mapHash = sMap.getHash ();
+        SHAMap::pointer map3 = sMap.snapShot (true);
+
+        unexpected (map3->getHash () != mapHash, "bad snapshot");
+
+        unexpected (!map3->addItem (i2, true, false), "no add");
+
+        unexpected (!map3->hasItem (i2.getTag ()), "bad snapshot");
+
+        unexpected (sMap.hasItem (i2.getTag ()), "bad snapshot");
+
+        unexpected (sMap.getHash () != mapHash, "bad snapshot");
+
+        unexpected (!sMap.addItem (i5, true, false), "no add");
+
+        unexpected (map3->hasItem (i5.getTag ()), "bad snapshot");
+
+        unexpected (!map3->delItem (i2.getTag ()), "bad mod");
+
+        unexpected (map3->getHash () != mapHash, "bad snapshot");
+
+        testFlushDirtyBatch ();
+    }
+
+    // Fill two maps the same way, flush one with flushDirtyBatch and the
+    // other with flushDirty, and check they end up the same.
+    void testFlushDirtyBatch ()
+    {
+        testcase ("flush dirty batch");
+
+        beast::manual_clock <std::chrono::seconds> clock;
+        beast::Journal const j;
+
+        FullBelowCache fullBelowCache ("test.full_below", clock);
+        TreeNodeCache serialCache ("test.tree_node_cache", 65536, 60, clock, j);
+        TreeNodeCache batchCache ("test.tree_node_cache", 65536, 60, clock, j);
+
+        SHAMap serialMap (smtFREE, fullBelowCache, serialCache);
+        SHAMap batchMap (smtFREE, fullBelowCache, batchCache);
+
+        std::uint32_t const seq = serialMap.armDirty ();
+        batchMap.armDirty ();
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            // Keys and data no other test stores in the node store
+            Serializer s;
+            s.add32 (0x464C5348);
+            s.add32 (i);
+
+            SHAMapItem item (s.getSHA512Half (), s.peekData ());
+
+            unexpected (!serialMap.addItem (item, false, false), "no add");
+            unexpected (!batchMap.addItem (item, false, false), "no add");
+        }
+
+        auto const serialDirty = serialMap.disarmDirty ();
+        auto const batchDirty = batchMap.disarmDirty ();
+
+        expect (batchDirty->size () >= 256, "too few dirty nodes");
+        expect (*batchDirty == *serialDirty, "dirty sets differ");
+
+        // Flush the batch map first, so the nodes found in the node store
+        // below were stored by it
+        int const batchCount = batchMap.flushDirtyBatch (
+            *batchDirty, hotACCOUNT_NODE, seq);
+
+        std::set <uint256> batchNodes;
+        batchMap.getFetchPack (nullptr, true, std::numeric_limits <int>::max (),
+            [&batchNodes] (uint256 const& hash, Blob const&)
+            {
+                batchNodes.insert (hash);
+            });
+
+        for (auto const& hash : batchNodes)
+        {
+            expect (getApp().getNodeStore ().fetch (hash) != nullptr,
+                "node not stored");
+        }
+
+        int const serialCount = serialMap.flushDirty (
+            *serialDirty, std::numeric_limits <int>::max (),
+                hotACCOUNT_NODE, seq);
+
+        std::set <uint256> serialNodes;
+        serialMap.getFetchPack (nullptr, true, std::numeric_limits <int>::max (),
+            [&serialNodes] (uint256 const& hash, Blob const&)
+            {
+                serialNodes.insert (hash);
+            });
+
+        expect (batchDirty->empty (), "dirty nodes left");
+        expect (batchCount == serialCount, "flushed counts differ");
+        expect (batchCount == static_cast <int> (batchNodes.size ()),
+            "not every node flushed");
+        expect (batchNodes == serialNodes, "stored nodes differ");
+        expect (batchMap.getHash () == serialMap.getHash (), "root hashes differ");
     }
 };
 
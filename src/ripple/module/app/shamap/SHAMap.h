@@ -23,6 +23,7 @@
 #include <ripple/common/UnorderedContainers.h>
 #include <ripple/module/app/main/FullBelowCache.h>
 #include <ripple/nodestore/NodeObject.h>
+#include <ripple/nodestore/Types.h>
 #include <ripple/unity/radmap.h>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_lock_guard.hpp>
@@ -100,11 +101,6 @@ private:
     };
 
 public:
-    enum
-    {
-        STATE_MAP_BUCKETS = 1024
-    };
-
     static char const* getCountedObjectName () { return "SHAMap"; }
 
     typedef std::shared_ptr<SHAMap> pointer;
@@ -113,7 +109,6 @@ public:
     typedef std::pair<SHAMapItem::pointer, SHAMapItem::pointer> DeltaItem;
     typedef std::pair<SHAMapItem::ref, SHAMapItem::ref> DeltaRef;
     typedef std::map<uint256, DeltaItem> Delta;
-    typedef hash_map<SHAMapNodeID, SHAMapTreeNode::pointer, SHAMapNode_hash> NodeMap;
     typedef hash_set<SHAMapNodeID, SHAMapNode_hash> DirtySet;
 
     typedef boost::shared_mutex LockType;
@@ -138,12 +133,11 @@ public:
 
     ~SHAMap ();
 
-    std::size_t size () const noexcept
-    {
-        return mTNByID.size ();
-    }
+    // Returns the number of nodes currently held in memory
+    std::size_t size () const;
 
     // Returns a new map that's a snapshot of this one. Force CoW
+    // This takes constant time, nodes are copied when first modified
     SHAMap::pointer snapShot (bool isMutable);
 
     // Remove nodes from memory
@@ -228,6 +222,16 @@ public:
     int armDirty ();
     int flushDirty (DirtySet & dirtySet, int maxNodes, NodeObjectType t,
                     std::uint32_t seq);
+
+    /** Write all modified nodes to the node store.
+        Dirty nodes below different branches of the root have no ancestor
+        in common but the root, so the subtrees are made shareable and
+        serialized by jobs on the JobQueue while the caller helps. The
+        nodes are then handed to the node store as one batch.
+        @return The number of nodes written.
+    */
+    int flushDirtyBatch (DirtySet & dirtySet, NodeObjectType t,
+                         std::uint32_t seq);
     std::shared_ptr<DirtySet> disarmDirty ();
 
     void walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissing);
@@ -249,8 +253,7 @@ private:
 
     SHAMapTreeNode::pointer fetchNodeExternal (const SHAMapNodeID & id,
                                                uint256 const& hash); // throws
-    SHAMapTreeNode::pointer fetchNodeExternalNT (const SHAMapNodeID & id,
-                                                 uint256 const& hash); // no throw
+    SHAMapTreeNode::pointer fetchNodeExternalNT (uint256 const& hash); // no throw
 
     bool getPath (uint256 const& index, std::vector< Blob >& nodes, SHANodeFormat format);
     void dump (bool withHashes = false);
@@ -259,34 +262,48 @@ private:
     SHAMapTreeNode::pointer getCache (uint256 const& hash);
     void canonicalize (uint256 const& hash, SHAMapTreeNode::pointer&);
 
-    void dirtyUp (std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>>& stack,
-                  uint256 const& target, uint256 prevHash);
-    std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>>
-        getStack (uint256 const& id, bool include_nonmatching_leaf);
-    SHAMapTreeNode::pointer walkTo (uint256 const& id, bool modify);
+    typedef std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>>
+        SharedPtrNodeStack;
+
+    void dirtyUp (SharedPtrNodeStack& stack,
+                  uint256 const& target, SHAMapTreeNode::pointer child);
+    SharedPtrNodeStack getStack (uint256 const& id, bool include_nonmatching_leaf);
     SHAMapTreeNode* walkToPointer (uint256 const& id);
-    SHAMapTreeNode::pointer checkCacheNode (const SHAMapNodeID&);
-    void returnNode (SHAMapTreeNode::pointer&, SHAMapNodeID const& nodeID,
-                                                                   bool modify);
-    void trackNewNode (SHAMapTreeNode::pointer&, SHAMapNodeID const&);
+    void unshareNode (SHAMapTreeNode::pointer&, SHAMapNodeID const& nodeID);
+
+    // Make a dirty node shareable and serialize it for the node store,
+    // returns nullptr if the node was deleted. The caller holds mLock.
+    NodeObject::Ptr flushNode (SHAMapNodeID const& nodeID, NodeObjectType t,
+                               std::uint32_t seq);
+    void trackNewNode (SHAMapNodeID const&);
 
+    // Walk from the root to a node by its ID
     SHAMapTreeNode::pointer getNode (const SHAMapNodeID & id);
-    SHAMapTreeNode::pointer getNode (const SHAMapNodeID & id, uint256 const& hash, bool modify);
     SHAMapTreeNode* getNodePointer (const SHAMapNodeID & id);
-    SHAMapTreeNode* getNodePointer (const SHAMapNodeID & id, uint256 const& hash);
-    SHAMapTreeNode* getNodePointerNT (const SHAMapNodeID & id, uint256 const& hash);
-    SHAMapTreeNode* getNodePointer (const SHAMapNodeID & id, uint256 const& hash, SHAMapSyncFilter * filter);
-    SHAMapTreeNode* getNodePointerNT (const SHAMapNodeID & id, uint256 const& hash, SHAMapSyncFilter * filter);
+
+    // Find a child of an inner node, bringing it into memory and hooking it
+    // up to its parent if needed. The parent ID is only used for errors.
+    SHAMapTreeNode* descendThrow (SHAMapTreeNode* parent,
+                                  SHAMapNodeID const& parentID, int branch);
+    SHAMapTreeNode::pointer descendThrow (SHAMapTreeNode::ref parent,
+                                          SHAMapNodeID const& parentID, int branch);
+    SHAMapTreeNode* descend (SHAMapTreeNode* parent, int branch);
+    SHAMapTreeNode* descend (SHAMapTreeNode* parent, SHAMapNodeID const& childID,
+                             int branch, SHAMapSyncFilter* filter);
+
+    // Find a child without hooking it up to a parent we don't own
+    SHAMapTreeNode::pointer descendNoStore (SHAMapTreeNode::ref parent,
+                                            SHAMapNodeID const& parentID, int branch);
+
+    // Non-blocking version of descend. Sets pending, without scheduling a
+    // read, if the node would have to come from the backend.
+    SHAMapTreeNode* descendAsync (SHAMapTreeNode* parent, int branch,
+        SHAMapNodeID const& childID, SHAMapSyncFilter* filter, bool& pending);
+
     SHAMapTreeNode* firstBelow (SHAMapTreeNode*, SHAMapNodeID);
     SHAMapTreeNode* lastBelow (SHAMapTreeNode*, SHAMapNodeID);
 
-    // Non-blocking version of getNodePointerNT
-    SHAMapTreeNode* getNodeAsync (
-        const SHAMapNodeID & id, uint256 const& hash, SHAMapSyncFilter * filter, bool& pending);
-
     SHAMapItem::pointer onlyBelow (SHAMapTreeNode*, SHAMapNodeID);
-    void eraseChildren (SHAMapTreeNode::pointer, SHAMapNodeID);
-    void dropBelow (SHAMapTreeNode*, SHAMapNodeID);
     bool hasInnerNode (const SHAMapNodeID & nodeID, uint256 const& hash);
     bool hasLeafNode (uint256 const& tag, uint256 const& hash);
 
@@ -300,13 +317,13 @@ private:
 
     // This lock protects key SHAMap structures.
     // One may change anything with a write lock.
-    // With a read lock, one may not invalidate pointers to existing members of mTNByID
+    // With a read lock, one may only hook up children that are not yet
+    // in memory, never replace or remove nodes already in the tree.
     mutable LockType mLock;
 
     FullBelowCache& m_fullBelowCache;
     std::uint32_t mSeq;
     std::uint32_t mLedgerSeq; // sequence number of ledger this is part of
-    SyncUnorderedMapType< SHAMapNodeID, SHAMapTreeNode::pointer, SHAMapNode_hash > mTNByID;
     std::shared_ptr<DirtySet> mDirtyNodes;
     TreeNodeCache& mTreeNodeCache;
     SHAMapTreeNode::pointer root;
@@ -31,10 +31,12 @@ class SHAMapDeltaNode
 {
 public:
     SHAMapNodeID mNodeID;
-    uint256 mOurHash, mOtherHash;
+    SHAMapTreeNode* mOurNode;
+    SHAMapTreeNode* mOtherNode;
 
-    SHAMapDeltaNode (const SHAMapNodeID& id, uint256 const& ourHash, uint256 const& otherHash) :
-        mNodeID (id), mOurHash (ourHash), mOtherHash (otherHash)
+    SHAMapDeltaNode (const SHAMapNodeID& id, SHAMapTreeNode* ourNode,
+                     SHAMapTreeNode* otherNode) :
+        mNodeID (id), mOurNode (ourNode), mOtherNode (otherNode)
     {
         ;
     }
@@ -58,13 +60,11 @@ bool SHAMap::walkBranch (SHAMapTreeNode* node, SHAMapNodeID nodeID,
         if (node->isInner ())
         {
             // This is an inner node, add all non-empty branches
-            uint256 childNodeHash;
             for (int i = 0; i < 16; ++i)
             {
-                SHAMapNodeID childNodeID = nodeID;
-                if (node->descend (i, childNodeID, childNodeHash))
-                    nodeStack.push ({getNodePointer (childNodeID, childNodeHash),
-                                     childNodeID});
+                if (!node->isEmptyBranch (i))
+                    nodeStack.push ({descendThrow (node, nodeID, i),
+                                     nodeID.getChildNodeID (i)});
             }
         }
         else
@@ -143,16 +143,15 @@ bool SHAMap::compare (SHAMap::ref otherMap, Delta& differences, int maxCount)
     if (getHash () == otherMap->getHash ())
         return true;
 
-    nodeStack.push (SHAMapDeltaNode (SHAMapNodeID (), getHash (),
-                    otherMap->getHash ()));
+    nodeStack.push (SHAMapDeltaNode (SHAMapNodeID (), root.get (),
+                    otherMap->root.get ()));
     while (!nodeStack.empty ())
     {
         SHAMapDeltaNode dNode (nodeStack.top ());
         nodeStack.pop ();
 
-        SHAMapTreeNode* ourNode = getNodePointer (dNode.mNodeID, dNode.mOurHash);
-        SHAMapTreeNode* otherNode = otherMap->getNodePointer (dNode.mNodeID,
-                                                              dNode.mOtherHash);
+        SHAMapTreeNode* ourNode = dNode.mOurNode;
+        SHAMapTreeNode* otherNode = dNode.mOtherNode;
         if (!ourNode || !otherNode)
         {
             assert (false);
@@ -209,8 +208,8 @@ bool SHAMap::compare (SHAMap::ref otherMap, Delta& differences, int maxCount)
                     {
                         // We have a branch, the other tree does not
                         SHAMapNodeID childNodeID = dNode.mNodeID.getChildNodeID(i);
-                        SHAMapTreeNode* iNode = getNodePointer (childNodeID,
-                                                     ourNode->getChildHash (i));
+                        SHAMapTreeNode* iNode = descendThrow (ourNode,
+                                                              dNode.mNodeID, i);
                         if (!walkBranch (iNode, childNodeID,
                                          SHAMapItem::pointer (), true,
                                          differences, maxCount))
@@ -221,8 +220,7 @@ bool SHAMap::compare (SHAMap::ref otherMap, Delta& differences, int maxCount)
                         // The other tree has a branch, we do not
                         SHAMapNodeID childNodeID = dNode.mNodeID.getChildNodeID(i);
                         SHAMapTreeNode* iNode =
-                            otherMap->getNodePointer(childNodeID,
-                                                     otherNode->getChildHash (i));
+                            otherMap->descendThrow (otherNode, dNode.mNodeID, i);
                         if (!otherMap->walkBranch (iNode, childNodeID,
                                                    SHAMapItem::pointer(),
                                                    false, differences, maxCount))
@@ -231,8 +229,10 @@ bool SHAMap::compare (SHAMap::ref otherMap, Delta& differences, int maxCount)
                     else // The two trees have different non-empty branches
                         nodeStack.push (SHAMapDeltaNode (
                                                dNode.mNodeID.getChildNodeID (i),
-                                               ourNode->getChildHash (i),
-                                               otherNode->getChildHash (i)));
+                                               descendThrow (ourNode,
+                                                             dNode.mNodeID, i),
+                                               otherMap->descendThrow (otherNode,
+                                                             dNode.mNodeID, i)));
                 }
         }
         else
@@ -259,26 +259,30 @@ void SHAMap::walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissi
         SHAMapNodeID nodeID;
         std::tie(node, nodeID) = nodeStack.top ();
         nodeStack.pop ();
-        uint256 childNodeHash;
         for (int i = 0; i < 16; ++i)
         {
-            SHAMapNodeID childNodeID = nodeID;
-            if (node->descend (i, childNodeID, childNodeHash))
+            if (!node->isEmptyBranch (i))
             {
-                try
+                SHAMapTreeNode::pointer d = node->getChild (i);
+
+                if (!d)
                 {
-                    SHAMapTreeNode::pointer d = getNode(childNodeID,
-                                                        childNodeHash, false);
-                    if (d->isInner ())
-                        nodeStack.push ({d, childNodeID});
+                    d = fetchNodeExternalNT (node->getChildHash (i));
+
+                    if (d)
+                        node->canonicalizeChild (i, d);
                 }
-                catch (SHAMapMissingNode& n)
+
+                if (!d)
                 {
-                    missingNodes.push_back (n);
+                    missingNodes.push_back (SHAMapMissingNode (mType,
+                        nodeID.getChildNodeID (i), node->getChildHash (i)));
 
                     if (--maxMissing <= 0)
                         return;
                 }
+                else if (d->isInner ())
+                    nodeStack.push ({d, nodeID.getChildNodeID (i)});
             }
         }
     }
@@ -46,8 +46,11 @@ void SHAMap::visitLeavesInternal (std::function<void (SHAMapItem::ref item)>& fu
         return;
     }
 
-    std::stack<std::tuple<int, SHAMapTreeNode*, SHAMapNodeID>> stack;
-    SHAMapTreeNode* node = root.get ();
+    // Children are not hooked up as we go, so nodes we are done with
+    // can be released instead of staying in memory with the map
+    typedef std::tuple<int, SHAMapTreeNode::pointer, SHAMapNodeID> StackEntry;
+    std::stack<StackEntry> stack;
+    SHAMapTreeNode::pointer node = root;
     SHAMapNodeID nodeID;
     int pos = 0;
 
@@ -55,19 +58,18 @@ void SHAMap::visitLeavesInternal (std::function<void (SHAMapItem::ref item)>& fu
     {
         while (pos < 16)
         {
-            SHAMapNodeID childID = nodeID;
-            uint256 childHash;
-            if (node->descend (pos, childID, childHash))
+            if (!node->isEmptyBranch (pos))
             {
-                SHAMapTreeNode* child = getNodePointer (childID, childHash);
+                SHAMapTreeNode::pointer child = descendNoStore (node, nodeID, pos);
                 if (child->isLeaf ())
                 {
                     function (child->peekItem ());
-                    mTNByID.erase (childID); // don't need this leaf anymore
                     ++pos;
                 }
                 else
                 {
+                    SHAMapNodeID childID = nodeID.getChildNodeID (pos);
+
                     // If there are no more children, don't push this node
                     while ((pos != 15) && (node->isEmptyBranch (pos + 1)))
                            ++pos;
@@ -75,13 +77,11 @@ void SHAMap::visitLeavesInternal (std::function<void (SHAMapItem::ref item)>& fu
                     if (pos != 15)
                     {
                         // save next position to resume at
-                        stack.push (std::make_tuple(pos + 1, node, nodeID));
+                        stack.push (std::make_tuple(pos + 1, std::move (node), nodeID));
                     }
-                    else
-                        mTNByID.erase (nodeID); // don't need this inner node anymore
 
                     // descend to the child's first position
-                    node = child;
+                    node = std::move (child);
                     nodeID = childID;
                     pos = 0;
                 }
@@ -93,8 +93,6 @@ void SHAMap::visitLeavesInternal (std::function<void (SHAMapItem::ref item)>& fu
         }
 
         // We are done with this inner node
-        mTNByID.erase (nodeID);
-
         if (stack.empty ())
             break;
 
@@ -136,7 +134,8 @@ void SHAMap::getMissingNodes (std::vector<SHAMapNodeID>& nodeIDs, std::vector<ui
 
     while (1)
     {
-        std::vector <std::pair <SHAMapNodeID, uint256>> deferredReads;
+        // parent, branch and ID of the child whose read was deferred
+        std::vector <std::tuple <SHAMapTreeNode*, int, SHAMapNodeID>> deferredReads;
         deferredReads.reserve (maxDefer + 16);
 
         std::stack <std::tuple<SHAMapTreeNode*, SHAMapNodeID, int, int, bool>>
@@ -168,7 +167,7 @@ void SHAMap::getMissingNodes (std::vector<SHAMapNodeID>& nodeIDs, std::vector<ui
                     {
                         SHAMapNodeID childID = nodeID.getChildNodeID (branch);
                         bool pending = false;
-                        SHAMapTreeNode* d = getNodeAsync (childID, childHash, filter, pending);
+                        SHAMapTreeNode* d = descendAsync (node, branch, childID, filter, pending);
 
                         if (!d)
                         {
@@ -186,7 +185,7 @@ void SHAMap::getMissingNodes (std::vector<SHAMapNodeID>& nodeIDs, std::vector<ui
                             else
                             {
                                 // read is deferred
-                                deferredReads.emplace_back (childID, childHash);
+                                deferredReads.emplace_back (node, branch, childID);
                             }
 
                             fullBelow = false; // This node is not known full below
@@ -233,14 +232,27 @@ void SHAMap::getMissingNodes (std::vector<SHAMapNodeID>& nodeIDs, std::vector<ui
         if (deferredReads.empty ())
             break;
 
-        getApp().getNodeStore().waitReads();
+        // Read the deferred nodes from the node store in one batch. No async
+        // reads were scheduled for them, so each is read only once. Holding
+        // the results keeps them in the node store cache while we hook them
+        // up below.
+        std::vector <uint256> deferredHashes;
+        deferredHashes.reserve (deferredReads.size ());
+        for (auto const& node : deferredReads)
+            deferredHashes.push_back (std::get<0> (node)->getChildHash (
+                std::get<1> (node)));
+
+        auto const deferredObjects =
+            getApp().getNodeStore().fetchBatch (deferredHashes);
 
         // Process all deferred reads
         for (auto const& node : deferredReads)
         {
-            auto const& nodeID = node.first;
-            auto const& nodeHash = node.second;
-            SHAMapTreeNode* nodePtr = getNodePointerNT (nodeID, nodeHash, filter);
+            auto const& parent = std::get<0> (node);
+            auto const& branch = std::get<1> (node);
+            auto const& nodeID = std::get<2> (node);
+            auto const& nodeHash = parent->getChildHash (branch);
+            SHAMapTreeNode* nodePtr = descend (parent, nodeID, branch, filter);
             if (!nodePtr && missingHashes.insert (nodeHash).second)
             {
                 nodeIDs.push_back (nodeID);
@@ -313,12 +325,10 @@ bool SHAMap::getNodeFat (SHAMapNodeID wanted, std::vector<SHAMapNodeID>& nodeIDs
         count = 0;
         for (int i = 0; i < 16; ++i)
         {
-            SHAMapNodeID tempNodeID = wanted;
-            uint256 nextNodeHash;
-            if (node->descend (i, tempNodeID, nextNodeHash))
+            if (!node->isEmptyBranch (i))
             {
-                nextNodeID = tempNodeID;
-                nextNode = getNodePointer (nextNodeID, nextNodeHash);
+                nextNodeID = wanted.getChildNodeID (i);
+                nextNode = descendThrow (node, wanted, i);
                 ++count;
                 if (fatLeaves || nextNode->isInner ())
                 {
@@ -371,7 +381,6 @@ SHAMapAddNode SHAMap::addRootNode (Blob const& rootNode, SHANodeFormat format,
 #endif
 
     root = node;
-    mTNByID.replace(SHAMapNodeID{}, root);
 
     if (root->isLeaf())
         clearSynching ();
@@ -409,7 +418,6 @@ SHAMapAddNode SHAMap::addRootNode (uint256 const& hash, Blob const& rootNode, SH
         return SHAMapAddNode::invalid ();
 
     root = node;
-    mTNByID.replace(SHAMapNodeID{}, root);
 
     if (root->isLeaf())
         clearSynching ();
@@ -440,16 +448,8 @@ SHAMap::addKnownNode (const SHAMapNodeID& node, Blob const& rawNode,
         return SHAMapAddNode::duplicate ();
     }
 
-    if (checkCacheNode (node)) // Do we already have this node?
-        return SHAMapAddNode::duplicate ();
-
-    SHAMapNodeID iNodeID = node.getParentNodeID();
-    SHAMapTreeNode* iNode = checkCacheNode(iNodeID).get();
-    if (iNode == nullptr)
-    {
-        iNode = root.get ();
-        iNodeID = SHAMapNodeID{};
-    }
+    SHAMapNodeID iNodeID;
+    SHAMapTreeNode* iNode = root.get ();
 
     while (!iNode->isLeaf () && !iNode->isFullBelow () &&
            (iNodeID.getDepth () < node.getDepth ()))
@@ -468,8 +468,7 @@ SHAMap::addKnownNode (const SHAMapNodeID& node, Blob const& rawNode,
         if (m_fullBelowCache.touch_if_exists (childHash))
             return SHAMapAddNode::duplicate ();
         SHAMapNodeID nextNodeID = iNodeID.getChildNodeID (branch);
-        SHAMapTreeNode* nextNode = getNodePointerNT(nextNodeID, childHash,
-                                                                        filter);
+        SHAMapTreeNode* nextNode = descend (iNode, nextNodeID, branch, filter);
         if (!nextNode)
         {
             if (iNodeID.getDepth () != (node.getDepth () - 1))
@@ -502,7 +501,7 @@ SHAMap::addKnownNode (const SHAMapNodeID& node, Blob const& rawNode,
                 return SHAMapAddNode::useful ();
             }
 
-            if (mTNByID.canonicalize(node, &newNode) && filter)
+            if (iNode->canonicalizeChild (branch, newNode) && filter)
             {
                 Serializer s;
                 newNode->addRaw (s, snfPREFIX);
@@ -523,26 +522,20 @@ SHAMap::addKnownNode (const SHAMapNodeID& node, Blob const& rawNode,
 bool SHAMap::deepCompare (SHAMap& other)
 {
     // Intended for debug/test only
-    std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>> stack;
+    std::stack<std::tuple<SHAMapTreeNode*, SHAMapTreeNode*, SHAMapNodeID>> stack;
     ScopedReadLockType sl (mLock);
 
-    stack.push ({root, SHAMapNodeID{}});
+    stack.push (std::make_tuple (root.get (), other.root.get (), SHAMapNodeID{}));
 
     while (!stack.empty ())
     {
-        SHAMapTreeNode::pointer node;
+        SHAMapTreeNode* node;
+        SHAMapTreeNode* otherNode;
         SHAMapNodeID nodeID;
-        std::tie(node, nodeID) = stack.top ();
+        std::tie(node, otherNode, nodeID) = stack.top ();
         stack.pop ();
 
-        SHAMapTreeNode::pointer otherNode;
-
-        if (nodeID.isRoot ())
-            otherNode = other.root;
-        else
-            otherNode = other.getNode (nodeID, node->getNodeHash (), false);
-
-        if (!otherNode)
+        if (!node || !otherNode)
         {
             WriteLog (lsINFO, SHAMap) << "unable to fetch node";
             return false;
@@ -555,9 +548,6 @@ bool SHAMap::deepCompare (SHAMap& other)
 
         //      WriteLog (lsTRACE) << "Comparing inner nodes " << *node;
 
-        if (node->getNodeHash () != otherNode->getNodeHash ())
-            return false;
-
         if (node->isLeaf ())
         {
             if (!otherNode->isLeaf ())
@@ -583,16 +573,14 @@ bool SHAMap::deepCompare (SHAMap& other)
                 }
                 else
                 {
-                    SHAMapNodeID nextNodeID = nodeID;
-                    uint256 nextNodeHash;
-                    if (!node->descend (i, nextNodeID, nextNodeHash))
+                    SHAMapTreeNode* next = descend (node, i);
+                    if (!next)
                     {
                         WriteLog (lsWARNING, SHAMap) << "unable to fetch inner node";
                         return false;
                     }
-                    SHAMapTreeNode::pointer next = getNode (nextNodeID,
-                                                            nextNodeHash, false);
-                    stack.push ({next, nextNodeID});
+                    stack.push (std::make_tuple (next, other.descend (otherNode, i),
+                                                 nodeID.getChildNodeID (i)));
                 }
             }
         }
@@ -608,22 +596,19 @@ bool
 SHAMap::hasInnerNode (SHAMapNodeID const& targetNodeID,
                       uint256 const& targetNodeHash)
 {
-    SHAMapTreeNode::pointer ptr = mTNByID.retrieve (targetNodeID);
-    if (ptr)
-        return ptr->getNodeHash() == targetNodeHash;
-
     SHAMapTreeNode* node = root.get ();
     SHAMapNodeID nodeID;
-    uint256 nodeHash;
+
     while (node->isInner () && (nodeID.getDepth () < targetNodeID.getDepth ()))
     {
         int branch = nodeID.selectBranch (targetNodeID.getNodeID ());
-        if (!node->descend (branch, nodeID, nodeHash))
+        if (node->isEmptyBranch (branch))
             return false;
-        node = getNodePointer (nodeID, nodeHash);
+        node = descendThrow (node, nodeID, branch);
+        nodeID = nodeID.getChildNodeID (branch);
     }
 
-    return nodeHash == targetNodeHash;
+    return (nodeID == targetNodeID) && (node->getNodeHash () == targetNodeHash);
 }
 
 /** Does this map have this leaf node?
@@ -633,18 +618,18 @@ bool SHAMap::hasLeafNode (uint256 const& tag, uint256 const& targetNodeHash)
 {
     SHAMapTreeNode* node = root.get ();
     SHAMapNodeID nodeID;
-    uint256 nodeHash;
     if (!node->isInner()) // only one leaf node in the tree
         return node->getNodeHash() == targetNodeHash;
 
     do
     {
         int branch = nodeID.selectBranch (tag);
-        if (!node->descend (branch, nodeID, nodeHash))
+        if (node->isEmptyBranch (branch))
             return false;   // Dead end, node must not be here
-        if (nodeHash == targetNodeHash) // Matching leaf, no need to retrieve it
+        if (node->getChildHash (branch) == targetNodeHash) // Matching leaf, no need to retrieve it
             return true;
-        node = getNodePointer (nodeID, nodeHash);
+        node = descendThrow (node, nodeID, branch);
+        nodeID = nodeID.getChildNodeID (branch);
     }
     while (node->isInner());
 
@@ -711,21 +696,37 @@ void SHAMap::getFetchPack (SHAMap* have, bool includeLeaves, int max,
         func (std::cref(node->getNodeHash ()), std::cref(s.peekData ()));
         --max;
 
-        // 2) push non-matching child inner nodes
+        // 2) find the children the recipient doesn't have, and read the
+        //    ones not yet in memory from the node store in one batch
+        bool wanted[16];
+        std::vector <uint256> fetchHashes;
+
         for (int i = 0; i < 16; ++i)
         {
-            if (!node->isEmptyBranch (i))
+            wanted[i] = !node->isEmptyBranch (i) && (!have ||
+                !have->hasInnerNode (nodeID.getChildNodeID (i),
+                    node->getChildHash (i)));
+
+            if (wanted[i] && !node->getChildPointer (i))
+                fetchHashes.push_back (node->getChildHash (i));
+        }
+
+        std::vector <NodeObject::pointer> fetched;
+        if ((fetchHashes.size () > 1) && getApp().running ())
+            fetched = getApp().getNodeStore().fetchBatch (fetchHashes);
+
+        // 3) push non-matching child inner nodes
+        for (int i = 0; i < 16; ++i)
+        {
+            if (wanted[i])
             {
                 uint256 const& childHash = node->getChildHash (i);
                 SHAMapNodeID childID = nodeID.getChildNodeID (i);
 
-                SHAMapTreeNode* next = getNodePointer (childID, childHash);
+                SHAMapTreeNode* next = descendThrow (node, nodeID, i);
 
                 if (next->isInner ())
-                {
-                    if (!have || !have->hasInnerNode (childID, childHash))
-                        stack.push ({next, childID});
-                }
+                    stack.push ({next, childID});
                 else if (includeLeaves && (!have || !have->hasLeafNode (next->getTag(), childHash)))
                 {
                     Serializer s;
@@ -742,8 +743,7 @@ std::list<Blob > SHAMap::getTrustedPath (uint256 const& index)
 {
     ScopedReadLockType sl (mLock);
 
-    std::stack<std::pair<SHAMapTreeNode::pointer, SHAMapNodeID>> stack =
-                                                        getStack (index, false);
+    SharedPtrNodeStack stack = getStack (index, false);
     if (stack.empty () || !stack.top ().first->isLeaf ())
         throw std::runtime_error ("requested leaf not present");
 
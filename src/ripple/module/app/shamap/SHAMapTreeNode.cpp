@@ -39,7 +39,20 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapTreeNode& node, std::uint32_t seq)
     if (node.mItem)
         mItem = node.mItem;
     else
+    {
         memcpy (mHashes, node.mHashes, sizeof (mHashes));
+
+        std::lock_guard <std::mutex> lock (node.childLock ());
+
+        for (int i = 0; i < 16; ++i)
+        {
+            // A shareable node may only point to shareable children,
+            // anything else is found again by hash when it is needed
+            if ((seq != 0) || (node.mChildren[i] &&
+                                  (node.mChildren[i]->getSeq () == 0)))
+                mChildren[i] = node.mChildren[i];
+        }
+    }
 }
 
 SHAMapTreeNode::SHAMapTreeNode (SHAMapItem::ref item,
@@ -389,6 +402,14 @@ void SHAMapTreeNode::addRaw (Serializer& s, SHANodeFormat format)
 
 bool SHAMapTreeNode::setItem (SHAMapItem::ref i, TNType type)
 {
+    if (mType == tnINNER)
+    {
+        // An inner node is collapsing into a leaf
+        mIsBranch = 0;
+        memset (mHashes, 0, sizeof (mHashes));
+        clearChildren ();
+    }
+
     mType = type;
     mItem = i;
     assert (isLeaf ());
@@ -418,6 +439,7 @@ void SHAMapTreeNode::makeInner ()
     mItem.reset ();
     mIsBranch = 0;
     memset (mHashes, 0, sizeof (mHashes));
+    clearChildren ();
     mType = tnINNER;
     mHash.zero ();
 }
@@ -469,11 +491,54 @@ std::string SHAMapTreeNode::getString (const SHAMapNodeID & id) const
     return ret;
 }
 
-bool SHAMapTreeNode::setChildHash (int m, uint256 const& hash)
+SHAMapTreeNode* SHAMapTreeNode::getChildPointer (int branch)
+{
+    assert ((branch >= 0) && (branch < 16));
+    assert (isInner ());
+
+    std::lock_guard <std::mutex> lock (childLock ());
+    return mChildren[branch].get ();
+}
+
+SHAMapTreeNode::pointer SHAMapTreeNode::getChild (int branch)
+{
+    assert ((branch >= 0) && (branch < 16));
+    assert (isInner ());
+
+    std::lock_guard <std::mutex> lock (childLock ());
+    return mChildren[branch];
+}
+
+bool SHAMapTreeNode::canonicalizeChild (int branch, pointer& node)
+{
+    assert ((branch >= 0) && (branch < 16));
+    assert (isInner ());
+    assert (node->getNodeHash () == mHashes[branch]);
+
+    std::lock_guard <std::mutex> lock (childLock ());
+
+    if (mChildren[branch])
+    {
+        // There is already a node hooked up, return it
+        node = mChildren[branch];
+        return false;
+    }
+
+    mChildren[branch] = node;
+    return true;
+}
+
+bool SHAMapTreeNode::setChild (int m, uint256 const& hash, pointer const& child)
 {
     assert ((m >= 0) && (m < 16));
     assert (mType == tnINNER);
     assert (mSeq != 0);
+    assert (!child || (child->getNodeHash () == hash));
+
+    {
+        std::lock_guard <std::mutex> lock (childLock ());
+        mChildren[m] = child;
+    }
 
     if (mHashes[m] == hash)
         return false;
@@ -488,6 +553,32 @@ bool SHAMapTreeNode::setChildHash (int m, uint256 const& hash)
     return updateHash ();
 }
 
+void SHAMapTreeNode::shareChild (int m, pointer const& child)
+{
+    assert ((m >= 0) && (m < 16));
+    assert (mType == tnINNER);
+    assert (child && (child->getNodeHash () == mHashes[m]));
+
+    std::lock_guard <std::mutex> lock (childLock ());
+    mChildren[m] = child;
+}
+
+void SHAMapTreeNode::clearChildren ()
+{
+    std::lock_guard <std::mutex> lock (childLock ());
+
+    for (auto& child : mChildren)
+        child.reset ();
+}
+
+std::mutex& SHAMapTreeNode::childLock () const
+{
+    // A small pool of locks keeps nodes small and spreads contention
+    static std::mutex locks[64];
+
+    return locks[(reinterpret_cast <std::uintptr_t> (this) / sizeof (*this)) % 64];
+}
+
 // Descends along the specified branch
 // On invocation, nodeID must be the ID of this node
 // Returns false if there is no node down that branch
@@ -21,6 +21,7 @@
 #define RIPPLE_SHAMAPTREENODE_H
 
 #include <ripple/module/app/shamap/SHAMapNodeID.h>
+#include <mutex>
 
 namespace ripple {
 
@@ -129,7 +130,6 @@ public:
     {
         return !mItem;
     }
-    bool setChildHash (int m, uint256 const& hash);
     bool isEmptyBranch (int m) const
     {
         return (mIsBranch & (1 << m)) == 0;
@@ -143,6 +143,32 @@ public:
         return mHashes[m];
     }
 
+    // child pointer functions
+
+    /** Returns the child hooked up along the branch, if any.
+        A null result does not mean the branch is empty, only that the
+        child has not been brought into memory through this node yet.
+    */
+    SHAMapTreeNode* getChildPointer (int branch);
+    pointer getChild (int branch);
+
+    /** Hook up a child that was found by its hash.
+        If another thread hooked up the child first, `node` is replaced with
+        that child so every caller ends up sharing the same object.
+        @return `true` if `node` was hooked up.
+    */
+    bool canonicalizeChild (int branch, pointer& node);
+
+    /** Set both the hash and the pointer of a child.
+        The node must be owned by the caller's map (non-zero sequence).
+        A null child with a zero hash empties the branch.
+        @return `true` if the hash of this node changed.
+    */
+    bool setChild (int branch, uint256 const& hash, pointer const& child);
+
+    /** Replace a child with an equivalent (same hash) node. */
+    void shareChild (int branch, pointer const& child);
+
     // item node function
     bool hasItem () const
     {
@@ -196,6 +222,7 @@ private:
 
     uint256             mHash;
     uint256             mHashes[16];
+    pointer             mChildren[16];
     SHAMapItem::pointer mItem;
     std::uint32_t       mSeq, mAccessSeq;
     TNType              mType;
@@ -203,9 +230,14 @@ private:
     bool                mFullBelow;
 
     bool updateHash ();
+    void clearChildren ();
+
+    // Children may be hooked up by readers holding only a read lock on
+    // the map, and shareable nodes are reachable from several maps.
+    std::mutex& childLock () const;
 };
 
-using TreeNodeCache = TaggedCache <uint256, SHAMapTreeNode>;
+using TreeNodeCache = ShardedTaggedCache <uint256, SHAMapTreeNode>;
 
 } // ripple
 
@@ -133,34 +133,18 @@ void Transaction::setStatus (TransStatus ts, std::uint32_t lseq)
     mInLedger   = lseq;
 }
 
-Transaction::pointer Transaction::transactionFromSQL (Database* db, bool bValidate)
+Transaction::pointer Transaction::transactionFromSQL (
+    Blob const& rawTxn, std::string const& status,
+    std::uint32_t inLedger, bool bValidate)
 {
-    Serializer rawTxn;
-    std::string status;
-    std::uint32_t inLedger;
-
-    int txSize = 2048;
-    rawTxn.resize (txSize);
-
-    db->getStr ("Status", status);
-    inLedger = db->getInt ("LedgerSeq");
-    txSize = db->getBinary ("RawTxn", &*rawTxn.begin (), rawTxn.getLength ());
-
-    if (txSize > rawTxn.getLength ())
-    {
-        rawTxn.resize (txSize);
-        db->getBinary ("RawTxn", &*rawTxn.begin (), rawTxn.getLength ());
-    }
-
-    rawTxn.resize (txSize);
-
-    SerializerIterator it (rawTxn);
+    Serializer s (rawTxn);
+    SerializerIterator it (s);
     SerializedTransaction::pointer txn = std::make_shared<SerializedTransaction> (std::ref (it));
     Transaction::pointer tr = std::make_shared<Transaction> (txn, bValidate);
 
     TransStatus st (INVALID);
 
-    switch (status[0])
+    switch (status.empty () ? TXN_SQL_UNKNOWN : status[0])
     {
     case TXN_SQL_NEW:
         st = NEW;
@@ -194,6 +178,30 @@ Transaction::pointer Transaction::transactionFromSQL (Database* db, bool bValida
     return tr;
 }
 
+Transaction::pointer Transaction::transactionFromSQL (Database* db, bool bValidate)
+{
+    Serializer rawTxn;
+    std::string status;
+    std::uint32_t inLedger;
+
+    int txSize = 2048;
+    rawTxn.resize (txSize);
+
+    db->getStr ("Status", status);
+    inLedger = db->getInt ("LedgerSeq");
+    txSize = db->getBinary ("RawTxn", &*rawTxn.begin (), rawTxn.getLength ());
+
+    if (txSize > rawTxn.getLength ())
+    {
+        rawTxn.resize (txSize);
+        db->getBinary ("RawTxn", &*rawTxn.begin (), rawTxn.getLength ());
+    }
+
+    rawTxn.resize (txSize);
+
+    return transactionFromSQL (rawTxn.peekData (), status, inLedger, bValidate);
+}
+
 // DAVID: would you rather duplicate this code or keep the lock longer?
 Transaction::pointer Transaction::transactionFromSQL (std::string const& sql)
 {
@@ -225,44 +233,7 @@ Transaction::pointer Transaction::transactionFromSQL (std::string const& sql)
     }
     rawTxn.resize (txSize);
 
-    SerializerIterator it (rawTxn);
-    SerializedTransaction::pointer txn = std::make_shared<SerializedTransaction> (std::ref (it));
-    Transaction::pointer tr = std::make_shared<Transaction> (txn, true);
-
-    TransStatus st (INVALID);
-
-    switch (status[0])
-    {
-    case TXN_SQL_NEW:
-        st = NEW;
-        break;
-
-    case TXN_SQL_CONFLICT:
-        st = CONFLICTED;
-        break;
-
-    case TXN_SQL_HELD:
-        st = HELD;
-        break;
-
-    case TXN_SQL_VALIDATED:
-        st = COMMITTED;
-        break;
-
-    case TXN_SQL_INCLUDED:
-        st = INCLUDED;
-        break;
-
-    case TXN_SQL_UNKNOWN:
-        break;
-
-    default:
-        assert (false);
-    }
-
-    tr->setStatus (st);
-    tr->setLedger (inLedger);
-    return tr;
+    return transactionFromSQL (rawTxn.peekData (), status, inLedger, true);
 }
 
 
@@ -57,6 +57,9 @@ public:
 
     static Transaction::pointer sharedTransaction (Blob const & vucTransaction, bool bValidate);
     static Transaction::pointer transactionFromSQL (Database * db, bool bValidate);
+    static Transaction::pointer transactionFromSQL (
+        Blob const& rawTxn, std::string const& status,
+        std::uint32_t inLedger, bool bValidate);
 
     Transaction (
         TxType ttKind,
@@ -26,8 +26,7 @@ namespace ripple {
 void TransactionEngine::txnWrite ()
 {
     // Write back the account states
-    typedef std::map<uint256, LedgerEntrySetEntry>::value_type u256_LES_pair;
-    BOOST_FOREACH (u256_LES_pair & it, mNodes)
+    for (auto const& it : mNodes)
     {
         SLE::ref    sleEntry    = it.second.mEntry;
 
@@ -100,7 +100,7 @@ std::vector<RippleAddress> TransactionMetaSet::getAffectedAccounts ()
 
             if (inner)
             {
-                BOOST_FOREACH (const SerializedType & field, inner->peekData ())
+                BOOST_FOREACH (const SerializedType & field, *inner)
                 {
                     const STAccount* sa = dynamic_cast<const STAccount*> (&field);
 
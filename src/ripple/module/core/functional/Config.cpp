@@ -134,6 +134,8 @@ Config::Config ()
 
     LEDGER_HISTORY          = 256;
     FETCH_DEPTH             = 1000000000;
+    FULL_BELOW_PERSIST      = false;
+    LEDGER_FETCH_REQUESTS   = 2;
 
     PATH_SEARCH_OLD         = DEFAULT_PATH_SEARCH_OLD;
     PATH_SEARCH             = DEFAULT_PATH_SEARCH;
@@ -559,6 +561,17 @@ void Config::load ()
                     FETCH_DEPTH = 10;
             }
 
+            if (SectionSingleB (secConfig, SECTION_FULL_BELOW_PERSIST, strTemp))
+                FULL_BELOW_PERSIST  = beast::lexicalCastThrow <bool> (strTemp);
+
+            if (SectionSingleB (secConfig, SECTION_LEDGER_FETCH_REQUESTS, strTemp))
+            {
+                LEDGER_FETCH_REQUESTS = beast::lexicalCastThrow <int> (strTemp);
+
+                if (LEDGER_FETCH_REQUESTS < 1)
+                    LEDGER_FETCH_REQUESTS = 1;
+            }
+
             if (SectionSingleB (secConfig, SECTION_PATH_SEARCH_OLD, strTemp))
                 PATH_SEARCH_OLD     = beast::lexicalCastThrow <int> (strTemp);
             if (SectionSingleB (secConfig, SECTION_PATH_SEARCH, strTemp))
@@ -467,6 +467,8 @@ public:
     // Node storage configuration
     std::uint32_t                      LEDGER_HISTORY;
     std::uint32_t                      FETCH_DEPTH;
+    bool                        FULL_BELOW_PERSIST;     // Save the full below cache across restarts
+    int                         LEDGER_FETCH_REQUESTS;  // Node requests in flight to each peer
     int                         NODE_SIZE;
 
     // Client behavior
@@ -27,7 +27,10 @@
 #include <beast/module/core/thread/Workers.h>
 #include <beast/module/core/system/SystemStats.h>
 
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <vector>
 
 namespace ripple {
 
@@ -36,19 +39,27 @@ class JobQueueImp
     , private beast::Workers::Callback
 {
 public:
-    typedef std::set <Job> JobSet;
     typedef std::map <JobType, JobTypeData> JobDataMap;
-    typedef beast::CriticalSection::ScopedLockType ScopedLock;
+    // Each job type has its own queue and lock, so adding a job of one
+    // type never waits on the queue of another type.
+    typedef std::lock_guard <std::mutex> ScopedLock;
 
     beast::Journal m_journal;
-    beast::CriticalSection m_mutex;
-    std::uint64_t m_lastJob;
-    JobSet m_jobSet;
+    std::atomic <std::uint64_t> m_lastJob;
     JobDataMap m_jobData;
     JobTypeData m_invalidJobData;
 
+    // The dispatched job types, highest priority first
+    std::vector <JobTypeData*> m_byPriority;
+
+    // The number of jobs waiting, of all types
+    std::atomic <int> m_waitingCount;
+
     // The number of jobs currently in processTask()
-    int m_processCount;
+    std::atomic <int> m_processCount;
+
+    // Set by the first call to checkStopped which finds us stopped
+    std::atomic <bool> m_stopSignaled;
 
     beast::Workers m_workers;
     Job::CancelCallback m_cancelCallback;
@@ -73,7 +84,9 @@ public:
         , m_journal (journal)
         , m_lastJob (0)
         , m_invalidJobData (getJobTypes ().getInvalid (), collector)
+        , m_waitingCount (0)
         , m_processCount (0)
+        , m_stopSignaled (false)
         , m_workers (*this, "JobQueue", 0)
         , m_cancelCallback (std::bind (&Stoppable::isStopping, this))
         , m_collector (collector)
@@ -82,19 +95,22 @@ public:
             &JobQueueImp::collect, this));
         job_count = m_collector->make_gauge ("job_count");
 
+        for (auto const& x : getJobTypes ())
         {
-            ScopedLock lock (m_mutex);
+            JobTypeInfo const& jt = x.second;
 
-            for (auto const& x : getJobTypes ())
-            {
-                JobTypeInfo const& jt = x.second;
+            // And create dynamic information for all jobs
+            auto const result (m_jobData.emplace (std::piecewise_construct,
+                std::forward_as_tuple (jt.type ()),
+                std::forward_as_tuple (jt, m_collector)));
+            assert (result.second == true);
+        }
 
-                // And create dynamic information for all jobs
-                auto const result (m_jobData.emplace (std::piecewise_construct,
-                    std::forward_as_tuple (jt.type ()),
-                    std::forward_as_tuple (jt, m_collector)));
-                assert (result.second == true);
-            }
+        // Later job types have higher priority
+        for (auto iter = m_jobData.rbegin (); iter != m_jobData.rend (); ++iter)
+        {
+            if (! iter->second.info.special ())
+                m_byPriority.push_back (&iter->second);
         }
     }
 
@@ -106,8 +122,7 @@ public:
 
     void collect ()
     {
-        ScopedLock lock (m_mutex);
-        job_count = m_jobSet.size ();
+        job_count = m_waitingCount.load ();
     }
 
     void addJob (JobType type, std::string const& name,
@@ -139,10 +154,9 @@ public:
             //          OR
             //      * Not all children are stopped
             //
-            ScopedLock lock (m_mutex);
             assert (! isStopped() && (
                 m_processCount>0 ||
-                ! m_jobSet.empty () ||
+                m_waitingCount>0 ||
                 ! areChildrenStopped()));
         }
 
@@ -157,30 +171,26 @@ public:
         }
 
         {
-            ScopedLock lock (m_mutex);
+            ScopedLock lock (data.mutex);
 
-            std::pair <std::set <Job>::iterator, bool> result (
-                m_jobSet.insert (Job (type, name, ++m_lastJob,
-                    data.load (), jobFunc, m_cancelCallback)));
-            queueJob (*result.first, lock);
+            // The index is taken under the lock so the queue stays in order
+            data.jobs.emplace_back (type, name, ++m_lastJob,
+                data.load (), jobFunc, m_cancelCallback);
+            queueJob (data, lock);
         }
     }
 
     int getJobCount (JobType t)
     {
-        ScopedLock lock (m_mutex);
-
         JobDataMap::const_iterator c = m_jobData.find (t);
 
         return (c == m_jobData.end ())
             ? 0
-            : c->second.waiting;
+            : c->second.waiting.load ();
     }
 
     int getJobCountTotal (JobType t)
     {
-        ScopedLock lock (m_mutex);
-
         JobDataMap::const_iterator c = m_jobData.find (t);
 
         return (c == m_jobData.end ())
@@ -193,8 +203,6 @@ public:
         // return the number of jobs at this priority level or greater
         int ret = 0;
 
-        ScopedLock lock (m_mutex);
-
         for (auto const& x : m_jobData)
         {
             if (x.first >= t)
@@ -296,8 +304,6 @@ public:
 
         Json::Value priorities = Json::arrayValue;
 
-        ScopedLock lock (m_mutex);
-
         for (auto& x : m_jobData)
         {
             assert (x.first != jtINVALID);
@@ -363,19 +369,23 @@ private:
 
     // Signals the service stopped if the stopped condition is met.
     //
-    void checkStopped (ScopedLock const& lock)
+    // This may be called concurrently. Only the first caller to find the
+    // condition met signals.
+    //
+    void checkStopped ()
     {
         // We are stopped when all of the following are true:
         //
         //  1. A stop notification was received
         //  2. All Stoppable children have stopped
         //  3. There are no executing calls to processTask
-        //  4. There are no remaining Jobs in the job set
+        //  4. There are no remaining Jobs in the queues
         //
         if (isStopping() &&
             areChildrenStopped() &&
             (m_processCount == 0) &&
-            m_jobSet.empty())
+            (m_waitingCount == 0) &&
+            ! m_stopSignaled.exchange (true))
         {
             stopped();
         }
@@ -387,7 +397,7 @@ private:
     //
     // Pre-conditions:
     //  The JobType must be valid.
-    //  The Job must exist in mJobSet.
+    //  The Job must be at the back of the queue for its type.
     //  The Job must not have previously been queued.
     //
     // Post-conditions:
@@ -395,15 +405,15 @@ private:
     //  If JobQueue exists, and has at least one thread, Job will eventually run.
     //
     // Invariants:
-    //  The calling thread owns the JobLock
+    //  The calling thread owns the lock for the job type
     //
-    void queueJob (Job const& job, ScopedLock const& lock)
+    void queueJob (JobTypeData& data, ScopedLock const& lock)
     {
-        JobType const type (job.getType ());
+        JobType const type (data.type ());
         assert (type != jtINVALID);
-        assert (m_jobSet.find (job) != m_jobSet.end ());
+        assert (! data.jobs.empty ());
 
-        JobTypeData& data (getJobTypeData (type));
+        ++m_waitingCount;
 
         if (data.waiting + data.running < getJobLimit (type))
         {
@@ -420,55 +430,86 @@ private:
 
     //------------------------------------------------------------------------------
     //
-    // Returns the next Job we should run now.
+    // Takes the next Job we should run now.
     //
     // RunnableJob:
-    //  A Job in the JobSet whose slots count for its type is greater than zero.
+    //  A Job whose type has fewer running jobs than its limit.
+    //
+    // The queues are first visited in priority order with only the queue
+    // being examined locked. Because of this, the job that a task was
+    // added for may be taken by another worker which overlooked a job
+    // added during its search. When that happens the queues are searched
+    // again with all of their locks held. Every task is added for a job
+    // which is waiting in a queue below its limit, so that search always
+    // finds one.
     //
     // Pre-conditions:
-    //  mJobSet must not be empty.
-    //  mJobSet holds at least one RunnableJob
+    //  A task was added for a RunnableJob
     //
     // Post-conditions:
     //  job is a valid Job object.
-    //  job is removed from mJobQueue.
+    //  job is removed from its queue.
     //  Waiting job count of it's type is decremented
     //  Running job count of it's type is incremented
     //
-    // Invariants:
-    //  The calling thread owns the JobLock
-    //
-    void getNextJob (Job& job, ScopedLock const& lock)
+    void getNextJob (Job& job)
     {
-        assert (! m_jobSet.empty ());
-
-        JobSet::const_iterator iter;
-        for (iter = m_jobSet.begin (); iter != m_jobSet.end (); ++iter)
+        for (JobTypeData* data : m_byPriority)
         {
-            JobTypeData& data (getJobTypeData (iter->getType ()));
+            int const limit (getJobLimit (data->type ()));
+
+            // Skip empty and saturated types without taking their lock
+            if ((data->waiting == 0) || (data->running >= limit))
+                continue;
 
-            assert (data.running <= getJobLimit (data.type ()));
+            std::unique_lock <std::mutex> lock (data->mutex);
 
-            // Run this job if we're running below the limit.
-            if (data.running < getJobLimit (data.type ()))
-            {
-                assert (data.waiting > 0);
-                break;
-            }
+            if (takeJob (*data, job, lock))
+                return;
         }
 
-        assert (iter != m_jobSet.end ());
+        // Locked in priority order, as nowhere else holds two at once
+        std::vector <std::unique_lock <std::mutex>> locks;
+        locks.reserve (m_byPriority.size ());
 
-        JobType const type = iter->getType ();
-        JobTypeData& data (getJobTypeData (type));
+        for (JobTypeData* data : m_byPriority)
+            locks.emplace_back (data->mutex);
 
-        assert (type != jtINVALID);
+        for (std::size_t i = 0; i < m_byPriority.size (); ++i)
+        {
+            if (takeJob (*m_byPriority [i], job, locks [i]))
+                return;
+        }
+
+        assert (false);
+    }
+
+    // Takes the Job at the front of a queue if its type is below its limit.
+    //
+    // Invariants:
+    //  The calling thread owns the lock for the job type
+    //
+    bool takeJob (JobTypeData& data, Job& job,
+        std::unique_lock <std::mutex> const&)
+    {
+        int const limit (getJobLimit (data.type ()));
+
+        assert (data.running <= limit);
 
-        job = *iter;
-        m_jobSet.erase (iter);
+        // Run this job if we're running below the limit.
+        if (data.jobs.empty () || (data.running >= limit))
+            return false;
+
+        assert (data.waiting > 0);
+        assert (data.type () != jtINVALID);
+
+        job = data.jobs.front ();
+        data.jobs.pop_front ();
 
         --data.waiting;
         ++data.running;
+        --m_waitingCount;
+        return true;
     }
 
     //------------------------------------------------------------------------------
@@ -476,7 +517,7 @@ private:
     // Indicates that a running Job has completed its task.
     //
     // Pre-conditions:
-    //  Job must not exist in mJobSet.
+    //  Job must not be in its queue.
     //  The JobType must not be invalid.
     //
     // Post-conditions:
@@ -486,15 +527,16 @@ private:
     // Invariants:
     //  <none>
     //
-    void finishJob (Job const& job, ScopedLock const& lock)
+    void finishJob (Job const& job)
     {
         JobType const type = job.getType ();
 
-        assert (m_jobSet.find (job) == m_jobSet.end ());
         assert (type != jtINVALID);
 
         JobTypeData& data (getJobTypeData (type));
 
+        ScopedLock lock (data.mutex);
+
         // Queue a deferred task if possible
         if (data.deferred > 0)
         {
@@ -533,7 +575,7 @@ private:
     // Runs the next appropriate waiting Job.
     //
     // Pre-conditions:
-    //  A RunnableJob must exist in the JobSet
+    //  A task was added for a RunnableJob
     //
     // Post-conditions:
     //  The chosen RunnableJob will have Job::doJob() called.
@@ -545,11 +587,11 @@ private:
     {
         Job job;
 
-        {
-            ScopedLock lock (m_mutex);
-            getNextJob (job, lock);
-            ++m_processCount;
-        }
+        // Counted before the job leaves its queue, so that checkStopped
+        // never sees a job which is neither waiting nor being processed.
+        ++m_processCount;
+
+        getNextJob (job);
 
         JobTypeData& data (getJobTypeData (job.getType ()));
 
@@ -573,12 +615,9 @@ private:
             m_journal.trace << "Skipping processTask ('" << data.name () << "')";
         }
 
-        {
-            ScopedLock lock (m_mutex);
-            finishJob (job, lock);
-            --m_processCount;
-            checkStopped (lock);
-        }
+        finishJob (job);
+        --m_processCount;
+        checkStopped ();
 
         // Note that when Job::~Job is called, the last reference
         // to the associated LoadEvent object (in the Job) may be destroyed.
@@ -666,9 +705,7 @@ private:
 
     void onChildrenStopped ()
     {
-        ScopedLock lock (m_mutex);
-
-        checkStopped (lock);
+        checkStopped ();
     }
 };
 
@@ -20,7 +20,11 @@
 #ifndef RIPPLE_CORE_JOBTYPEDATA_H_INCLUDED
 #define RIPPLE_CORE_JOBTYPEDATA_H_INCLUDED
 
+#include <ripple/module/core/functional/Job.h>
 #include <ripple/module/core/functional/JobTypeInfo.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
 
 namespace ripple
 {
@@ -37,14 +41,22 @@ public:
     /* The job category which we represent */
     JobTypeInfo const& info;
 
+    /* Protects the queue and the counts. The counts may be read without
+       holding the lock, for reporting.
+    */
+    std::mutex mutex;
+
+    /* The jobs waiting to run, oldest first */
+    std::deque <Job> jobs;
+
     /* The number of jobs waiting */
-    int waiting;
+    std::atomic <int> waiting;
 
     /* The number presently running */
-    int running;
+    std::atomic <int> running;
 
     /* And the number we deferred executing because of job limits */
-    int deferred;
+    std::atomic <int> deferred;
 
     /* Notification callbacks */
     beast::insight::Event dequeue;
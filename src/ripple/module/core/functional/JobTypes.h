@@ -83,6 +83,11 @@ public:
         add (jtTRANSACTION,   "transaction",
             maxLimit, true,   false, 250,   1000);
 
+        // A batch of signatures received from the network, limited so
+        // that some threads are always left for ledger work
+        add (jtSIGCHECK,      "signatureCheck",
+            4,        true,   false, 0,     0);
+
         // A Score or Fetch of the UNL (DEPRECATED)
         add (jtUNL,           "unl",
             1,        true,   false, 0,     0);
@@ -115,6 +120,10 @@ public:
         add (jtACCEPT,        "acceptLedger",
             maxLimit, false,  false, 0,     0);
 
+        // Write out part of a closed ledger
+        add (jtFLUSH,         "flushLedger",
+            maxLimit, false,  false, 0,     0);
+
         // A proposal from a trusted source
         add (jtPROPOSAL_t,    "trustedProposal",
             maxLimit, false,  false, 100,   500);
@@ -0,0 +1,366 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#if (BEAST_GCC || BEAST_CLANG) && defined (__x86_64__)
+#define RIPPLE_SHA512_AVX2 1
+#include <immintrin.h>
+#else
+#define RIPPLE_SHA512_AVX2 0
+#endif
+
+namespace ripple {
+
+namespace detail {
+
+#if RIPPLE_SHA512_AVX2
+
+#define RIPPLE_AVX2_TARGET __attribute__ ((target ("avx2")))
+
+static std::uint64_t const sha512K [80] =
+{
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
+    0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+    0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
+    0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+    0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+    0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, 0x2de92c6f592b0275ULL,
+    0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL,
+    0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+    0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL,
+    0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL,
+    0x92722c851482353bULL, 0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+    0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+    0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL,
+    0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+    0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL,
+    0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL,
+    0xc67178f2e372532bULL, 0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+    0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL,
+    0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+    0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+    0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static std::uint64_t const sha512Init [8] =
+{
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+    0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static inline std::uint64_t loadBigEndian (std::uint8_t const* p)
+{
+    return (std::uint64_t (p[0]) << 56) | (std::uint64_t (p[1]) << 48) |
+           (std::uint64_t (p[2]) << 40) | (std::uint64_t (p[3]) << 32) |
+           (std::uint64_t (p[4]) << 24) | (std::uint64_t (p[5]) << 16) |
+           (std::uint64_t (p[6]) << 8)  |  std::uint64_t (p[7]);
+}
+
+static inline void storeBigEndian (std::uint8_t* p, std::uint64_t v)
+{
+    for (int i = 7; i >= 0; --i)
+    {
+        p[i] = static_cast <std::uint8_t> (v);
+        v >>= 8;
+    }
+}
+
+template <int n>
+RIPPLE_AVX2_TARGET
+static inline __m256i rotr (__m256i x)
+{
+    return _mm256_or_si256 (_mm256_srli_epi64 (x, n), _mm256_slli_epi64 (x, 64 - n));
+}
+
+RIPPLE_AVX2_TARGET
+static inline __m256i xor3 (__m256i a, __m256i b, __m256i c)
+{
+    return _mm256_xor_si256 (_mm256_xor_si256 (a, b), c);
+}
+
+// Run one SHA-512 block through each of four states, lane i of the
+// state belongs to the message whose block is blocks[i].
+RIPPLE_AVX2_TARGET
+static void compress4 (__m256i* state, std::uint8_t const* const* blocks)
+{
+    __m256i w [80];
+
+    for (int t = 0; t < 16; ++t)
+    {
+        w[t] = _mm256_set_epi64x (
+            loadBigEndian (blocks[3] + 8 * t), loadBigEndian (blocks[2] + 8 * t),
+            loadBigEndian (blocks[1] + 8 * t), loadBigEndian (blocks[0] + 8 * t));
+    }
+
+    for (int t = 16; t < 80; ++t)
+    {
+        __m256i const s0 = xor3 (rotr <1> (w[t - 15]), rotr <8> (w[t - 15]),
+            _mm256_srli_epi64 (w[t - 15], 7));
+        __m256i const s1 = xor3 (rotr <19> (w[t - 2]), rotr <61> (w[t - 2]),
+            _mm256_srli_epi64 (w[t - 2], 6));
+        w[t] = _mm256_add_epi64 (_mm256_add_epi64 (w[t - 16], s0),
+            _mm256_add_epi64 (w[t - 7], s1));
+    }
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 80; ++t)
+    {
+        __m256i const s1 = xor3 (rotr <14> (e), rotr <18> (e), rotr <41> (e));
+        __m256i const ch = _mm256_xor_si256 (_mm256_and_si256 (e, f),
+            _mm256_andnot_si256 (e, g));
+        __m256i const t1 = _mm256_add_epi64 (
+            _mm256_add_epi64 (_mm256_add_epi64 (h, s1), ch),
+            _mm256_add_epi64 (_mm256_set1_epi64x (sha512K[t]), w[t]));
+        __m256i const s0 = xor3 (rotr <28> (a), rotr <34> (a), rotr <39> (a));
+        __m256i const maj = xor3 (_mm256_and_si256 (a, b),
+            _mm256_and_si256 (a, c), _mm256_and_si256 (b, c));
+        __m256i const t2 = _mm256_add_epi64 (s0, maj);
+
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi64 (d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi64 (t1, t2);
+    }
+
+    state[0] = _mm256_add_epi64 (state[0], a);
+    state[1] = _mm256_add_epi64 (state[1], b);
+    state[2] = _mm256_add_epi64 (state[2], c);
+    state[3] = _mm256_add_epi64 (state[3], d);
+    state[4] = _mm256_add_epi64 (state[4], e);
+    state[5] = _mm256_add_epi64 (state[5], f);
+    state[6] = _mm256_add_epi64 (state[6], g);
+    state[7] = _mm256_add_epi64 (state[7], h);
+}
+
+// Hash four messages of the same length
+RIPPLE_AVX2_TARGET
+static void sha512Half4 (const_byte_view const* data, uint256* hashes)
+{
+    std::size_t const size = data[0].size ();
+
+    // The padding adds a 1 bit, zeros and a 128-bit length, so the
+    // last one or two blocks are built in a buffer
+    std::size_t const fullBlocks = size / 128;
+    std::size_t const tailBytes = size % 128;
+    std::size_t const tailBlocks = (tailBytes + 17 > 128) ? 2 : 1;
+
+    std::uint8_t tail [4][256];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        std::memset (tail[i], 0, tailBlocks * 128);
+        if (tailBytes != 0)
+            std::memcpy (tail[i], data[i].data () + fullBlocks * 128, tailBytes);
+        tail[i][tailBytes] = 0x80;
+        storeBigEndian (tail[i] + tailBlocks * 128 - 8,
+            static_cast <std::uint64_t> (size) * 8);
+    }
+
+    __m256i state [8];
+
+    for (int j = 0; j < 8; ++j)
+        state[j] = _mm256_set1_epi64x (sha512Init[j]);
+
+    std::uint8_t const* blocks [4];
+
+    for (std::size_t n = 0; n < fullBlocks; ++n)
+    {
+        for (int i = 0; i < 4; ++i)
+            blocks[i] = data[i].data () + n * 128;
+
+        compress4 (state, blocks);
+    }
+
+    for (std::size_t n = 0; n < tailBlocks; ++n)
+    {
+        for (int i = 0; i < 4; ++i)
+            blocks[i] = tail[i] + n * 128;
+
+        compress4 (state, blocks);
+    }
+
+    // The half digest is the first four words of each state
+    std::uint64_t words [4][4];
+
+    for (int j = 0; j < 4; ++j)
+        _mm256_storeu_si256 (reinterpret_cast <__m256i*> (words[j]), state[j]);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+            storeBigEndian (hashes[i].begin () + 8 * j, words[j][i]);
+    }
+}
+
+static bool hasAVX2 ()
+{
+    static bool const result = __builtin_cpu_supports ("avx2");
+    return result;
+}
+
+#undef RIPPLE_AVX2_TARGET
+
+#endif
+
+static uint256 sha512Half (const_byte_view v)
+{
+    uint256 j[2];
+    SHA512 (v.data (), v.size (), reinterpret_cast<unsigned char*> (j));
+    return j[0];
+}
+
+}
+
+//------------------------------------------------------------------------------
+
+void sha512HalfBatch (const_byte_view const* data, uint256* hashes,
+    std::size_t count)
+{
+    std::size_t i = 0;
+
+#if RIPPLE_SHA512_AVX2
+    if (detail::hasAVX2 ())
+    {
+        while ((i + 4) <= count)
+        {
+            std::size_t const size = data[i].size ();
+
+            if ((data[i + 1].size () == size) &&
+                (data[i + 2].size () == size) &&
+                (data[i + 3].size () == size))
+            {
+                detail::sha512Half4 (data + i, hashes + i);
+                i += 4;
+            }
+            else
+            {
+                hashes[i] = detail::sha512Half (data[i]);
+                ++i;
+            }
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+        hashes[i] = detail::sha512Half (data[i]);
+}
+
+std::size_t sha512HalfLanes ()
+{
+#if RIPPLE_SHA512_AVX2
+    if (detail::hasAVX2 ())
+        return 4;
+#endif
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+
+class SHA512Batch_test : public beast::unit_test::suite
+{
+public:
+    void testSizes ()
+    {
+        testcase ("sizes");
+
+        // Cover the padding boundaries and the size of an inner node
+        std::size_t const sizes [] =
+            { 0, 1, 64, 111, 112, 127, 128, 129, 239, 240, 255, 256, 516, 1000 };
+
+        std::mt19937 gen (20141016);
+
+        for (auto const size : sizes)
+        {
+            std::vector <Blob> blobs (9, Blob (size));
+
+            for (auto& blob : blobs)
+                for (auto& byte : blob)
+                    byte = static_cast <std::uint8_t> (gen ());
+
+            std::vector <const_byte_view> views;
+
+            for (auto const& blob : blobs)
+                views.emplace_back (blob.data (), blob.data () + blob.size ());
+
+            std::vector <uint256> hashes (views.size ());
+            sha512HalfBatch (views.data (), hashes.data (), views.size ());
+
+            bool same = true;
+
+            for (std::size_t i = 0; i < blobs.size (); ++i)
+                same = same && (hashes[i] == Serializer::getSHA512Half (blobs[i]));
+
+            expect (same, "batch hash differs at size " + std::to_string (size));
+        }
+    }
+
+    void testMixed ()
+    {
+        testcase ("mixed");
+
+        std::mt19937 gen (20141017);
+
+        std::vector <Blob> blobs;
+
+        for (int i = 0; i < 23; ++i)
+        {
+            // Runs of equal sizes broken up by odd ones
+            Blob blob ((i % 5 == 4) ? 33 : 516);
+            for (auto& byte : blob)
+                byte = static_cast <std::uint8_t> (gen ());
+            blobs.push_back (std::move (blob));
+        }
+
+        std::vector <const_byte_view> views;
+
+        for (auto const& blob : blobs)
+            views.emplace_back (blob.data (), blob.data () + blob.size ());
+
+        std::vector <uint256> hashes (views.size ());
+        sha512HalfBatch (views.data (), hashes.data (), views.size ());
+
+        for (std::size_t i = 0; i < blobs.size (); ++i)
+            expect (hashes[i] == Serializer::getSHA512Half (blobs[i]));
+    }
+
+    void run ()
+    {
+        log << "sha512HalfBatch lanes: " << sha512HalfLanes ();
+
+        testSizes ();
+        testMixed ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SHA512Batch,ripple_data,ripple);
+
+}
@@ -0,0 +1,53 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_SHA512BATCH_H_INCLUDED
+#define RIPPLE_SHA512BATCH_H_INCLUDED
+
+#include <ripple/common/byte_view.h>
+
+namespace ripple {
+
+/** Compute the SHA-512-half of several independent messages.
+
+    Messages of the same length are hashed in groups, one message per
+    lane of the vector unit, when the processor supports it (AVX2 gives
+    four lanes). Everything else is hashed one message at a time. The
+    results are the same either way.
+
+    This is the batch form of Serializer::getSHA512Half. It is meant for
+    callers that have many node images to hash or verify at once, for
+    example the entries of a fetch pack.
+
+    @param data The messages to hash.
+    @param hashes [out] The first half of each SHA-512 digest, in the
+                        same order as `data`.
+    @param count The number of messages.
+*/
+void sha512HalfBatch (const_byte_view const* data, uint256* hashes,
+    std::size_t count);
+
+/** Return the number of messages sha512HalfBatch hashes together.
+    This is 1 if the processor has no usable vector unit.
+*/
+std::size_t sha512HalfLanes ();
+
+}
+
+#endif
@@ -438,7 +438,11 @@ int STAmount::compare (STAmount const& a) const
     return 0;
 }
 
-STAmount* STAmount::construct (SerializerIterator& sit, SField::ref name)
+STAmount::STAmount (SerializerIterator& sit, SField::ref name)
+    : SerializedType (name)
+    , mOffset (0)
+    , mIsNative (true)
+    , mIsNegative (false)
 {
     std::uint64_t value = sit.get64 ();
 
@@ -446,11 +450,16 @@ STAmount* STAmount::construct (SerializerIterator& sit, SField::ref name)
     {
         // native
         if ((value & cPosNative) != 0)
-            return new STAmount (name, value & ~cPosNative, false); // positive
+        {
+            mValue = value & ~cPosNative; // positive
+            return;
+        }
         else if (value == 0)
             throw std::runtime_error ("negative zero is not canonical");
 
-        return new STAmount (name, value, true); // negative
+        mValue = value; // negative
+        mIsNegative = true;
+        return;
     }
 
     Issue issue;
@@ -482,13 +491,25 @@ STAmount* STAmount::construct (SerializerIterator& sit, SField::ref name)
             throw std::runtime_error ("invalid currency value");
         }
 
-        return new STAmount (name, issue, value, offset, isNegative);
+        mIssue = issue;
+        mValue = value;
+        mOffset = offset;
+        mIsNegative = isNegative;
+        canonicalize ();
+        return;
     }
 
     if (offset != 512)
         throw std::runtime_error ("invalid currency value");
 
-    return new STAmount (name, issue);
+    mIssue = issue;
+    mValue = 0;
+    canonicalize ();
+}
+
+STAmount* STAmount::construct (SerializerIterator& sit, SField::ref name)
+{
+    return new STAmount (sit, name);
 }
 
 std::int64_t STAmount::getSNValue () const
@@ -871,6 +892,102 @@ STAmount operator- (STAmount const& v1, STAmount const& v2)
         return STAmount (v1.getFName (), v1.mIssue, -fv, ov1, true);
 }
 
+// Portable version of muldivChecked, for compilers without a 128-bit
+// integer type. Returns false if the quotient needs more than 64 bits.
+static bool muldivPortable (std::uint64_t multiplier,
+    std::uint64_t multiplicand, std::uint64_t addend, std::uint64_t divisor,
+        std::uint64_t& quotient)
+{
+    // Form the 128-bit product from 32-bit halves
+    std::uint64_t const mask = 0xffffffffull;
+    std::uint64_t const a0 = multiplier & mask, a1 = multiplier >> 32;
+    std::uint64_t const b0 = multiplicand & mask, b1 = multiplicand >> 32;
+
+    std::uint64_t const p00 = a0 * b0;
+    std::uint64_t const p01 = a0 * b1;
+    std::uint64_t const p10 = a1 * b0;
+    std::uint64_t const p11 = a1 * b1;
+
+    std::uint64_t const mid = (p00 >> 32) + (p01 & mask) + (p10 & mask);
+
+    std::uint64_t hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    std::uint64_t lo = (mid << 32) | (p00 & mask);
+
+    lo += addend;
+    if (lo < addend)
+        ++hi;
+
+    // The quotient fits in 64 bits only if the high half is below the divisor
+    if (hi >= divisor)
+        return false;
+
+    // Shift-subtract division of hi:lo, one quotient bit at a time
+    std::uint64_t rem = hi;
+    quotient = 0;
+
+    for (int i = 63; i >= 0; --i)
+    {
+        bool const carry = (rem >> 63) != 0;
+        rem = (rem << 1) | ((lo >> i) & 1);
+        quotient <<= 1;
+
+        if (carry || rem >= divisor)
+        {
+            rem -= divisor;
+            quotient |= 1;
+        }
+    }
+
+    return true;
+}
+
+// Computes (multiplier * multiplicand + addend) / divisor.
+// Returns false if the quotient needs more than 64 bits.
+static bool muldivChecked (std::uint64_t multiplier,
+    std::uint64_t multiplicand, std::uint64_t addend, std::uint64_t divisor,
+        std::uint64_t& quotient)
+{
+    assert (divisor != 0);
+
+#if defined (__SIZEOF_INT128__)
+    unsigned __int128 v = static_cast <unsigned __int128> (multiplier) *
+        multiplicand + addend;
+
+    v /= divisor;
+
+    if ((v >> 64) != 0)
+        return false;
+
+    quotient = static_cast <std::uint64_t> (v);
+    return true;
+#else
+    return muldivPortable (multiplier, multiplicand, addend, divisor,
+        quotient);
+#endif
+}
+
+std::uint64_t STAmount::muldiv (std::uint64_t multiplier,
+    std::uint64_t multiplicand, std::uint64_t addend, std::uint64_t divisor)
+{
+    std::uint64_t quotient;
+
+    if (!muldivChecked (multiplier, multiplicand, addend, divisor, quotient))
+        throw std::runtime_error ("muldiv overflow");
+
+    return quotient;
+}
+
+std::uint64_t STAmount::muldivSaturated (std::uint64_t multiplier,
+    std::uint64_t multiplicand, std::uint64_t addend, std::uint64_t divisor)
+{
+    std::uint64_t quotient;
+
+    if (!muldivChecked (multiplier, multiplicand, addend, divisor, quotient))
+        return std::numeric_limits <std::uint64_t>::max ();
+
+    return quotient;
+}
+
 // NIKB TODO Make Amount::divide skip math if den == QUALITY_ONE
 STAmount STAmount::divide (
     STAmount const& num, STAmount const& den, Issue const& issue)
@@ -900,20 +1017,11 @@ STAmount STAmount::divide (
         }
 
     // Compute (numerator * 10^17) / denominator
-    CBigNum v;
-
-    if ((BN_add_word64 (&v, numVal) != 1) ||
-            (BN_mul_word64 (&v, tenTo17) != 1) ||
-            (BN_div_word64 (&v, denVal) == ((std::uint64_t) - 1)))
-    {
-        throw std::runtime_error ("internal bn error");
-    }
-
     // 10^16 <= quotient <= 10^18
-    assert (BN_num_bytes (&v) <= 64);
+    std::uint64_t const v = muldivSaturated (numVal, tenTo17, 0, denVal);
 
     // TODO(tom): where do 5 and 17 come from?
-    return STAmount (issue, v.getuint64 () + 5,
+    return STAmount (issue, v + 5,
                      numOffset - denOffset - 17,
                      num.mIsNegative != den.mIsNegative);
 }
@@ -962,21 +1070,11 @@ STAmount STAmount::multiply (
     }
 
     // Compute (numerator * denominator) / 10^14 with rounding
-    // 10^16 <= result <= 10^18
-    CBigNum v;
-
-    if ((BN_add_word64 (&v, value1) != 1) ||
-            (BN_mul_word64 (&v, value2) != 1) ||
-            (BN_div_word64 (&v, tenTo14) == ((std::uint64_t) - 1)))
-    {
-        throw std::runtime_error ("internal bn error");
-    }
-
     // 10^16 <= product <= 10^18
-    assert (BN_num_bytes (&v) <= 64);
+    std::uint64_t const v = muldivSaturated (value1, value2, 0, tenTo14);
 
     // TODO(tom): where do 7 and 14 come from?
-    return STAmount (issue, v.getuint64 () + 7,
+    return STAmount (issue, v + 7,
                      offset1 + offset2 + 14, v1.mIsNegative != v2.mIsNegative);
 }
 
@@ -1046,12 +1144,7 @@ STAmount STAmount::getPay (
 
 STAmount STAmount::deserialize (SerializerIterator& it)
 {
-    auto s = dynamic_cast<STAmount*> (construct (it, sfGeneric));
-    if (!s)
-        throw std::runtime_error("Deserialization error");
-
-    STAmount ret (*s);
-    return ret;
+    return STAmount (it, sfGeneric);
 }
 
 std::string STAmount::getFullText () const
@@ -1770,12 +1863,134 @@ public:
 
     //--------------------------------------------------------------------------
 
+    // The OpenSSL computation that muldiv replaced
+    static std::uint64_t bnMuldiv (std::uint64_t multiplier,
+        std::uint64_t multiplicand, std::uint64_t addend,
+        std::uint64_t divisor)
+    {
+        CBigNum v;
+
+        if ((BN_add_word64 (&v, multiplier) != 1) ||
+                (BN_mul_word64 (&v, multiplicand) != 1) ||
+                (BN_add_word64 (&v, addend) != 1) ||
+                (BN_div_word64 (&v, divisor) == ((std::uint64_t) - 1)))
+        {
+            throw std::runtime_error ("internal bn error");
+        }
+
+        return v.getuint64 ();
+    }
+
+    void checkMuldiv (std::uint64_t multiplier, std::uint64_t multiplicand,
+        std::uint64_t addend, std::uint64_t divisor)
+    {
+        std::uint64_t const expected (
+            bnMuldiv (multiplier, multiplicand, addend, divisor));
+
+        std::uint64_t portable = 0;
+
+        if (STAmount::muldiv (multiplier, multiplicand, addend, divisor) !=
+                expected ||
+            !muldivPortable (multiplier, multiplicand, addend, divisor,
+                portable) ||
+            portable != expected)
+        {
+            fail ("muldiv " + std::to_string (multiplier) + " * " +
+                std::to_string (multiplicand) + " + " +
+                std::to_string (addend) + " / " +
+                std::to_string (divisor));
+        }
+        else
+        {
+            pass ();
+        }
+    }
+
+    void testMuldiv ()
+    {
+        testcase ("muldiv");
+
+        // xorshift64, so the cases are the same on every run
+        std::uint64_t state = 20140723;
+
+        // Multiply operands are mantissas. A dividend may also be as large
+        // as a native amount, since the divisor is at least a mantissa.
+        std::uint64_t const low = STAmount::cMinValue;
+        std::uint64_t const mantissa = STAmount::cMaxValue;
+        std::uint64_t const native = STAmount::cMaxNativeN;
+
+        auto random = [&state, low](std::uint64_t high)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return low + state % (high - low + 1);
+        };
+
+        for (int i = 0; i < 100000; ++i)
+        {
+            std::uint64_t const a = random (mantissa);
+            std::uint64_t const b = random (mantissa);
+            std::uint64_t const n = random ((i & 1) ? mantissa : native);
+
+            // multiply and mulRound
+            checkMuldiv (a, b, 0, tenTo14);
+            checkMuldiv (a, b, tenTo14m1, tenTo14);
+
+            // divide and divRound
+            checkMuldiv (n, tenTo17, 0, b);
+            checkMuldiv (n, tenTo17, b - 1, b);
+        }
+
+        // Edges of the ranges
+        std::uint64_t const edges [] = {
+            STAmount::cMinValue, STAmount::cMinValue + 1,
+            STAmount::cMaxValue - 1, STAmount::cMaxValue };
+
+        for (auto a : edges)
+        {
+            for (auto b : edges)
+            {
+                checkMuldiv (a, b, 0, tenTo14);
+                checkMuldiv (a, b, tenTo14m1, tenTo14);
+                checkMuldiv (a, tenTo17, 0, b);
+                checkMuldiv (a, tenTo17, b - 1, b);
+            }
+
+            checkMuldiv (STAmount::cMaxNativeN, tenTo17, 0, a);
+            checkMuldiv (STAmount::cMaxNativeN, tenTo17, a - 1, a);
+        }
+
+        // Operands which need the whole 128 bit intermediate
+        checkMuldiv (~0ull, ~0ull, ~0ull - 1, ~0ull);
+        checkMuldiv (~0ull, 2, 1, 3);
+
+        bool threw = false;
+
+        try
+        {
+            STAmount::muldiv (~0ull, 2, 0, 1);
+        }
+        catch (std::runtime_error const&)
+        {
+            threw = true;
+        }
+
+        expect (threw, "muldiv overflow should throw");
+
+        expect (STAmount::muldivSaturated (~0ull, 2, 0, 1) == ~0ull,
+            "muldivSaturated overflow should give all ones");
+    }
+
+    //--------------------------------------------------------------------------
+
     void run ()
     {
         testSetValue ();
         testNativeCurrency ();
         testCustomCurrency ();
         testArithmetic ();
+        testMuldiv ();
         testUnderflow ();
         testRounding ();
     }
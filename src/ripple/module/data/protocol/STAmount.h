@@ -123,6 +123,8 @@ public:
 
     STAmount (SField::ref, Json::Value const&);
 
+    STAmount (SerializerIterator& sit, SField::ref name);
+
     static STAmount createFromInt64 (SField::ref n, std::int64_t v);
 
     static std::unique_ptr<SerializedType> deserialize (
@@ -393,6 +395,24 @@ public:
     static void canonicalizeRound (
         bool isNative, std::uint64_t& value, int& offset, bool roundUp);
 
+    /** Returns (multiplier * multiplicand + addend) / divisor.
+        The intermediate result is kept to 128 bits, so nothing is lost
+        before the division, and the quotient is truncated.
+        @throws std::runtime_error if the quotient needs more than 64 bits.
+    */
+    static std::uint64_t muldiv (std::uint64_t multiplier,
+        std::uint64_t multiplicand, std::uint64_t addend,
+        std::uint64_t divisor);
+
+    /** Like muldiv, but a quotient that needs more than 64 bits gives all
+        ones instead of throwing. This is what the CBigNum code it replaced
+        returned, so multiply, divide, mulRound and divRound keep their
+        results for oversized native operands.
+    */
+    static std::uint64_t muldivSaturated (std::uint64_t multiplier,
+        std::uint64_t multiplicand, std::uint64_t addend,
+        std::uint64_t divisor);
+
 private:
     Issue mIssue;
 
@@ -406,6 +426,16 @@ private:
     {
         return new STAmount (*this);
     }
+
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
     static STAmount* construct (SerializerIterator&, SField::ref name);
 
     STAmount (SField::ref name, Issue const& issue,
@@ -104,6 +104,16 @@ private:
         return new STBitString (*this);
     }
 
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
+
     static STBitString* construct (SerializerIterator& u, SField::ref name)
     {
         return new STBitString (name, u.getBitString<Bits> ());
@@ -88,6 +88,16 @@ private:
     {
         return new STInteger (*this);
     }
+
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
     static STInteger* construct (SerializerIterator&, SField::ref f);
 };
 
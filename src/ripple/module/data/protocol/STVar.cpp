@@ -0,0 +1,179 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+
+static_assert (sizeof (STAmount) <= STVar::max_size,
+    "STVar::max_size is too small to hold an STAmount");
+
+STVar::STVar (STVar const& other)
+{
+    p_ = other.p_->copy (max_size, &d_);
+}
+
+STVar::STVar (STVar&& other) noexcept
+{
+    if (other.onHeap ())
+    {
+        p_ = other.p_;
+        other.p_ = nullptr;
+    }
+    else
+    {
+        p_ = other.p_->move (max_size, &d_);
+    }
+}
+
+STVar&
+STVar::operator= (STVar const& rhs)
+{
+    if (&rhs != this)
+    {
+        destroy ();
+        p_ = rhs.p_->copy (max_size, &d_);
+    }
+    return *this;
+}
+
+STVar&
+STVar::operator= (STVar&& rhs) noexcept
+{
+    if (&rhs != this)
+    {
+        destroy ();
+        if (rhs.onHeap ())
+        {
+            p_ = rhs.p_;
+            rhs.p_ = nullptr;
+        }
+        else
+        {
+            p_ = rhs.p_->move (max_size, &d_);
+        }
+    }
+    return *this;
+}
+
+STVar::~STVar ()
+{
+    destroy ();
+}
+
+STVar::STVar (SerializedType const& t)
+{
+    p_ = t.copy (max_size, &d_);
+}
+
+STVar::STVar (SerializedType&& t)
+{
+    p_ = t.move (max_size, &d_);
+}
+
+STVar::STVar (std::unique_ptr <SerializedType> t)
+    : p_ (t.release ())
+{
+}
+
+STVar::STVar (SerializedTypeID id, SField::ref name)
+{
+    assert ((id == STI_NOTPRESENT) || (id == name.fieldType));
+
+    switch (id)
+    {
+    case STI_NOTPRESENT:    construct <SerializedType> (name); return;
+    case STI_UINT8:         construct <STUInt8> (name); return;
+    case STI_UINT16:        construct <STUInt16> (name); return;
+    case STI_UINT32:        construct <STUInt32> (name); return;
+    case STI_UINT64:        construct <STUInt64> (name); return;
+    case STI_AMOUNT:        construct <STAmount> (name); return;
+    case STI_HASH128:       construct <STHash128> (name); return;
+    case STI_HASH160:       construct <STHash160> (name); return;
+    case STI_HASH256:       construct <STHash256> (name); return;
+    case STI_VECTOR256:     construct <STVector256> (name); return;
+    case STI_VL:            construct <STVariableLength> (name); return;
+    case STI_ACCOUNT:       construct <STAccount> (name); return;
+    case STI_PATHSET:       construct <STPathSet> (name); return;
+    case STI_OBJECT:        construct <STObject> (name); return;
+    case STI_ARRAY:         construct <STArray> (name); return;
+
+    default:
+        WriteLog (lsFATAL, STObject) << "Object type: " << beast::lexicalCast <std::string> (id);
+        assert (false);
+        throw std::runtime_error ("Unknown object type");
+    }
+}
+
+STVar::STVar (SerializerIterator& sit, SField::ref name)
+{
+    switch (name.fieldType)
+    {
+    case STI_NOTPRESENT:    construct <SerializedType> (name); return;
+    case STI_UINT8:         construct <STUInt8> (name, sit.get8 ()); return;
+    case STI_UINT16:        construct <STUInt16> (name, sit.get16 ()); return;
+    case STI_UINT32:        construct <STUInt32> (name, sit.get32 ()); return;
+    case STI_UINT64:        construct <STUInt64> (name, sit.get64 ()); return;
+    case STI_AMOUNT:        construct <STAmount> (sit, name); return;
+    case STI_HASH128:       construct <STHash128> (name, sit.get128 ()); return;
+    case STI_HASH160:       construct <STHash160> (name, sit.get160 ()); return;
+    case STI_HASH256:       construct <STHash256> (name, sit.get256 ()); return;
+    case STI_VECTOR256:     construct <STVector256> (sit, name); return;
+    case STI_VL:            construct <STVariableLength> (name, sit.getVL ()); return;
+    case STI_ACCOUNT:       construct <STAccount> (name, sit.getVL ()); return;
+
+    case STI_OBJECT:
+        construct <STObject> (name);
+        try
+        {
+            static_cast <STObject*> (p_)->set (sit, 1);
+        }
+        catch (...)
+        {
+            destroy ();
+            throw;
+        }
+        return;
+
+    // These are rare and hold their contents on the heap anyway
+    case STI_PATHSET:
+        p_ = STPathSet::deserialize (sit, name).release ();
+        return;
+
+    case STI_ARRAY:
+        p_ = STArray::deserialize (sit, name).release ();
+        return;
+
+    default:
+        throw std::runtime_error ("Unknown object type");
+    }
+}
+
+void STVar::destroy ()
+{
+    if (p_ == nullptr)
+        return;
+
+    if (onHeap ())
+        delete p_;
+    else
+        p_->~SerializedType ();
+
+    p_ = nullptr;
+}
+
+} // ripple
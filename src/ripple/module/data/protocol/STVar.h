@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_STVAR_H_INCLUDED
+#define RIPPLE_STVAR_H_INCLUDED
+
+#include <memory>
+#include <type_traits>
+
+namespace ripple {
+
+/** Holds a SerializedType of any derived type.
+
+    STObject keeps its fields in a vector of these. The field is
+    constructed inside the STVar when it fits, which every field type
+    except the derived object classes does, so building an object costs
+    one allocation for the whole vector instead of one for each field.
+    Anything larger goes on the heap.
+
+    Copying or moving an STVar copies or moves the field it holds.
+*/
+class STVar
+{
+public:
+    // Large enough for STAmount, the largest field type.
+    static std::size_t const max_size = 72;
+
+    // So that boost::indirect_iterator can see through an STVar
+    typedef SerializedType element_type;
+
+    STVar (STVar const& other);
+    STVar (STVar&& other) noexcept;
+    STVar& operator= (STVar const& rhs);
+    STVar& operator= (STVar&& rhs) noexcept;
+    ~STVar ();
+
+    /** Create a copy of a field. */
+    explicit STVar (SerializedType const& t);
+
+    /** Move a field in. */
+    explicit STVar (SerializedType&& t);
+
+    /** Take ownership of a field on the heap.
+        The field stays where it is.
+    */
+    explicit STVar (std::unique_ptr <SerializedType> t);
+
+    /** Create a default valued field.
+        If id is STI_NOTPRESENT this creates a placeholder for a field
+        that is not present.
+    */
+    STVar (SerializedTypeID id, SField::ref name);
+
+    /** Deserialize a field. */
+    STVar (SerializerIterator& sit, SField::ref name);
+
+    SerializedType& get ()
+    {
+        return *p_;
+    }
+
+    SerializedType const& get () const
+    {
+        return *p_;
+    }
+
+    SerializedType& operator* ()
+    {
+        return get ();
+    }
+
+    SerializedType const& operator* () const
+    {
+        return get ();
+    }
+
+    SerializedType* operator-> ()
+    {
+        return &get ();
+    }
+
+    SerializedType const* operator-> () const
+    {
+        return &get ();
+    }
+
+private:
+    template <class T, class... Args>
+    void construct (Args&&... args)
+    {
+        if (sizeof (T) > max_size)
+            p_ = new T (std::forward <Args> (args)...);
+        else
+            p_ = new (&d_) T (std::forward <Args> (args)...);
+    }
+
+    bool onHeap () const
+    {
+        return static_cast <void const*> (p_) !=
+            static_cast <void const*> (&d_);
+    }
+
+    void destroy ();
+
+    std::aligned_storage <max_size>::type d_;
+    SerializedType* p_;
+};
+
+} // ripple
+
+#endif
@@ -136,72 +136,67 @@ std::unique_ptr<SerializedType> STObject::makeDeserializedObject (SerializedType
 void STObject::set (const SOTemplate& type)
 {
     mData.clear ();
+    mData.reserve (type.peek ().size ());
     mType = &type;
 
     for (SOTemplate::value_type const& elem : type.peek ())
     {
         if (elem->flags != SOE_REQUIRED)
-            giveObject (makeNonPresentObject (elem->e_field));
+            mData.emplace_back (STI_NOTPRESENT, elem->e_field);
         else
-            giveObject (makeDefaultObject (elem->e_field));
+            mData.emplace_back (elem->e_field.fieldType, elem->e_field);
     }
 }
 
 bool STObject::setType (const SOTemplate& type)
 {
-    boost::ptr_vector<SerializedType> newData (type.peek ().size ());
+    std::vector<STVar> newData;
+    std::vector<bool> matched (type.peek ().size (), false);
     bool valid = true;
 
     mType = &type;
 
-    SerializedType** array = mData.c_array();
-    std::size_t count = mData.size ();
+    newData.reserve (type.peek ().size ());
 
     for (auto const& elem : type.peek ())
-    {
-        // Loop through all the fields in the template
-        bool match = false;
+        newData.emplace_back (STI_NOTPRESENT, elem->e_field);
 
-        for (std::size_t i = 0; i < count; ++i)
-            if ((array[i] != nullptr) && (array[i]->getFName () == elem->e_field))
-            {
-                // matching entry in the object, move to new vector
-                match = true;
-
-                if ((elem->flags == SOE_DEFAULT) && array[i]->isDefault ())
-                {
-                    WriteLog (lsWARNING, STObject) << "setType( " << getFName ().getName () << ") invalid default "
-                                                   << elem->e_field.fieldName;
-                    valid = false;
-                }
-
-                newData.push_back (array[i]);
-                array[i] = nullptr;
-                break;
-            }
+    for (auto& field : mData)
+    {
+        // The template knows where each of its fields goes, so there is
+        // no need to search the object for every template entry
+        int const index = type.getIndex (field->getFName ());
 
-        if (!match)
+        if ((index != -1) && !matched[index])
         {
-            // no match found in the object for an entry in the template
-            if (elem->flags == SOE_REQUIRED)
+            // matching entry in the object, move to new vector
+            matched[index] = true;
+
+            if ((type.peek ()[index]->flags == SOE_DEFAULT) && field->isDefault ())
             {
-                WriteLog (lsWARNING, STObject) << "setType( " << getFName ().getName () << ") invalid missing "
-                                               << elem->e_field.fieldName;
+                WriteLog (lsWARNING, STObject) << "setType( " << getFName ().getName () << ") invalid default "
+                                               << field->getFName ().fieldName;
                 valid = false;
             }
 
-            // Make a default object
-            newData.push_back (makeNonPresentObject (elem->e_field).release ());
+            newData[index] = std::move (field);
+        }
+        else if (!field->getFName ().isDiscardable ())
+        {
+            // Anything left over in the object must be discardable
+            WriteLog (lsWARNING, STObject) << "setType( " << getFName ().getName () << ") invalid leftover "
+                                           << field->getFName ().getName ();
+            valid = false;
         }
     }
 
-    for (std::size_t i = 0; i < count; ++i)
+    for (std::size_t i = 0; i < matched.size (); ++i)
     {
-        // Anything left over in the object must be discardable
-        if ((array[i] != nullptr) && !array[i]->getFName ().isDiscardable ())
+        // no match found in the object for an entry in the template
+        if (!matched[i] && (type.peek ()[i]->flags == SOE_REQUIRED))
         {
-            WriteLog (lsWARNING, STObject) << "setType( " << getFName ().getName () << ") invalid leftover "
-                                           << array[i]->getFName ().getName ();
+            WriteLog (lsWARNING, STObject) << "setType( " << getFName ().getName () << ") invalid missing "
+                                           << type.peek ()[i]->e_field.fieldName;
             valid = false;
         }
     }
@@ -215,11 +210,11 @@ bool STObject::setType (const SOTemplate& type)
 
 bool STObject::isValidForType ()
 {
-    boost::ptr_vector<SerializedType>::iterator it = mData.begin ();
+    iterator it = begin ();
 
     for (SOTemplate::value_type const& elem : mType->peek ())
     {
-        if (it == mData.end ())
+        if (it == end ())
             return false;
 
         if (elem->e_field != it->getFName ())
@@ -304,7 +299,7 @@ bool STObject::set (SerializerIterator& sit, int depth)
 
             // Unflatten the field
             //
-            giveObject (makeDeserializedObject (fn.fieldType, fn, sit, depth + 1));
+            mData.push_back (STVar (sit, fn));
         }
     }
 
@@ -342,7 +337,7 @@ std::string STObject::getFullText () const
     }
     else ret = "{";
 
-    BOOST_FOREACH (const SerializedType & it, mData)
+    BOOST_FOREACH (const SerializedType & it, *this)
 
     if (it.getSType () != STI_NOTPRESENT)
     {
@@ -358,21 +353,32 @@ std::string STObject::getFullText () const
 
 void STObject::add (Serializer& s, bool withSigningFields) const
 {
-    std::map<int, const SerializedType*> fields;
+    std::vector<const SerializedType*> fields;
+    fields.reserve (mData.size ());
 
-    BOOST_FOREACH (const SerializedType & it, mData)
+    BOOST_FOREACH (const SerializedType & it, *this)
     {
         // pick out the fields and sort them
         if ((it.getSType () != STI_NOTPRESENT) && it.getFName ().shouldInclude (withSigningFields))
-            fields.insert (std::make_pair (it.getFName ().fieldCode, &it));
+            fields.push_back (&it);
     }
 
+    std::stable_sort (fields.begin (), fields.end (),
+        [] (const SerializedType* lhs, const SerializedType* rhs)
+        {
+            return lhs->getFName ().fieldCode < rhs->getFName ().fieldCode;
+        });
+
+    const SerializedType* prev = nullptr;
 
-    typedef std::map<int, const SerializedType*>::value_type field_iterator;
-    BOOST_FOREACH (field_iterator & it, fields)
+    BOOST_FOREACH (const SerializedType* field, fields)
     {
-        // insert them in sorted order
-        const SerializedType* field = it.second;
+        // insert them in sorted order, keeping only the first of
+        // any fields that share a code
+        if ((prev != nullptr) && (prev->getFName ().fieldCode == field->getFName ().fieldCode))
+            continue;
+
+        prev = field;
 
         // When we serialize an object inside another object,
         // the type associated by rule with this field name
@@ -394,7 +400,7 @@ std::string STObject::getText () const
 {
     std::string ret = "{";
     bool first = false;
-    BOOST_FOREACH (const SerializedType & it, mData)
+    BOOST_FOREACH (const SerializedType & it, *this)
     {
         if (!first)
         {
@@ -418,8 +424,8 @@ bool STObject::isEquivalent (const SerializedType& t) const
         return false;
     }
 
-    boost::ptr_vector<SerializedType>::const_iterator it1 = mData.begin (), end1 = mData.end ();
-    boost::ptr_vector<SerializedType>::const_iterator it2 = v->mData.begin (), end2 = v->mData.end ();
+    const_iterator it1 = begin (), end1 = end ();
+    const_iterator it2 = v->begin (), end2 = v->end ();
 
     while ((it1 != end1) && (it2 != end2))
     {
@@ -467,7 +473,7 @@ int STObject::getFieldIndex (SField::ref field) const
         return mType->getIndex (field);
 
     int i = 0;
-    BOOST_FOREACH (const SerializedType & elem, mData)
+    BOOST_FOREACH (const SerializedType & elem, *this)
     {
         if (elem.getFName () == field)
             return i;
@@ -499,7 +505,7 @@ SerializedType& STObject::getField (SField::ref field)
 
 SField::ref STObject::getFieldSType (int index) const
 {
-    return mData[index].getFName ();
+    return mData[index]->getFName ();
 }
 
 const SerializedType* STObject::peekAtPField (SField::ref field) const
@@ -609,7 +615,7 @@ SerializedType* STObject::makeFieldPresent (SField::ref field)
     if (f->getSType () != STI_NOTPRESENT)
         return f;
 
-    mData.replace (index, makeDefaultObject (f->getFName ()).release ());
+    mData[index] = STVar (f->getFName ().fieldType, f->getFName ());
     return getPIndex (index);
 }
 
@@ -625,7 +631,7 @@ void STObject::makeFieldAbsent (SField::ref field)
     if (f.getSType () == STI_NOTPRESENT)
         return;
 
-    mData.replace (index, makeNonPresentObject (f.getFName ()).release ());
+    mData[index] = STVar (STI_NOTPRESENT, f.getFName ());
 }
 
 bool STObject::delField (SField::ref field)
@@ -1079,7 +1085,7 @@ Json::Value STObject::getJson (int options) const
 
     // TODO(tom): this variable is never changed...?
     int index = 1;
-    for (auto const& it: mData)
+    for (auto const& it: *this)
     {
         if (it.getSType () != STI_NOTPRESENT)
         {
@@ -1096,13 +1102,13 @@ bool STObject::operator== (const STObject& obj) const
 {
     // This is not particularly efficient, and only compares data elements with binary representations
     int matches = 0;
-    BOOST_FOREACH (const SerializedType & t, mData)
+    BOOST_FOREACH (const SerializedType & t, *this)
 
     if ((t.getSType () != STI_NOTPRESENT) && t.getFName ().isBinary ())
     {
         // each present field must have a matching field
         bool match = false;
-        BOOST_FOREACH (const SerializedType & t2, obj.mData)
+        BOOST_FOREACH (const SerializedType & t2, obj)
 
         if (t.getFName () == t2.getFName ())
         {
@@ -1122,7 +1128,7 @@ bool STObject::operator== (const STObject& obj) const
     }
 
     int fields = 0;
-    BOOST_FOREACH (const SerializedType & t2, obj.mData)
+    BOOST_FOREACH (const SerializedType & t2, obj)
 
     if ((t2.getSType () != STI_NOTPRESENT) && t2.getFName ().isBinary ())
         ++fields;
@@ -1276,6 +1282,7 @@ public:
     void run()
     {
         testSerialization();
+        testMove();
         testParseJSONArray();
         testParseJSONArrayWithInvalidChildrenObjects();
     }
@@ -1426,6 +1433,53 @@ public:
             unexpected (object3.getFieldVL (sfTestVL) != j, "STObject error");
         }
     }
+
+    void testMove ()
+    {
+        testcase ("move");
+
+        SField const& sfTestU32 = SField::getField (STI_UINT32, 255);
+        SField const& sfTestAmount = SField::getField (STI_AMOUNT, 255);
+        SField const& sfTestObject = SField::getField (STI_OBJECT, 255);
+
+        SOTemplate elements;
+        elements.push_back (SOElement (sfTestU32, SOE_REQUIRED));
+        elements.push_back (SOElement (sfTestAmount, SOE_OPTIONAL));
+        elements.push_back (SOElement (sfTestObject, SOE_OPTIONAL));
+
+        STObject object1 (elements, sfTestObject);
+        object1.setFieldU32 (sfTestU32, 42);
+        object1.setFieldAmount (sfTestAmount, STAmount (1000000));
+        object1.peekFieldObject (sfTestObject).setFieldU32 (sfFlags, 7);
+
+        Serializer s1;
+        object1.add (s1);
+
+        STObject copy (object1);
+        STObject moved (std::move (copy));
+
+        Serializer s2;
+        moved.add (s2);
+        expect (s1 == s2, "Moved object should serialize the same");
+        expect (moved.getFieldAmount (sfTestAmount) == STAmount (1000000));
+
+        // Growing a vector moves the fields of every element
+        std::vector <STObject> objects;
+        for (int i = 0; i < 100; ++i)
+            objects.push_back (object1);
+
+        bool same = true;
+        for (auto const& o : objects)
+            same = same && (o == object1);
+        expect (same, "Objects should survive reallocation");
+
+        // Deserializing puts each field in its template slot
+        SerializerIterator it (s1);
+        STObject object2 (elements, it, sfTestObject);
+        expect (object2.isValidForType ());
+        expect (object2.getFieldU32 (sfTestU32) == 42);
+        expect (object2.getFieldAmount (sfTestAmount) == STAmount (1000000));
+    }
 };
 
 BEAST_DEFINE_TESTSUITE(SerializedObject,ripple_data,ripple);
@@ -21,6 +21,7 @@
 #define RIPPLE_SERIALIZEDOBJECT_H
 
 #include <boost/ptr_container/ptr_vector.hpp> // VFALCO NOTE this looks like junk
+#include <boost/iterator/indirect_iterator.hpp>
 
 namespace ripple {
 
@@ -56,9 +57,22 @@ public:
 
     STObject (SField::ref name, boost::ptr_vector<SerializedType>& data) : SerializedType (name), mType (nullptr)
     {
-        mData.swap (data);
+        mData.reserve (data.size ());
+        for (auto& t : data)
+            mData.push_back (STVar (std::move (t)));
+        data.clear ();
     }
 
+    STObject (STObject const&) = default;
+    STObject (STObject&& other)
+        : SerializedType (other)
+        , mData (std::move (other.mData))
+        , mType (other.mType)
+    {
+        ;
+    }
+    STObject& operator= (STObject const&) = default;
+
     std::unique_ptr <STObject> oClone () const
     {
         return std::unique_ptr<STObject> (new STObject (*this));
@@ -113,42 +127,42 @@ public:
 
     int addObject (const SerializedType & t)
     {
-        mData.push_back (t.clone ().release ());
+        mData.push_back (STVar (t));
         return mData.size () - 1;
     }
     int giveObject (std::unique_ptr<SerializedType> t)
     {
-        mData.push_back (t.release ());
+        mData.push_back (STVar (std::move (t)));
         return mData.size () - 1;
     }
     int giveObject (SerializedType * t)
     {
-        mData.push_back (t);
+        mData.push_back (STVar (std::unique_ptr<SerializedType> (t)));
         return mData.size () - 1;
     }
-    const boost::ptr_vector<SerializedType>& peekData () const
+    const std::vector<STVar>& peekData () const
     {
         return mData;
     }
-    boost::ptr_vector<SerializedType>& peekData ()
+    std::vector<STVar>& peekData ()
     {
         return mData;
     }
     SerializedType& front ()
     {
-        return mData.front ();
+        return *mData.front ();
     }
     const SerializedType& front () const
     {
-        return mData.front ();
+        return *mData.front ();
     }
     SerializedType& back ()
     {
-        return mData.back ();
+        return *mData.back ();
     }
     const SerializedType& back () const
     {
-        return mData.back ();
+        return *mData.back ();
     }
 
     int getCount () const
@@ -166,19 +180,19 @@ public:
 
     const SerializedType& peekAtIndex (int offset) const
     {
-        return mData[offset];
+        return *mData[offset];
     }
     SerializedType& getIndex (int offset)
     {
-        return mData[offset];
+        return *mData[offset];
     }
     const SerializedType* peekAtPIndex (int offset) const
     {
-        return & (mData[offset]);
+        return & (*mData[offset]);
     }
     SerializedType* getPIndex (int offset)
     {
-        return & (mData[offset]);
+        return & (*mData[offset]);
     }
 
     int getFieldIndex (SField::ref field) const;
@@ -271,23 +285,25 @@ public:
     }
 
     // field iterator stuff
-    typedef boost::ptr_vector<SerializedType>::iterator iterator;
-    typedef boost::ptr_vector<SerializedType>::const_iterator const_iterator;
+    typedef boost::indirect_iterator <
+        std::vector<STVar>::iterator> iterator;
+    typedef boost::indirect_iterator <
+        std::vector<STVar>::const_iterator, SerializedType const> const_iterator;
     iterator begin ()
     {
-        return mData.begin ();
+        return iterator (mData.begin ());
     }
     iterator end ()
     {
-        return mData.end ();
+        return iterator (mData.end ());
     }
     const_iterator begin () const
     {
-        return mData.begin ();
+        return const_iterator (mData.begin ());
     }
     const_iterator end () const
     {
-        return mData.end ();
+        return const_iterator (mData.end ());
     }
     bool empty () const
     {
@@ -328,8 +344,18 @@ private:
         return new STObject (*this);
     }
 
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
+
 private:
-    boost::ptr_vector<SerializedType>   mData;
+    std::vector<STVar>                  mData;
     const SOTemplate*                   mType;
 };
 
@@ -386,6 +412,12 @@ public:
     {
         ;
     }
+    STArray (STArray const&) = default;
+    STArray (STArray&& other) : SerializedType (other)
+    {
+        value.swap (other.value);
+    }
+    STArray& operator= (STArray const&) = default;
 
     static std::unique_ptr<SerializedType> deserialize (SerializerIterator & sit, SField::ref name)
     {
@@ -523,6 +555,16 @@ private:
     {
         return new STArray (*this);
     }
+
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
     static STArray* construct (SerializerIterator&, SField::ref);
 };
 
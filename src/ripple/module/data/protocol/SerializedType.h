@@ -22,13 +22,14 @@
 
 #include <ripple/module/data/protocol/SField.h>
 #include <ripple/module/data/protocol/Serializer.h>
+#include <typeinfo>
 
 namespace ripple {
 
 // VFALCO TODO fix this restriction on copy assignment.
 //
 // CAUTION: Do not create a vector (or similar container) of any object derived
-// from SerializedType. Use Boost ptr_* containers. The copy assignment operator
+// from SerializedType. Use STVar or Boost ptr_* containers. The copy assignment operator
 // of SerializedType has semantics that will cause contained types to change
 // their names when an object is deleted because copy assignment is used to
 // "slide down" the remaining types and this will not copy the field
@@ -111,6 +112,28 @@ public:
         return std::unique_ptr<SerializedType> (duplicate ());
     }
 
+    /** Copy this object into a buffer of n bytes.
+        The copy is constructed in the buffer if it fits, else it is
+        allocated on the heap. Every derived class must override this,
+        this version would slice it.
+        @see STVar
+        @return A pointer to the copy.
+    */
+    virtual SerializedType* copy (std::size_t n, void* buf) const
+    {
+        assert (typeid (*this) == typeid (SerializedType));
+        return emplace (n, buf, *this);
+    }
+
+    /** Move this object into a buffer of n bytes.
+        Like copy, but the contents of this object are moved.
+    */
+    virtual SerializedType* move (std::size_t n, void* buf)
+    {
+        assert (typeid (*this) == typeid (SerializedType));
+        return emplace (n, buf, std::move (*this));
+    }
+
     virtual std::string getFullText () const;
     virtual std::string getText () const // just the value
     {
@@ -172,6 +195,17 @@ protected:
     // VFALCO TODO make accessors for this
     SField::ptr fName;
 
+    template <class T>
+    static SerializedType* emplace (std::size_t n, void* buf, T&& val)
+    {
+        typedef typename std::decay <T>::type U;
+
+        if (sizeof (U) > n)
+            return new U (std::forward <T> (val));
+
+        return new (buf) U (std::forward <T> (val));
+    }
+
 private:
     virtual SerializedType* duplicate () const
     {
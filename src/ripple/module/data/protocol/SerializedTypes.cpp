@@ -108,16 +108,14 @@ STAccount* STAccount::construct (SerializerIterator& u, SField::ref name)
 // STVector256
 //
 
-// Return a new object from a SerializerIterator.
-STVector256* STVector256::construct (SerializerIterator& u, SField::ref name)
+STVector256::STVector256 (SerializerIterator& u, SField::ref name)
+    : SerializedType (name)
 {
     Blob data = u.getVL ();
     Blob ::iterator begin = data.begin ();
 
-    std::unique_ptr<STVector256> vec (new STVector256 (name));
-
     int count = data.size () / (256 / 8);
-    vec->mValue.reserve (count);
+    mValue.reserve (count);
 
     unsigned int    uStart  = 0;
 
@@ -126,11 +124,15 @@ STVector256* STVector256::construct (SerializerIterator& u, SField::ref name)
         unsigned int    uEnd    = uStart + (256 / 8);
 
         // This next line could be optimized to construct a default uint256 in the vector and then copy into it
-        vec->mValue.push_back (uint256 (Blob (begin + uStart, begin + uEnd)));
+        mValue.push_back (uint256 (Blob (begin + uStart, begin + uEnd)));
         uStart  = uEnd;
     }
+}
 
-    return vec.release ();
+// Return a new object from a SerializerIterator.
+STVector256* STVector256::construct (SerializerIterator& u, SField::ref name)
+{
+    return new STVector256 (u, name);
 }
 
 void STVector256::add (Serializer& s) const
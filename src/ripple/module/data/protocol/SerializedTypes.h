@@ -52,6 +52,13 @@ public:
     {
         ;
     }
+    STVariableLength (STVariableLength const&) = default;
+    STVariableLength (STVariableLength&& other)
+        : SerializedType (other), value (std::move (other.value))
+    {
+        ;
+    }
+    STVariableLength& operator= (STVariableLength const&) = default;
     static std::unique_ptr<SerializedType> deserialize (SerializerIterator& sit, SField::ref name)
     {
         return std::unique_ptr<SerializedType> (construct (sit, name));
@@ -104,6 +111,17 @@ private:
     {
         return new STVariableLength (*this);
     }
+
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
+
     static STVariableLength* construct (SerializerIterator&, SField::ref);
 };
 
@@ -129,6 +147,12 @@ public:
     {
         ;
     }
+    STAccount (STAccount const&) = default;
+    STAccount (STAccount&& other) : STVariableLength (std::move (other))
+    {
+        ;
+    }
+    STAccount& operator= (STAccount const&) = default;
     static std::unique_ptr<SerializedType> deserialize (SerializerIterator& sit, SField::ref name)
     {
         return std::unique_ptr<SerializedType> (construct (sit, name));
@@ -167,6 +191,17 @@ private:
     {
         return new STAccount (*this);
     }
+
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
+
     static STAccount* construct (SerializerIterator&, SField::ref);
 };
 
@@ -357,6 +392,16 @@ public:
         ;
     }
 
+    STPathSet (STPathSet const&) = default;
+
+    STPathSet (STPathSet&& other)
+        : SerializedType (other), value (std::move (other.value))
+    {
+        ;
+    }
+
+    STPathSet& operator= (STPathSet const&) = default;
+
     explicit STPathSet (const std::vector<STPath>& v) : value (v)
     {
         ;
@@ -477,6 +522,17 @@ private:
     {
         return new STPathSet (*this);
     }
+
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
+
     static STPathSet* construct (SerializerIterator&, SField::ref);
 };
 
@@ -493,6 +549,14 @@ public:
     {
         ;
     }
+    STVector256 (SerializerIterator& sit, SField::ref n);
+    STVector256 (STVector256 const&) = default;
+    STVector256 (STVector256&& other)
+        : SerializedType (other), mValue (std::move (other.mValue))
+    {
+        ;
+    }
+    STVector256& operator= (STVector256 const&) = default;
     STVector256 (SField::ref n, const std::vector<uint256>& v) : SerializedType (n), mValue (v)
     {
         ;
@@ -587,6 +651,17 @@ private:
     {
         return new STVector256 (*this);
     }
+
+    SerializedType* copy (std::size_t n, void* buf) const override
+    {
+        return emplace (n, buf, *this);
+    }
+
+    SerializedType* move (std::size_t n, void* buf) override
+    {
+        return emplace (n, buf, std::move (*this));
+    }
+
     static STVector256* construct (SerializerIterator&, SField::ref);
 };
 
@@ -60,6 +60,19 @@ public:
     */
     virtual Status fetch (void const* key, NodeObject::Ptr* pObject) = 0;
 
+    /** Fetch a group of objects.
+        The objects are returned in the same order as the keys. Objects
+        which are not found or fail to decode are left as `nullptr`.
+        Implementations should take advantage of whatever multi-key read
+        support the underlying database offers.
+        @note This will be called concurrently.
+        @param keys Pointers to the key data.
+        @param objects [out] The created objects, one per key.
+        @return `ok` unless an error other than `notFound` was encountered.
+    */
+    virtual Status fetchBatch (std::vector <uint256 const*> const& keys,
+        std::vector <NodeObject::Ptr>& objects) = 0;
+
     /** Store a single object.
         Depending on the implementation this may happen immediately
         or deferred using a scheduled task.
@@ -68,6 +81,14 @@ public:
     */
     virtual void store (NodeObject::Ptr const& object) = 0;
 
+    /** Store a group of objects the way @ref store stores one.
+        A backend which defers its writes hands the whole group to its
+        scheduled task at once, and returns without waiting for the write.
+        @note This will be called concurrently.
+        @param batch The objects to store.
+    */
+    virtual void queueBatch (Batch const& batch) = 0;
+
     /** Store a group of objects.        
         @note This function will not be called concurrently with
               itself or @ref store.
@@ -21,6 +21,7 @@
 #define RIPPLE_NODESTORE_DATABASE_H_INCLUDED
 
 #include <ripple/nodestore/NodeObject.h>
+#include <ripple/nodestore/Types.h>
 
 namespace ripple {
 namespace NodeStore {
@@ -64,6 +65,19 @@ public:
     */
     virtual NodeObject::pointer fetch (uint256 const& hash) = 0;
 
+    /** Fetch a group of objects.
+        Objects already in the cache are returned directly, the remaining
+        keys are retrieved from the backend(s) in a single operation. The
+        results are added to the positive and negative caches.
+
+        @note This can be called concurrently.
+        @param hashes The keys of the objects to retrieve.
+        @return The objects, in the same order as `hashes`. An entry is
+                nullptr if its object couldn't be retrieved.
+    */
+    virtual std::vector <NodeObject::pointer> fetchBatch (
+        std::vector <uint256> const& hashes) = 0;
+
     /** Fetch an object without waiting.
         If I/O is required to determine whether or not the object is present,
         `false` is returned. Otherwise, `true` is returned and `object` is set
@@ -77,6 +91,18 @@ public:
     */
     virtual bool asyncFetch (uint256 const& hash, NodeObject::pointer& object) = 0;
 
+    /** Fetch an object only if no I/O is needed.
+        This is the same as asyncFetch, except that no read is scheduled
+        when I/O would be required. Callers use this to collect keys
+        which they then read together with fetchBatch.
+
+        @note This can be called concurrently.
+        @param hash The key of the object to retrieve
+        @param object The object retrieved
+        @return Whether the operation completed
+    */
+    virtual bool fetchIfCached (uint256 const& hash, NodeObject::pointer& object) = 0;
+
     /** Wait for all currently pending async reads to complete.
     */
     virtual void waitReads () = 0;
@@ -103,6 +129,16 @@ public:
                         Blob&& data,
                         uint256 const& hash) = 0;
 
+    /** Store a group of objects.
+        The objects are added to the cache and handed to the backend(s)
+        together, so a backend which batches its writes receives them as
+        one batch rather than picking them up a few at a time. As with
+        store, the write may be deferred to the backend's scheduled task.
+
+        @param batch The objects to store.
+    */
+    virtual void storeBatch (Batch const& batch) = 0;
+
     /** Visit every object in the database
         This is usually called during import.
 
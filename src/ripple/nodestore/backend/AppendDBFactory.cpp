@@ -0,0 +1,867 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#if RIPPLE_APPENDDB_AVAILABLE
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ripple {
+namespace NodeStore {
+
+/** An append-only backend.
+
+    Node objects are immutable and addressed by their hash, so nothing is
+    ever updated or deleted. Encoded objects are appended to a sequence of
+    segment files, and found through an open addressed hash table kept in
+    a separate index file. Both are memory mapped: a fetch probes the table
+    and decodes the record in place. Nothing is ever compacted.
+
+    Each segment starts with a header, followed by records:
+
+    Bytes
+    0...3       Size of the value, 32-bit big endian integer
+    4...35      Key
+    36...end    Value, as produced by EncodedBlob
+
+    The index is a header followed by a power of two number of buckets,
+    each holding the first eight bytes of a key and the position of its
+    record. A position is the segment number in the high bits and the
+    offset within the segment in the low bits; zero marks an empty bucket.
+    The table is doubled when it becomes half full.
+
+    The index header records the position up to which the segments are
+    indexed. Records past it, left behind when the process stopped during
+    a write, are indexed again when the backend is opened, and a partial
+    record at the end of a segment is cut off.
+*/
+class AppendDBBackend
+    : public Backend
+    , public BatchWriter::Callback
+    , public beast::LeakChecked <AppendDBBackend>
+{
+private:
+    /** An open file with an optional memory mapping. */
+    class MappedFile
+    {
+    public:
+        MappedFile ()
+            : m_fd (-1)
+            , m_data (nullptr)
+            , m_capacity (0)
+            , m_size (0)
+        {
+        }
+
+        MappedFile (MappedFile&& other)
+            : m_fd (other.m_fd)
+            , m_data (other.m_data)
+            , m_capacity (other.m_capacity)
+            , m_size (other.m_size.load ())
+        {
+            other.m_fd = -1;
+            other.m_data = nullptr;
+        }
+
+        MappedFile& operator= (MappedFile&& other)
+        {
+            close ();
+            std::swap (m_fd, other.m_fd);
+            std::swap (m_data, other.m_data);
+            m_capacity = other.m_capacity;
+            m_size = other.m_size.load ();
+            return *this;
+        }
+
+        MappedFile (MappedFile const&) = delete;
+        MappedFile& operator= (MappedFile const&) = delete;
+
+        ~MappedFile ()
+        {
+            close ();
+        }
+
+        /** Open the file, returning `false` if it does not exist. */
+        bool open (std::string const& path, bool create)
+        {
+            close ();
+
+            m_fd = ::open (path.c_str (), O_RDWR | (create ? O_CREAT : 0), 0644);
+
+            if (m_fd == -1)
+            {
+                if (errno == ENOENT && ! create)
+                    return false;
+
+                fail ("open", path);
+            }
+
+            struct stat st;
+            if (::fstat (m_fd, &st) != 0)
+                fail ("stat", path);
+
+            m_size = st.st_size;
+            return true;
+        }
+
+        /** Map the first `capacity` bytes of the file.
+            The mapping may extend past the end of the file, so that
+            appended data becomes visible through it without remapping.
+        */
+        void map (std::uint64_t capacity, bool writable)
+        {
+            assert (m_data == nullptr);
+
+            void* const data = ::mmap (nullptr, capacity,
+                PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, m_fd, 0);
+
+            if (data == MAP_FAILED)
+                fail ("map");
+
+            m_data = static_cast <std::uint8_t*> (data);
+            m_capacity = capacity;
+        }
+
+        void append (void const* data, std::size_t bytes)
+        {
+            std::uint8_t const* p = static_cast <std::uint8_t const*> (data);
+
+            while (bytes > 0)
+            {
+                ssize_t const written = ::pwrite (m_fd, p, bytes, m_size);
+
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    fail ("write");
+                }
+
+                p += written;
+                bytes -= written;
+                m_size += written;
+            }
+        }
+
+        void resize (std::uint64_t size)
+        {
+            if (::ftruncate (m_fd, size) != 0)
+                fail ("truncate");
+
+            m_size = size;
+        }
+
+        void close ()
+        {
+            if (m_data != nullptr)
+                ::munmap (m_data, m_capacity);
+
+            if (m_fd != -1)
+                ::close (m_fd);
+
+            m_fd = -1;
+            m_data = nullptr;
+        }
+
+        std::uint8_t* data () const
+        {
+            return m_data;
+        }
+
+        std::uint64_t capacity () const
+        {
+            return m_capacity;
+        }
+
+        std::uint64_t size () const
+        {
+            return m_size;
+        }
+
+    private:
+        static void fail (char const* what, std::string const& path = std::string ())
+        {
+            throw std::runtime_error (std::string ("AppendDB unable to ") +
+                what + (path.empty () ? "" : " " + path) + ": " +
+                    std::strerror (errno));
+        }
+
+        int m_fd;
+        std::uint8_t* m_data;
+        std::uint64_t m_capacity;
+
+        // Written by the appender and read by find, which don't share a lock
+        std::atomic <std::uint64_t> m_size;
+    };
+
+    struct IndexHeader
+    {
+        char magic [8];
+        std::uint64_t buckets;
+        std::uint64_t count;
+        std::uint64_t end;
+    };
+
+    struct Bucket
+    {
+        std::uint64_t tag;
+        std::uint64_t position;
+    };
+
+    enum
+    {
+        // Segment header, which also keeps offset zero free
+        segmentHeaderBytes = 16,
+
+        // Size field preceding the key of each record
+        recordSizeBytes = 4,
+
+        // Index header, padded to keep the buckets aligned
+        indexHeaderBytes = 64,
+
+        // Bits of a position holding the offset within its segment
+        offsetBits = 40,
+
+        defaultSegmentMegabytes = 1024,
+        minSegmentMegabytes = 16,
+
+        // Every offset in a segment must fit in offsetBits
+        maxSegmentMegabytes = 1 << (offsetBits - 20)
+    };
+
+    static std::uint64_t const initialBuckets = 1 << 16;
+
+public:
+    AppendDBBackend (size_t keyBytes, Parameters const& keyValues,
+        Scheduler& scheduler, beast::Journal journal)
+        : m_journal (journal)
+        , m_keyBytes (keyBytes)
+        , m_name (keyValues ["path"].toStdString ())
+        , m_segmentBytes (std::uint64_t (std::min (int (maxSegmentMegabytes),
+            std::max (int (minSegmentMegabytes), keyValues ["segment_mb"].isEmpty ()
+                ? int (defaultSegmentMegabytes)
+                : keyValues ["segment_mb"].getIntValue ()))) * 1024 * 1024)
+        , m_batch (*this, scheduler)
+    {
+        if (m_name.empty ())
+            throw std::runtime_error ("Missing path in AppendDBFactory backend");
+
+        static_bassert (sizeof (IndexHeader) <= indexHeaderBytes);
+
+        if (::mkdir (m_name.c_str (), 0755) != 0 && errno != EEXIST)
+            throw std::runtime_error ("Unable to create AppendDB directory " +
+                m_name + ": " + std::strerror (errno));
+
+        openSegments ();
+        openIndex ();
+        recover ();
+    }
+
+    std::string
+    getName ()
+    {
+        return m_name;
+    }
+
+    //--------------------------------------------------------------------------
+
+    Status
+    fetch (void const* key, NodeObject::Ptr* pObject)
+    {
+        pObject->reset ();
+
+        std::uint8_t const* record;
+        std::uint64_t bytes;
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            record = find (key, bytes);
+        }
+
+        if (record == nullptr)
+            return notFound;
+
+        if (recordSizeBytes + m_keyBytes + recordValueBytes (record) > bytes)
+            return dataCorrupt;
+
+        // Segment mappings are never moved, the record can be read unlocked
+        DecodedBlob decoded (key, record + recordSizeBytes + m_keyBytes,
+            recordValueBytes (record));
+
+        if (! decoded.wasOk ())
+            return dataCorrupt;
+
+        *pObject = decoded.createObject ();
+        return ok;
+    }
+
+    Status
+    fetchBatch (std::vector <uint256 const*> const& keys,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        objects.assign (keys.size (), NodeObject::Ptr ());
+
+        std::vector <std::uint8_t const*> records (keys.size ());
+        std::vector <std::uint64_t> bytes (keys.size ());
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+
+            for (std::size_t i = 0; i < keys.size (); ++i)
+                records [i] = find (keys [i]->begin (), bytes [i]);
+        }
+
+        Status status (ok);
+
+        for (std::size_t i = 0; i < keys.size (); ++i)
+        {
+            if (records [i] == nullptr)
+                continue;
+
+            if (recordSizeBytes + m_keyBytes +
+                recordValueBytes (records [i]) > bytes [i])
+            {
+                status = dataCorrupt;
+                continue;
+            }
+
+            DecodedBlob decoded (keys [i]->begin (), records [i] +
+                recordSizeBytes + m_keyBytes, recordValueBytes (records [i]));
+
+            if (decoded.wasOk ())
+                objects [i] = decoded.createObject ();
+            else
+                status = dataCorrupt;
+        }
+
+        return status;
+    }
+
+    void
+    store (NodeObject::ref object)
+    {
+        m_batch.store (object);
+    }
+
+    void
+    queueBatch (Batch const& batch)
+    {
+        m_batch.store (batch);
+    }
+
+    void
+    storeBatch (Batch const& batch)
+    {
+        // Import and the batch writer can both get here at once
+        std::lock_guard <std::mutex> writeLock (m_writeMutex);
+
+        // Skip objects we already have, nothing is ever overwritten
+        std::vector <NodeObject::Ptr const*> objects;
+        objects.reserve (batch.size ());
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+
+            for (auto const& object : batch)
+            {
+                if (find (object->getHash ().begin ()) == nullptr)
+                    objects.push_back (&object);
+            }
+        }
+
+        if (objects.empty ())
+            return;
+
+        std::vector <std::uint64_t> positions;
+        positions.reserve (objects.size ());
+
+        // Only the holder of the write lock changes the segments, so the
+        // active one can be appended to without the index lock.
+        std::size_t segment (m_segments.size () - 1);
+        std::uint64_t offset (m_segments.back ().size ());
+        EncodedBlob encoded;
+
+        m_buffer.clear ();
+
+        for (auto const object : objects)
+        {
+            encoded.prepare (*object);
+
+            std::size_t const recordBytes =
+                recordSizeBytes + m_keyBytes + encoded.getSize ();
+
+            if (segmentHeaderBytes + recordBytes > m_segmentBytes)
+                throw std::runtime_error ("AppendDB object too large");
+
+            if (offset + m_buffer.size () + recordBytes > m_segments.back ().capacity ())
+            {
+                m_segments.back ().append (m_buffer.data (), m_buffer.size ());
+                m_buffer.clear ();
+
+                MappedFile file (createSegment (segment + 1));
+                {
+                    std::lock_guard <std::mutex> lock (m_mutex);
+                    m_segments.push_back (std::move (file));
+                }
+
+                ++segment;
+                offset = m_segments.back ().size ();
+            }
+
+            positions.push_back ((std::uint64_t (segment) << offsetBits) +
+                offset + m_buffer.size ());
+
+            std::uint32_t const valueBytes = static_cast <std::uint32_t> (
+                encoded.getSize ());
+            std::uint8_t const size [recordSizeBytes] = {
+                std::uint8_t (valueBytes >> 24), std::uint8_t (valueBytes >> 16),
+                std::uint8_t (valueBytes >> 8), std::uint8_t (valueBytes) };
+            std::uint8_t const* const key =
+                static_cast <std::uint8_t const*> (encoded.getKey ());
+            std::uint8_t const* const value =
+                static_cast <std::uint8_t const*> (encoded.getData ());
+
+            m_buffer.insert (m_buffer.end (), size, size + recordSizeBytes);
+            m_buffer.insert (m_buffer.end (), key, key + m_keyBytes);
+            m_buffer.insert (m_buffer.end (), value, value + encoded.getSize ());
+        }
+
+        m_segments.back ().append (m_buffer.data (), m_buffer.size ());
+
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        for (std::size_t i = 0; i < objects.size (); ++i)
+            insert ((*objects [i])->getHash ().begin (), positions [i]);
+
+        indexHeader ().end = endPosition ();
+    }
+
+    void
+    for_each (std::function <void(NodeObject::Ptr)> f)
+    {
+        for (auto const& segment : m_segments)
+        {
+            std::uint64_t offset = segmentHeaderBytes;
+
+            while (offset < segment.size ())
+            {
+                std::uint8_t const* const record = segment.data () + offset;
+
+                if (offset + recordSizeBytes + m_keyBytes > segment.size () ||
+                    offset + recordSizeBytes + m_keyBytes +
+                        recordValueBytes (record) > segment.size ())
+                {
+                    if (m_journal.fatal) m_journal.fatal <<
+                        "Corrupt AppendDB record length at offset " << offset;
+                    break;
+                }
+
+                std::uint32_t const valueBytes = recordValueBytes (record);
+
+                DecodedBlob decoded (record + recordSizeBytes,
+                    record + recordSizeBytes + m_keyBytes, valueBytes);
+
+                if (decoded.wasOk ())
+                {
+                    f (decoded.createObject ());
+                }
+                else
+                {
+                    // Uh oh, corrupted data!
+                    if (m_journal.fatal) m_journal.fatal <<
+                        "Corrupt NodeObject #" << uint256::fromVoid (
+                            record + recordSizeBytes);
+                }
+
+                offset += recordSizeBytes + m_keyBytes + valueBytes;
+            }
+        }
+    }
+
+    int
+    getWriteLoad ()
+    {
+        return m_batch.getWriteLoad ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void
+    writeBatch (Batch const& batch)
+    {
+        storeBatch (batch);
+    }
+
+private:
+    std::string segmentPath (std::size_t segment) const
+    {
+        char name [32];
+        std::snprintf (name, sizeof (name), "/segment.%06u",
+            static_cast <unsigned> (segment));
+        return m_name + name;
+    }
+
+    std::string indexPath () const
+    {
+        return m_name + "/index";
+    }
+
+    static std::uint32_t recordValueBytes (std::uint8_t const* record)
+    {
+        return (std::uint32_t (record [0]) << 24) | (std::uint32_t (record [1]) << 16) |
+               (std::uint32_t (record [2]) << 8)  |  std::uint32_t (record [3]);
+    }
+
+    static std::uint64_t makeTag (void const* key)
+    {
+        std::uint64_t tag;
+        std::memcpy (&tag, key, sizeof (tag));
+        return tag;
+    }
+
+    std::uint64_t endPosition () const
+    {
+        return (std::uint64_t (m_segments.size () - 1) << offsetBits) +
+            m_segments.back ().size ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void mapSegment (MappedFile& file)
+    {
+        // A segment written with a larger segment size is mapped whole
+        file.map (std::max (m_segmentBytes, file.size ()), false);
+    }
+
+    MappedFile createSegment (std::size_t segment)
+    {
+        MappedFile file;
+        file.open (segmentPath (segment), true);
+        file.resize (0);
+
+        std::uint8_t header [segmentHeaderBytes] = { 0 };
+        std::memcpy (header, "AppendDB", 8);
+        file.append (header, sizeof (header));
+
+        mapSegment (file);
+        return file;
+    }
+
+    void openSegments ()
+    {
+        for (std::size_t segment = 0;; ++segment)
+        {
+            MappedFile file;
+
+            if (! file.open (segmentPath (segment), false))
+                break;
+
+            if (file.size () < segmentHeaderBytes)
+            {
+                // Interrupted while creating the segment
+                m_segments.push_back (createSegment (segment));
+                continue;
+            }
+
+            mapSegment (file);
+
+            if (std::memcmp (file.data (), "AppendDB", 8) != 0)
+                throw std::runtime_error ("Invalid AppendDB segment " +
+                    segmentPath (segment));
+
+            m_segments.push_back (std::move (file));
+        }
+
+        if (m_segments.empty ())
+            m_segments.push_back (createSegment (0));
+    }
+
+    //--------------------------------------------------------------------------
+
+    IndexHeader& indexHeader () const
+    {
+        return *reinterpret_cast <IndexHeader*> (m_index.data ());
+    }
+
+    Bucket* buckets () const
+    {
+        return reinterpret_cast <Bucket*> (m_index.data () + indexHeaderBytes);
+    }
+
+    static std::uint64_t indexBytes (std::uint64_t bucketCount)
+    {
+        return indexHeaderBytes + bucketCount * sizeof (Bucket);
+    }
+
+    /** Create an empty index file with the given number of buckets. */
+    MappedFile createIndex (std::string const& path, std::uint64_t bucketCount)
+    {
+        MappedFile file;
+        file.open (path, true);
+        file.resize (0);
+        file.resize (indexBytes (bucketCount));
+        file.map (indexBytes (bucketCount), true);
+
+        IndexHeader& header (*reinterpret_cast <IndexHeader*> (file.data ()));
+        std::memcpy (header.magic, "AppendIX", 8);
+        header.buckets = bucketCount;
+        header.count = 0;
+        header.end = segmentHeaderBytes;
+        return file;
+    }
+
+    void openIndex ()
+    {
+        bool const exists (m_index.open (indexPath (), false));
+
+        if (exists && m_index.size () >= indexHeaderBytes)
+        {
+            m_index.map (m_index.size (), true);
+
+            IndexHeader const& header (indexHeader ());
+            if (std::memcmp (header.magic, "AppendIX", 8) == 0 &&
+                header.buckets >= initialBuckets &&
+                (header.buckets & (header.buckets - 1)) == 0 &&
+                m_index.size () == indexBytes (header.buckets) &&
+                (header.end >> offsetBits) < m_segments.size () &&
+                (header.end & offsetMask ()) <=
+                    m_segments [header.end >> offsetBits].size ())
+                return;
+        }
+
+        if (exists && m_journal.warning) m_journal.warning <<
+            "Rebuilding AppendDB index for " << m_name;
+
+        m_index = createIndex (indexPath (), initialBuckets);
+    }
+
+    /** Index any records past the end recorded in the index. */
+    void recover ()
+    {
+        std::size_t segment (indexHeader ().end >> offsetBits);
+        std::uint64_t offset (indexHeader ().end & offsetMask ());
+        std::size_t recovered (0);
+
+        for (; segment < m_segments.size (); ++segment, offset = segmentHeaderBytes)
+        {
+            MappedFile& file (m_segments [segment]);
+
+            while (offset + recordSizeBytes + m_keyBytes <= file.size ())
+            {
+                std::uint8_t const* const record = file.data () + offset;
+                std::uint64_t const recordBytes = recordSizeBytes + m_keyBytes +
+                    recordValueBytes (record);
+
+                if (recordValueBytes (record) < blobHeaderBytes ||
+                        offset + recordBytes > file.size ())
+                    break;
+
+                insert (record + recordSizeBytes,
+                    (std::uint64_t (segment) << offsetBits) + offset);
+
+                offset += recordBytes;
+                ++recovered;
+            }
+
+            if (offset != file.size ())
+            {
+                if (m_journal.warning) m_journal.warning <<
+                    "Discarding " << (file.size () - offset) <<
+                    " bytes of partial AppendDB record in " << segmentPath (segment);
+
+                file.resize (offset);
+            }
+        }
+
+        if (recovered > 0 && m_journal.info) m_journal.info <<
+            "Indexed " << recovered << " AppendDB records in " << m_name;
+
+        indexHeader ().end = endPosition ();
+    }
+
+    static std::uint64_t offsetMask ()
+    {
+        return (std::uint64_t (1) << offsetBits) - 1;
+    }
+
+    /** Returns the record for a key, or `nullptr` if there is none.
+        The caller must hold the lock.
+    */
+    std::uint8_t const* find (void const* key) const
+    {
+        std::uint64_t bytes;
+        return find (key, bytes);
+    }
+
+    /** Returns the record for a key, or `nullptr` if there is none.
+        `bytes` is set to the number of bytes from the start of the record
+        to the end of its segment, which bounds its value.
+        The caller must hold the lock.
+    */
+    std::uint8_t const* find (void const* key, std::uint64_t& bytes) const
+    {
+        std::uint64_t const tag (makeTag (key));
+        std::uint64_t const mask (indexHeader ().buckets - 1);
+        Bucket const* const table (buckets ());
+
+        for (std::uint64_t i = tag & mask;; i = (i + 1) & mask)
+        {
+            Bucket const& bucket (table [i]);
+
+            if (bucket.position == 0)
+                return nullptr;
+
+            if (bucket.tag != tag)
+                continue;
+
+            std::size_t const segment (bucket.position >> offsetBits);
+            std::uint64_t const offset (bucket.position & offsetMask ());
+
+            if (segment >= m_segments.size () ||
+                    offset + recordSizeBytes + m_keyBytes > m_segments [segment].size ())
+                continue;
+
+            std::uint8_t const* const record = m_segments [segment].data () + offset;
+
+            if (std::memcmp (record + recordSizeBytes, key, m_keyBytes) == 0)
+            {
+                bytes = m_segments [segment].size () - offset;
+                return record;
+            }
+        }
+    }
+
+    /** Add a key to the index. The caller must hold the lock. */
+    void insert (void const* key, std::uint64_t position)
+    {
+        if (find (key) != nullptr)
+            return;
+
+        if ((indexHeader ().count + 1) * 2 > indexHeader ().buckets)
+            growIndex ();
+
+        place (buckets (), indexHeader ().buckets, makeTag (key), position);
+        ++indexHeader ().count;
+    }
+
+    static void place (Bucket* table, std::uint64_t bucketCount,
+        std::uint64_t tag, std::uint64_t position)
+    {
+        std::uint64_t const mask (bucketCount - 1);
+        std::uint64_t i (tag & mask);
+
+        while (table [i].position != 0)
+            i = (i + 1) & mask;
+
+        table [i].tag = tag;
+        table [i].position = position;
+    }
+
+    /** Double the number of buckets. The caller must hold the lock. */
+    void growIndex ()
+    {
+        std::string const path (indexPath () + ".new");
+        std::uint64_t const bucketCount (indexHeader ().buckets * 2);
+        MappedFile index (createIndex (path, bucketCount));
+
+        Bucket* const table (reinterpret_cast <Bucket*> (
+            index.data () + indexHeaderBytes));
+
+        for (std::uint64_t i = 0; i < indexHeader ().buckets; ++i)
+        {
+            Bucket const& bucket (buckets () [i]);
+
+            if (bucket.position != 0)
+                place (table, bucketCount, bucket.tag, bucket.position);
+        }
+
+        IndexHeader& header (*reinterpret_cast <IndexHeader*> (index.data ()));
+        header.count = indexHeader ().count;
+        header.end = indexHeader ().end;
+
+        if (std::rename (path.c_str (), indexPath ().c_str ()) != 0)
+            throw std::runtime_error ("Unable to replace AppendDB index " +
+                indexPath () + ": " + std::strerror (errno));
+
+        m_index = std::move (index);
+    }
+
+private:
+    beast::Journal m_journal;
+    size_t const m_keyBytes;
+    std::string const m_name;
+    std::uint64_t const m_segmentBytes;
+
+    // Held by storeBatch for the appends and any new segment. Taken
+    // before m_mutex.
+    std::mutex m_writeMutex;
+
+    // Protects the index and the list of segments
+    std::mutex m_mutex;
+    std::vector <MappedFile> m_segments;
+    MappedFile m_index;
+
+    // Used by storeBatch to assemble records, under the write lock
+    std::vector <std::uint8_t> m_buffer;
+
+    // Declared last so pending writes finish before the files are closed
+    BatchWriter m_batch;
+};
+
+//------------------------------------------------------------------------------
+
+class AppendDBFactory : public Factory
+{
+public:
+    beast::String
+    getName () const
+    {
+        return "AppendDB";
+    }
+
+    std::unique_ptr <Backend>
+    createInstance (
+        size_t keyBytes,
+        Parameters const& keyValues,
+        Scheduler& scheduler,
+        beast::Journal journal)
+    {
+        return std::make_unique <AppendDBBackend> (
+            keyBytes, keyValues, scheduler, journal);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr <Factory>
+make_AppendDBFactory ()
+{
+    return std::make_unique <AppendDBFactory> ();
+}
+
+}
+}
+
+#endif
@@ -148,12 +148,61 @@ public:
         return status;
     }
 
+    Status
+    fetchBatch (std::vector <uint256 const*> const& keys,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        objects.assign (keys.size (), NodeObject::Ptr ());
+
+        // Each key is read with Get rather than by seeking an iterator,
+        // so that the table bloom filters can rule out absent keys.
+        Status status (ok);
+
+        leveldb::ReadOptions const options;
+        std::string string;
+
+        for (std::size_t i = 0; i < keys.size (); ++i)
+        {
+            leveldb::Slice const slice (reinterpret_cast <char const*> (
+                keys [i]->begin ()), m_keyBytes);
+
+            leveldb::Status const getStatus = m_db->Get (options, slice, &string);
+
+            if (getStatus.ok ())
+            {
+                DecodedBlob decoded (slice.data (),
+                    string.data (), string.size ());
+
+                if (decoded.wasOk ())
+                    objects [i] = decoded.createObject ();
+                else
+                    status = dataCorrupt;
+            }
+            else if (getStatus.IsCorruption ())
+            {
+                status = dataCorrupt;
+            }
+            else if (! getStatus.IsNotFound ())
+            {
+                status = unknown;
+            }
+        }
+
+        return status;
+    }
+
     void
     store (NodeObject::ref object)
     {
         m_batch.store (object);
     }
 
+    void
+    queueBatch (Batch const& batch)
+    {
+        m_batch.store (batch);
+    }
+
     void
     storeBatch (Batch const& batch)
     {
@@ -68,6 +68,26 @@ public:
         return ok;
     }
 
+    Status
+    fetchBatch (std::vector <uint256 const*> const& keys,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        objects.clear ();
+        objects.reserve (keys.size ());
+
+        for (auto const key : keys)
+        {
+            Map::iterator iter = m_map.find (*key);
+
+            if (iter != m_map.end ())
+                objects.push_back (iter->second);
+            else
+                objects.push_back (nullptr);
+        }
+
+        return ok;
+    }
+
     void
     store (NodeObject::ref object)
     {
@@ -79,6 +99,12 @@ public:
         }
     }
 
+    void
+    queueBatch (Batch const& batch)
+    {
+        storeBatch (batch);
+    }
+
     void
     storeBatch (Batch const& batch)
     {
@@ -43,10 +43,23 @@ public:
         return notFound;
     }
     
+    Status
+    fetchBatch (std::vector <uint256 const*> const& keys,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        objects.assign (keys.size (), NodeObject::Ptr ());
+        return ok;
+    }
+
     void
     store (NodeObject::ref object)
     {
     }
+
+    void
+    queueBatch (Batch const& batch)
+    {
+    }
     
     void
     storeBatch (Batch const& batch)
@@ -235,12 +235,64 @@ public:
         return status;
     }
 
+    Status
+    fetchBatch (std::vector <uint256 const*> const& keys,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        objects.assign (keys.size (), NodeObject::Ptr ());
+
+        std::vector <rocksdb::Slice> slices;
+        slices.reserve (keys.size ());
+        for (auto const key : keys)
+            slices.emplace_back (reinterpret_cast <char const*> (
+                key->begin ()), m_keyBytes);
+
+        Status status (ok);
+
+        rocksdb::ReadOptions const options;
+        std::vector <std::string> values;
+        std::vector <rocksdb::Status> const getStatus (
+            m_db->MultiGet (options, slices, &values));
+
+        for (std::size_t i = 0; i < keys.size (); ++i)
+        {
+            if (getStatus [i].ok ())
+            {
+                DecodedBlob decoded (slices [i].data (),
+                    values [i].data (), values [i].size ());
+
+                if (decoded.wasOk ())
+                    objects [i] = decoded.createObject ();
+                else
+                    status = dataCorrupt;
+            }
+            else if (getStatus [i].IsCorruption ())
+            {
+                status = dataCorrupt;
+            }
+            else if (! getStatus [i].IsNotFound ())
+            {
+                status = Status (customCode + getStatus [i].code());
+
+                m_journal.error << getStatus [i].ToString ();
+            }
+        }
+
+        return status;
+    }
+
     void
     store (NodeObject::ref object)
     {
         m_batch.store (object);
     }
 
+    void
+    queueBatch (Batch const& batch)
+    {
+        m_batch.store (batch);
+    }
+
     void
     storeBatch (Batch const& batch)
     {
@@ -49,6 +49,21 @@ BatchWriter::store (NodeObject::ref object)
     }
 }
 
+void
+BatchWriter::store (Batch const& batch)
+{
+    std::lock_guard<decltype(mWriteMutex)> sl (mWriteMutex);
+
+    mWriteSet.insert (mWriteSet.end (), batch.begin (), batch.end ());
+
+    if (! mWritePending)
+    {
+        mWritePending = true;
+
+        m_scheduler.scheduleTask (*this);
+    }
+}
+
 int
 BatchWriter::getWriteLoad ()
 {
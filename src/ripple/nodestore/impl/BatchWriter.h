@@ -62,6 +62,12 @@ public:
     */
     void store (NodeObject::Ptr const& object);
 
+    /** Store a group of objects.
+
+        The objects are added to the batch together, under one lock.
+    */
+    void store (Batch const& batch);
+
     /** Get an estimate of the amount of writing I/O pending. */
     int getWriteLoad ();
 
@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+#ifndef RIPPLE_NODESTORE_BLOBFORMAT_H_INCLUDED
+#define RIPPLE_NODESTORE_BLOBFORMAT_H_INCLUDED
+
+#include <ripple/module/data/protocol/HashPrefix.h>
+
+namespace ripple {
+namespace NodeStore {
+
+/*  Database format of a NodeObject:
+
+    Bytes
+
+    0...3       LedgerIndex     32-bit big endian integer
+    4...7       Unused?         An unused copy of the LedgerIndex
+    8           char            Low 4 bits:  One of NodeObjectType
+                                High 4 bits: One of BlobEncoding
+    9...end                     The body of the object data, as
+                                described by the encoding
+
+    Blobs written before encodings were introduced always have zero in
+    the high bits of byte 8, so they decode as blobEncodingRaw.
+*/
+
+/** How the body of the object data is stored. */
+enum BlobEncoding
+{
+    /** The object data, verbatim. */
+    blobEncodingRaw = 0,
+
+    /** A SHAMap inner node in prefix format, with the empty branches
+        dropped. The body is a 16-bit big endian bitmap of the non-empty
+        branches followed by the hash of each non-empty branch.
+    */
+    blobEncodingInnerNode = 1
+};
+
+enum
+{
+    // Size of the fixed header preceding the body
+    blobHeaderBytes = 9,
+
+    // Number of branches in a SHAMap inner node
+    innerNodeBranches = 16,
+
+    // Size of a child hash in a SHAMap inner node
+    innerNodeHashBytes = 32,
+
+    // Size of a SHAMap inner node in prefix format
+    innerNodeBytes = 4 + innerNodeBranches * innerNodeHashBytes
+};
+
+}
+}
+
+#endif
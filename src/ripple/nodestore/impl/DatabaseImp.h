@@ -27,6 +27,7 @@
 #include <condition_variable>
 #include <set>
 #include <thread>
+#include <vector>
 
 namespace ripple {
 namespace NodeStore {
@@ -44,7 +45,7 @@ public:
     std::unique_ptr <Backend> m_fastBackend;
 
     // Positive cache
-    TaggedCache <uint256, NodeObject> m_cache;
+    ShardedTaggedCache <uint256, NodeObject> m_cache;
 
     // Negative cache
     KeyCache <uint256> m_negCache;
@@ -116,6 +117,12 @@ public:
         return false;
     }
 
+    bool fetchIfCached (uint256 const& hash, NodeObject::pointer& object)
+    {
+        object = m_cache.fetch (hash);
+        return object || m_negCache.touch_if_exists (hash);
+    }
+
     void waitReads ()
     {
         {
@@ -262,6 +269,130 @@ public:
         return object;
     }
 
+    std::vector <NodeObject::Ptr> fetchBatch (
+        std::vector <uint256> const& hashes) override
+    {
+        std::vector <NodeObject::Ptr> objects (hashes.size ());
+
+        // Indexes of the objects we have to go to disk for
+        std::vector <std::size_t> misses;
+
+        for (std::size_t i = 0; i < hashes.size (); ++i)
+        {
+            objects[i] = m_cache.fetch (hashes[i]);
+
+            if (! objects[i] && ! m_negCache.touch_if_exists (hashes[i]))
+                misses.push_back (i);
+        }
+
+        if (misses.empty ())
+            return objects;
+
+        FetchReport report;
+        report.isAsync = false;
+        report.wentToDisk = true;
+
+        auto const before = std::chrono::steady_clock::now();
+
+        // Which of the objects were found in the fast backend
+        std::vector <bool> inFastBackend (hashes.size (), false);
+
+        if (m_fastBackend != nullptr)
+        {
+            fetchBatchInternal (*m_fastBackend, hashes, misses, objects);
+
+            for (auto const i : misses)
+                inFastBackend[i] = (objects[i] != nullptr);
+        }
+
+        // Whatever is still missing comes from the main backend
+        std::vector <std::size_t> remaining;
+        remaining.reserve (misses.size ());
+        for (auto const i : misses)
+        {
+            if (objects[i] == nullptr)
+                remaining.push_back (i);
+        }
+
+        if (! remaining.empty ())
+            fetchBatchInternal (*m_backend, hashes, remaining, objects);
+
+        report.wasFound = false;
+
+        for (auto const i : misses)
+        {
+            NodeObject::Ptr& obj = objects[i];
+
+            if (obj == nullptr)
+            {
+                // Just in case a write occurred
+                obj = m_cache.fetch (hashes[i]);
+
+                if (obj == nullptr)
+                    m_negCache.insert (hashes[i]);
+            }
+            else
+            {
+                report.wasFound = true;
+
+                // Ensure all threads get the same object
+                m_cache.canonicalize (hashes[i], obj);
+
+                if (! inFastBackend[i] && m_fastBackend != nullptr)
+                    m_fastBackend->store (obj);
+            }
+        }
+
+        report.elapsed = std::chrono::duration_cast <std::chrono::milliseconds>
+            (std::chrono::steady_clock::now() - before);
+        m_scheduler.onFetch (report);
+
+        return objects;
+    }
+
+    /** Fetch the objects at the given indexes from a backend in one call.
+        Found objects are placed into the corresponding slots of `objects`.
+    */
+    void fetchBatchInternal (Backend& backend,
+        std::vector <uint256> const& hashes,
+        std::vector <std::size_t> const& indexes,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        std::vector <uint256 const*> keys;
+        keys.reserve (indexes.size ());
+        for (auto const i : indexes)
+            keys.push_back (&hashes[i]);
+
+        std::vector <NodeObject::Ptr> results;
+
+        Status const status = backend.fetchBatch (keys, results);
+
+        switch (status)
+        {
+        case ok:
+        case notFound:
+            break;
+
+        case dataCorrupt:
+            // VFALCO TODO Deal with encountering corrupt data!
+            //
+            if (m_journal.fatal) m_journal.fatal <<
+                "Corrupt NodeObject in batch of " << keys.size ();
+            break;
+
+        default:
+            if (m_journal.warning) m_journal.warning <<
+                "Unknown status=" << status;
+            break;
+        }
+
+        for (std::size_t i = 0; i < results.size (); ++i)
+        {
+            if (results[i] != nullptr)
+                objects[indexes[i]] = std::move (results[i]);
+        }
+    }
+
     //------------------------------------------------------------------------------
 
     void store (NodeObjectType type,
@@ -285,6 +416,36 @@ public:
             m_fastBackend->store (object);
     }
 
+    void storeBatch (Batch const& batch)
+    {
+        if (batch.empty ())
+            return;
+
+        Batch objects;
+        objects.reserve (batch.size ());
+
+        for (auto object : batch)
+        {
+            #if RIPPLE_VERIFY_NODEOBJECT_KEYS
+            assert (object->getHash () ==
+                Serializer::getSHA512Half (object->getData ()));
+            #endif
+
+            uint256 const hash (object->getHash ());
+
+            m_cache.canonicalize (hash, object, true);
+
+            m_negCache.erase (hash);
+
+            objects.push_back (std::move (object));
+        }
+
+        m_backend->queueBatch (objects);
+
+        if (m_fastBackend)
+            m_fastBackend->queueBatch (objects);
+    }
+
     //------------------------------------------------------------------------------
 
     float getCacheHitRate ()
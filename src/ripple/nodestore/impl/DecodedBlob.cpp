@@ -22,23 +22,16 @@ namespace NodeStore {
 
 DecodedBlob::DecodedBlob (void const* key, void const* value, int valueBytes)
 {
-    /*  Data format:
-
-        Bytes
-
-        0...3       LedgerIndex     32-bit big endian integer
-        4...7       Unused?         An unused copy of the LedgerIndex
-        8           char            One of NodeObjectType
-        9...end                     The body of the object data
-    */
+    // See BlobFormat.h for a description of the data format
 
     m_success = false;
     m_key = key;
     // VFALCO NOTE Ledger indexes should have started at 1
     m_ledgerIndex = LedgerIndex (-1);
     m_objectType = hotUNKNOWN;
+    m_encoding = blobEncodingRaw;
     m_objectData = nullptr;
-    m_dataBytes = beast::bmax (0, valueBytes - 9);
+    m_dataBytes = beast::bmax (0, valueBytes - blobHeaderBytes);
 
     if (valueBytes > 4)
     {
@@ -51,12 +44,13 @@ DecodedBlob::DecodedBlob (void const* key, void const* value, int valueBytes)
     if (valueBytes > 8)
     {
         unsigned char const* byte = static_cast <unsigned char const*> (value);
-        m_objectType = static_cast <NodeObjectType> (byte [8]);
+        m_objectType = static_cast <NodeObjectType> (byte [8] & 0x0f);
+        m_encoding = static_cast <BlobEncoding> (byte [8] >> 4);
     }
 
-    if (valueBytes > 9)
+    if (valueBytes > blobHeaderBytes)
     {
-        m_objectData = static_cast <unsigned char const*> (value) + 9;
+        m_objectData = static_cast <unsigned char const*> (value) + blobHeaderBytes;
 
         switch (m_objectType)
         {
@@ -71,6 +65,38 @@ DecodedBlob::DecodedBlob (void const* key, void const* value, int valueBytes)
             m_success = true;
             break;
         }
+
+        switch (m_encoding)
+        {
+        case blobEncodingRaw:
+            break;
+
+        case blobEncodingInnerNode:
+            // The bitmap must agree with the number of hashes present
+            if (m_dataBytes >= 2)
+            {
+                int const bitmap = (m_objectData [0] << 8) | m_objectData [1];
+
+                int branches = 0;
+                for (int branch = 0; branch < innerNodeBranches; ++branch)
+                {
+                    if (bitmap & (1 << branch))
+                        ++branches;
+                }
+
+                if (m_dataBytes != 2 + branches * innerNodeHashBytes)
+                    m_success = false;
+            }
+            else
+            {
+                m_success = false;
+            }
+            break;
+
+        default:
+            m_success = false;
+            break;
+        }
     }
 }
 
@@ -82,9 +108,38 @@ NodeObject::Ptr DecodedBlob::createObject ()
 
     if (m_success)
     {
-        Blob data (m_dataBytes);
+        Blob data;
+
+        if (m_encoding == blobEncodingInnerNode)
+        {
+            // Restore the prefix and the empty branches
+            data.resize (innerNodeBytes, 0);
+
+            std::uint32_t const prefix = HashPrefix::innerNode;
+            data [0] = static_cast <unsigned char> (prefix >> 24);
+            data [1] = static_cast <unsigned char> (prefix >> 16);
+            data [2] = static_cast <unsigned char> (prefix >> 8);
+            data [3] = static_cast <unsigned char> (prefix);
+
+            int const bitmap = (m_objectData [0] << 8) | m_objectData [1];
+            unsigned char const* in = m_objectData + 2;
+
+            for (int branch = 0; branch < innerNodeBranches; ++branch)
+            {
+                if (bitmap & (1 << (innerNodeBranches - 1 - branch)))
+                {
+                    memcpy (&data [4 + branch * innerNodeHashBytes], in,
+                        innerNodeHashBytes);
+                    in += innerNodeHashBytes;
+                }
+            }
+        }
+        else
+        {
+            data.resize (m_dataBytes);
 
-        memcpy (data.data (), m_objectData, m_dataBytes);
+            memcpy (data.data (), m_objectData, m_dataBytes);
+        }
 
         object = NodeObject::createObject (
             m_objectType, m_ledgerIndex, std::move(data), uint256::fromVoid(m_key));
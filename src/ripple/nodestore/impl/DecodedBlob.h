@@ -21,6 +21,7 @@
 #define RIPPLE_NODESTORE_DECODEDBLOB_H_INCLUDED
 
 #include <ripple/nodestore/NodeObject.h>
+#include <ripple/nodestore/impl/BlobFormat.h>
 
 namespace ripple {
 namespace NodeStore {
@@ -33,6 +34,8 @@ namespace NodeStore {
     all forms of corruption are detected so further analysis will be needed
     to eliminate false negatives.
 
+    Blobs in every encoding ever written by EncodedBlob can be decoded.
+
     @note This defines the database format of a NodeObject!
 */
 class DecodedBlob
@@ -53,6 +56,7 @@ private:
     void const* m_key;
     LedgerIndex m_ledgerIndex;
     NodeObjectType m_objectType;
+    BlobEncoding m_encoding;
     unsigned char const* m_objectData;
     int m_dataBytes;
 };
@@ -25,8 +25,29 @@ EncodedBlob::prepare (NodeObject::Ptr const& object)
 {
     m_key = object->getHash ().begin ();
 
+    Blob const& data (object->getData ());
+
+    // Count the empty branches of inner nodes, they are not stored
+    int emptyBranches = 0;
+
+    if (isInnerNode (data))
+    {
+        for (int branch = 0; branch < innerNodeBranches; ++branch)
+        {
+            if (isEmptyBranch (data, branch))
+                ++emptyBranches;
+        }
+    }
+
+    BlobEncoding const encoding = (emptyBranches != 0)
+        ? blobEncodingInnerNode : blobEncodingRaw;
+
     // This is how many bytes we need in the flat data
-    m_size = object->getData ().size () + 9;
+    if (encoding == blobEncodingInnerNode)
+        m_size = blobHeaderBytes + 2 +
+            (innerNodeBranches - emptyBranches) * innerNodeHashBytes;
+    else
+        m_size = blobHeaderBytes + data.size ();
 
     m_data.ensureSize (m_size);
 
@@ -43,11 +64,57 @@ EncodedBlob::prepare (NodeObject::Ptr const& object)
     {
         unsigned char* buf = static_cast <unsigned char*> (m_data.getData ());
 
-        buf [8] = static_cast <unsigned char> (object->getType ());
+        buf [8] = static_cast <unsigned char> (
+            object->getType () | (encoding << 4));
+
+        if (encoding == blobEncodingInnerNode)
+        {
+            std::uint16_t bitmap = 0;
+            unsigned char* out = &buf [blobHeaderBytes + 2];
+
+            for (int branch = 0; branch < innerNodeBranches; ++branch)
+            {
+                if (! isEmptyBranch (data, branch))
+                {
+                    bitmap |= 1 << (innerNodeBranches - 1 - branch);
+
+                    memcpy (out, &data [4 + branch * innerNodeHashBytes],
+                        innerNodeHashBytes);
+                    out += innerNodeHashBytes;
+                }
+            }
 
-        memcpy (&buf [9], object->getData ().data (), object->getData ().size ());
+            buf [blobHeaderBytes] = static_cast <unsigned char> (bitmap >> 8);
+            buf [blobHeaderBytes + 1] = static_cast <unsigned char> (bitmap);
+        }
+        else
+        {
+            memcpy (&buf [blobHeaderBytes], data.data (), data.size ());
+        }
     }
 }
 
+bool
+EncodedBlob::isInnerNode (Blob const& data)
+{
+    if (data.size () != innerNodeBytes)
+        return false;
+
+    std::uint32_t const prefix =
+        (std::uint32_t (data [0]) << 24) | (std::uint32_t (data [1]) << 16) |
+        (std::uint32_t (data [2]) << 8)  |  std::uint32_t (data [3]);
+
+    return prefix == HashPrefix::innerNode;
+}
+
+bool
+EncodedBlob::isEmptyBranch (Blob const& data, int branch)
+{
+    unsigned char const* const hash = &data [4 + branch * innerNodeHashBytes];
+
+    return std::all_of (hash, hash + innerNodeHashBytes,
+        [](unsigned char c) { return c == 0; });
+}
+
 }
 }
@@ -20,13 +20,17 @@
 #ifndef RIPPLE_NODESTORE_ENCODEDBLOB_H_INCLUDED
 #define RIPPLE_NODESTORE_ENCODEDBLOB_H_INCLUDED
 
+#include <ripple/nodestore/impl/BlobFormat.h>
 #include <beast/module/core/memory/MemoryBlock.h>
 
 namespace ripple {
 namespace NodeStore {
 
 /** Utility for producing flattened node objects.
+    SHAMap inner nodes are stored without their empty branches, all other
+    objects are stored verbatim.
     @note This defines the database format of a NodeObject!
+    @see BlobFormat.h
 */
 // VFALCO TODO Make allocator aware and use short_alloc
 struct EncodedBlob
@@ -38,6 +42,9 @@ public:
     void const* getData () const noexcept { return m_data.getData (); }
 
 private:
+    static bool isInnerNode (Blob const& data);
+    static bool isEmptyBranch (Blob const& data, int branch);
+
     void const* m_key;
     beast::MemoryBlock m_data;
     size_t m_size;
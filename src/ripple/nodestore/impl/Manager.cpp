@@ -62,6 +62,10 @@ public:
     #if RIPPLE_ROCKSDB_AVAILABLE
         add_factory (make_RocksDBFactory ());
     #endif
+
+    #if RIPPLE_APPENDDB_AVAILABLE
+        add_factory (make_AppendDBFactory ());
+    #endif
     }
 
     Factory*
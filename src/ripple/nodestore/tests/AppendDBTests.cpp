@@ -0,0 +1,281 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <fstream>
+
+#if RIPPLE_APPENDDB_AVAILABLE
+
+namespace ripple {
+namespace NodeStore {
+
+// Tests the recovery and growth paths of the AppendDB backend
+//
+class AppendDB_test : public TestBase
+{
+public:
+    static std::unique_ptr <Backend> openBackend (Manager& manager,
+        Scheduler& scheduler, beast::File const& path)
+    {
+        beast::StringPairArray params;
+        params.set ("type", "appenddb");
+        params.set ("path", path.getFullPathName ());
+        params.set ("segment_mb", "16");
+
+        beast::Journal j;
+        return manager.make_Backend (params, scheduler, j);
+    }
+
+    // Produce a record as AppendDB lays it out in a segment
+    static Blob makeRecord (NodeObject::Ptr const& object)
+    {
+        EncodedBlob encoded;
+        encoded.prepare (object);
+
+        std::uint32_t const valueBytes = static_cast <std::uint32_t> (
+            encoded.getSize ());
+        std::uint8_t const* const key =
+            static_cast <std::uint8_t const*> (encoded.getKey ());
+        std::uint8_t const* const value =
+            static_cast <std::uint8_t const*> (encoded.getData ());
+
+        Blob record {
+            std::uint8_t (valueBytes >> 24), std::uint8_t (valueBytes >> 16),
+            std::uint8_t (valueBytes >> 8), std::uint8_t (valueBytes) };
+        record.insert (record.end (), key, key + object->getHash ().size ());
+        record.insert (record.end (), value, value + encoded.getSize ());
+        return record;
+    }
+
+    void expectStored (Backend& backend, Batch const& batch)
+    {
+        Batch copy;
+        fetchCopyOfBatch (backend, &copy, batch);
+        expect (areBatchesEqual (batch, copy), "Should be equal");
+    }
+
+    //--------------------------------------------------------------------------
+
+    void testRecover (std::int64_t const seedValue)
+    {
+        testcase ("recover");
+
+        std::unique_ptr <Manager> manager (make_Manager ());
+        DummyScheduler scheduler;
+        beast::File const path (beast::File::createTempFile ("node_db"));
+
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjectsToTest, seedValue);
+
+        Batch extra;
+        createPredictableBatch (extra, numObjectsToTest, 2, seedValue);
+
+        openBackend (*manager, scheduler, path)->storeBatch (batch);
+
+        // Leave a whole record past the end the index knows about, then
+        // the start of another, as if we stopped in the middle of a write.
+        beast::File const segment (path.getChildFile ("segment.000000"));
+        Blob const whole (makeRecord (extra [0]));
+        Blob const partial (makeRecord (extra [1]));
+        expect (segment.appendData (whole.data (), whole.size ()));
+        std::int64_t const size (segment.getSize ());
+        expect (segment.appendData (partial.data (), partial.size () / 2));
+
+        {
+            auto const backend (openBackend (*manager, scheduler, path));
+            expectStored (*backend, batch);
+
+            NodeObject::Ptr object;
+            expect (backend->fetch (extra [0]->getHash ().cbegin (),
+                &object) == ok, "Should be ok");
+            expect (object != nullptr && object->isCloneOf (extra [0]),
+                "Should be equal");
+
+            expect (backend->fetch (extra [1]->getHash ().cbegin (),
+                &object) == notFound, "Should not be found");
+        }
+
+        expect (segment.getSize () == size, "Partial record should be cut off");
+
+        // Nothing more to recover the second time
+        expectStored (*openBackend (*manager, scheduler, path), batch);
+
+        path.deleteRecursively ();
+    }
+
+    void testCorruptLength (std::int64_t const seedValue)
+    {
+        testcase ("corrupt length");
+
+        std::unique_ptr <Manager> manager (make_Manager ());
+        DummyScheduler scheduler;
+        beast::File const path (beast::File::createTempFile ("node_db"));
+
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjectsToTest, seedValue);
+
+        openBackend (*manager, scheduler, path)->storeBatch (batch);
+
+        // Give the last record a length running far past the end of the
+        // segment. The index still points at it.
+        beast::File const segment (path.getChildFile ("segment.000000"));
+        std::int64_t const offset (segment.getSize () -
+            makeRecord (batch.back ()).size ());
+        {
+            std::fstream file (segment.getFullPathName ().toStdString ().c_str (),
+                std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp (offset);
+            char const length [] = { '\x7f', '\xff', '\xff', '\xff' };
+            file.write (length, sizeof (length));
+            expect (file.good (), "Should write the length");
+        }
+
+        {
+            auto const backend (openBackend (*manager, scheduler, path));
+
+            NodeObject::Ptr object;
+            expect (backend->fetch (batch.back ()->getHash ().cbegin (),
+                &object) == dataCorrupt, "Should be corrupt");
+            expect (object == nullptr, "Should be null");
+
+            std::vector <uint256 const*> keys;
+            for (auto const& e : batch)
+                keys.push_back (&e->getHash ());
+
+            Batch objects;
+            expect (backend->fetchBatch (keys, objects) == dataCorrupt,
+                "Should be corrupt");
+            expect (objects.back () == nullptr, "Should be null");
+
+            Batch rest (batch.begin (), batch.end () - 1);
+            expectStored (*backend, rest);
+        }
+
+        path.deleteRecursively ();
+    }
+
+    void testRebuildIndex (std::int64_t const seedValue)
+    {
+        testcase ("rebuild index");
+
+        std::unique_ptr <Manager> manager (make_Manager ());
+        DummyScheduler scheduler;
+        beast::File const path (beast::File::createTempFile ("node_db"));
+        beast::File const index (path.getChildFile ("index"));
+
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjectsToTest, seedValue);
+
+        openBackend (*manager, scheduler, path)->storeBatch (batch);
+
+        // A missing index is rebuilt from the segments
+        expect (index.deleteFile ());
+        expectStored (*openBackend (*manager, scheduler, path), batch);
+        expect (index.existsAsFile ());
+
+        // So is one which isn't an index
+        char const garbage [] = "This is not an AppendDB index";
+        expect (index.replaceWithData (garbage, sizeof (garbage)));
+        expectStored (*openBackend (*manager, scheduler, path), batch);
+
+        path.deleteRecursively ();
+    }
+
+    void testGrowIndex (std::int64_t const seedValue)
+    {
+        testcase ("grow index");
+
+        std::unique_ptr <Manager> manager (make_Manager ());
+        DummyScheduler scheduler;
+        beast::File const path (beast::File::createTempFile ("node_db"));
+
+        // The index starts with 65536 buckets and doubles when half full
+        int const numObjects = 40000;
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjects, seedValue);
+
+        {
+            auto const backend (openBackend (*manager, scheduler, path));
+
+            for (int i = 0; i < numObjects; i += numObjectsToTest)
+            {
+                backend->storeBatch (Batch (batch.begin () + i,
+                    batch.begin () + std::min (i + numObjectsToTest, numObjects)));
+            }
+
+            expectStored (*backend, batch);
+        }
+
+        // A header and 16 bytes for each bucket
+        expect (path.getChildFile ("index").getSize () > 64 + 65536 * 16,
+            "Index should have grown");
+
+        expectStored (*openBackend (*manager, scheduler, path), batch);
+
+        path.deleteRecursively ();
+    }
+
+    void testRollover (std::int64_t const seedValue)
+    {
+        testcase ("segment rollover");
+
+        std::unique_ptr <Manager> manager (make_Manager ());
+        DummyScheduler scheduler;
+        beast::File const path (beast::File::createTempFile ("node_db"));
+
+        // About 20MB of objects, more than one 16MB segment holds
+        int const numObjects = 20000;
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjects, seedValue);
+
+        {
+            auto const backend (openBackend (*manager, scheduler, path));
+            backend->storeBatch (batch);
+            expectStored (*backend, batch);
+        }
+
+        expect (path.getChildFile ("segment.000001").existsAsFile (),
+            "Should have a second segment");
+        expect (path.getChildFile ("segment.000000").getSize () <=
+            16 * 1024 * 1024, "Segment should not pass its size");
+
+        expectStored (*openBackend (*manager, scheduler, path), batch);
+
+        path.deleteRecursively ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void run ()
+    {
+        int const seedValue = 50;
+
+        testRecover (seedValue);
+        testCorruptLength (seedValue);
+        testRebuildIndex (seedValue);
+        testGrowIndex (seedValue);
+        testRollover (seedValue);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(AppendDB,ripple_core,ripple);
+
+}
+}
+
+#endif
@@ -52,8 +52,10 @@ public:
             std::unique_ptr <Backend> backend (manager->make_Backend (
                 params, scheduler, j));
 
-            // Write the batch
-            storeBatch (*backend, batch);
+            // Write half the batch one at a time, and the rest as a group
+            std::size_t const half = batch.size () / 2;
+            storeBatch (*backend, Batch (batch.begin (), batch.begin () + half));
+            backend->queueBatch (Batch (batch.begin () + half, batch.end ()));
 
             {
                 // Read it back in
@@ -69,6 +71,30 @@ public:
                 fetchCopyOfBatch (*backend, &copy, batch);
                 expect (areBatchesEqual (batch, copy), "Should be equal");
             }
+
+            {
+                // Read it back in with one batched fetch
+                Batch copy;
+                fetchBatchCopyOfBatch (*backend, &copy, batch);
+                expect (areBatchesEqual (batch, copy), "Should be equal");
+            }
+
+            {
+                // Keys that were never stored come back as null
+                Batch missing;
+                createPredictableBatch (missing, numObjectsToTest, 16, seedValue + 1);
+
+                std::vector <uint256 const*> keys;
+                for (auto const& object : missing)
+                    keys.push_back (&object->getHash ());
+
+                Batch objects;
+                expect (backend->fetchBatch (keys, objects) == ok, "Should be ok");
+                expect (objects.size () == keys.size (), "Should be the same size");
+                expect (std::all_of (objects.begin (), objects.end (),
+                    [](NodeObject::Ptr const& object) { return object == nullptr; }),
+                        "Should be null");
+            }
         }
 
         {
@@ -105,6 +131,10 @@ public:
     #if RIPPLE_ROCKSDB_AVAILABLE
         testBackend ("rocksdb", seedValue);
     #endif
+
+    #if RIPPLE_APPENDDB_AVAILABLE
+        testBackend ("appenddb", seedValue);
+    #endif
     }
 };
 
@@ -70,6 +70,68 @@ public:
         }
     }
 
+    // Checks the compact encoding of inner nodes, and decoding of
+    // inner nodes stored verbatim by older versions.
+    void testInnerNodeBlobs (std::int64_t const seedValue)
+    {
+        testcase ("inner node encoding");
+
+        beast::Random r (seedValue);
+
+        for (int i = 0; i <= innerNodeBranches; ++i)
+        {
+            // Inner node in prefix format with i non-empty branches
+            Blob data (innerNodeBytes, 0);
+            std::uint32_t const prefix = HashPrefix::innerNode;
+            data [0] = static_cast <unsigned char> (prefix >> 24);
+            data [1] = static_cast <unsigned char> (prefix >> 16);
+            data [2] = static_cast <unsigned char> (prefix >> 8);
+            data [3] = static_cast <unsigned char> (prefix);
+
+            for (int branch = 0; branch < i; ++branch)
+            {
+                int const pos = (branch * 7) % innerNodeBranches;
+                r.fillBitsRandomly (
+                    &data [4 + pos * innerNodeHashBytes], innerNodeHashBytes);
+            }
+
+            uint256 hash;
+            r.fillBitsRandomly (hash.begin (), hash.size ());
+
+            NodeObject::Ptr const object (NodeObject::createObject (
+                hotACCOUNT_NODE, 1 + i, Blob (data), hash));
+
+            EncodedBlob encoded;
+            encoded.prepare (object);
+
+            std::size_t const encodedBytes = (i < innerNodeBranches)
+                ? (blobHeaderBytes + 2 + i * innerNodeHashBytes)
+                : (blobHeaderBytes + innerNodeBytes);
+
+            expect (encoded.getSize () == encodedBytes, "Wrong encoded size");
+
+            DecodedBlob decoded (encoded.getKey (), encoded.getData (), encoded.getSize ());
+
+            expect (decoded.wasOk (), "Should be ok");
+
+            if (decoded.wasOk ())
+                expect (object->isCloneOf (decoded.createObject ()), "Should be clones");
+
+            // The verbatim format written before the compact encoding
+            Blob raw (blobHeaderBytes);
+            raw [3] = raw [7] = static_cast <unsigned char> (1 + i);
+            raw [8] = hotACCOUNT_NODE;
+            raw.insert (raw.end (), data.begin (), data.end ());
+
+            DecodedBlob legacy (hash.begin (), raw.data (), raw.size ());
+
+            expect (legacy.wasOk (), "Should be ok");
+
+            if (legacy.wasOk ())
+                expect (object->isCloneOf (legacy.createObject ()), "Should be clones");
+        }
+    }
+
     void run ()
     {
         std::int64_t const seedValue = 50;
@@ -77,6 +139,8 @@ public:
         testBatches (seedValue);
 
         testBlobs (seedValue);
+
+        testInnerNodeBlobs (seedValue);
     }
 };
 
@@ -138,6 +138,13 @@ public:
                 fetchCopyOfBatch (*db, &copy, batch);
                 expect (areBatchesEqual (batch, copy), "Should be equal");
             }
+
+            {
+                // Read it back in with one batched fetch
+                Batch copy;
+                fetchBatchCopyOfBatch (*db, &copy, batch);
+                expect (areBatchesEqual (batch, copy), "Should be equal");
+            }
         }
 
         if (testPersistence)
@@ -157,6 +164,20 @@ public:
                 expect (areBatchesEqual (batch, copy), "Should be equal");
             }
 
+            {
+                // Re-open the database and read it back in with one
+                // batched fetch, which has to go to the backend
+                std::unique_ptr <Database> db (manager->make_Database (
+                    "test", scheduler, j, 2, nodeParams));
+
+                Batch copy;
+                fetchBatchCopyOfBatch (*db, &copy, batch);
+
+                std::sort (batch.begin (), batch.end (), NodeObject::LessThan ());
+                std::sort (copy.begin (), copy.end (), NodeObject::LessThan ());
+                expect (areBatchesEqual (batch, copy), "Should be equal");
+            }
+
             if (useEphemeralDatabase)
             {
                 // Verify the ephemeral db
@@ -189,6 +210,10 @@ public:
         testNodeStore ("rocksdb", useEphemeralDatabase, true, seedValue);
     #endif
 
+    #if RIPPLE_APPENDDB_AVAILABLE
+        testNodeStore ("appenddb", useEphemeralDatabase, true, seedValue);
+    #endif
+
     #if RIPPLE_ENABLE_SQLITE_BACKEND_TESTS
         testNodeStore ("sqlite", useEphemeralDatabase, true, seedValue);
     #endif
@@ -208,6 +233,10 @@ public:
         testImport ("hyperleveldb", "hyperleveldb", seedValue);
     #endif
 
+    #if RIPPLE_APPENDDB_AVAILABLE
+        testImport ("appenddb", "appenddb", seedValue);
+    #endif
+
     #if RIPPLE_ENABLE_SQLITE_BACKEND_TESTS
         testImport ("sqlite", "sqlite", seedValue);
     #endif
@@ -152,6 +152,33 @@ public:
         }
     }
 
+    // Get a copy of a batch in a backend with a single batched fetch
+    void fetchBatchCopyOfBatch (Backend& backend, Batch* pCopy, Batch const& batch)
+    {
+        std::vector <uint256 const*> keys;
+        keys.reserve (batch.size ());
+
+        for (auto const& object : batch)
+            keys.push_back (&object->getHash ());
+
+        Batch objects;
+        Status const status = backend.fetchBatch (keys, objects);
+
+        expect (status == ok, "Should be ok");
+        expect (objects.size () == batch.size (), "Should be the same size");
+
+        pCopy->clear ();
+        pCopy->reserve (objects.size ());
+
+        for (auto const& object : objects)
+        {
+            expect (object != nullptr, "Should not be null");
+
+            if (object != nullptr)
+                pCopy->push_back (object);
+        }
+    }
+
     // Store all objects in a batch
     static void storeBatch (Database& db, Batch const& batch)
     {
@@ -184,6 +211,27 @@ public:
                 pCopy->push_back (object);
         }
     }
+
+    // Fetch all the hashes with a single batched fetch, into another batch.
+    static void fetchBatchCopyOfBatch (Database& db,
+                                       Batch* pCopy,
+                                       Batch const& batch)
+    {
+        std::vector <uint256> hashes;
+        hashes.reserve (batch.size ());
+
+        for (auto const& object : batch)
+            hashes.push_back (object->getHash ());
+
+        pCopy->clear ();
+        pCopy->reserve (batch.size ());
+
+        for (auto const& object : db.fetchBatch (hashes))
+        {
+            if (object != nullptr)
+                pCopy->push_back (object);
+        }
+    }
 };
 
 }
@@ -480,12 +480,36 @@ PeerImp::on_read_protocol (error_code ec, std::size_t bytes_transferred)
         return;
     }
 
+    // Read the rest of a large message straight into its body
+    auto const body (message_stream_.body_buffer());
+    if (boost::asio::buffer_size (body) >= Tuning::readBufferBytes)
+    {
+        m_socket->async_read_some (body,
+            m_strand.wrap (std::bind (&PeerImp::on_read_body,
+                shared_from_this(), beast::asio::placeholders::error,
+                    beast::asio::placeholders::bytes_transferred)));
+        return;
+    }
+
     m_socket->async_read_some (read_buffer_.prepare (Tuning::readBufferBytes),
         m_strand.wrap (std::bind (&PeerImp::on_read_protocol,
             shared_from_this(), beast::asio::placeholders::error,
                 beast::asio::placeholders::bytes_transferred)));
 }
 
+// Called with data read directly into a partially received message body
+void
+PeerImp::on_read_body (error_code ec, std::size_t bytes_transferred)
+{
+    if (m_detaching || ec == boost::asio::error::operation_aborted)
+        return;
+
+    if (! ec)
+        ec = message_stream_.commit_body (bytes_transferred);
+
+    on_read_protocol (ec, 0);
+}
+
 // Called repeatedly to send protcol message data
 void
 PeerImp::on_write_protocol (error_code ec, std::size_t bytes_transferred)
@@ -933,17 +957,27 @@ PeerImp::on_message (std::shared_ptr <protocol::TMTransaction> const& m)
         if (m_clusterNode)
             flags |= SF_TRUSTED | SF_SIGGOOD;
 
-        if (getApp().getJobQueue().getJobCount(jtTRANSACTION) > 100)
+        if (getApp().getJobQueue().getJobCount(jtTRANSACTION) +
+                getApp().getSignatureVerifier().size() > 100)
             m_journal.info << "Transaction queue is full";
         else if (getApp().getLedgerMaster().getValidatedLedgerAge() > 240)
             m_journal.trace << "No new transactions until synchronized";
-        else
+        else if (flags & SF_SIGGOOD)
             getApp().getJobQueue ().addJob (jtTRANSACTION,
                 "recvTransaction->checkTransaction",
                 std::bind (
                     &PeerImp::checkTransaction, std::placeholders::_1,
                     flags, stx,
                     std::weak_ptr<Peer> (shared_from_this ())));
+        else
+            getApp().getSignatureVerifier ().verify (txID,
+                [stx] ()
+                {
+                    return passesLocalChecks (*stx) && stx->checkSign ();
+                },
+                std::bind (&PeerImp::onTransactionVerified,
+                    std::placeholders::_1, flags, stx,
+                    std::weak_ptr<Peer> (shared_from_this ())));
 
     }
     catch (...)
@@ -1238,13 +1272,27 @@ PeerImp::on_message (std::shared_ptr <protocol::TMValidation> const& m)
         bool isTrusted = getApp().getUNL ().nodeInUNL (val->getSignerPublic ());
         if (isTrusted || !getApp().getFeeTrack ().isLoadedLocal ())
         {
-            getApp().getJobQueue ().addJob (
-                isTrusted ? jtVALIDATION_t : jtVALIDATION_ut,
-                "recvValidation->checkValidation",
-                std::bind (
-                    &PeerImp::checkValidation, std::placeholders::_1,
-                    &m_overlay, val, isTrusted, m_clusterNode, m,
-                    std::weak_ptr<Peer> (shared_from_this ())));
+            if (m_clusterNode)
+            {
+                getApp().getJobQueue ().addJob (
+                    isTrusted ? jtVALIDATION_t : jtVALIDATION_ut,
+                    "recvValidation->checkValidation",
+                    std::bind (
+                        &PeerImp::checkValidation, std::placeholders::_1,
+                        &m_overlay, val, isTrusted, true, m,
+                        std::weak_ptr<Peer> (shared_from_this ())));
+            }
+            else
+            {
+                getApp().getSignatureVerifier ().verify (s.getSHA512Half (),
+                    [val] ()
+                    {
+                        return val->isValid (val->getSigningHash ());
+                    },
+                    std::bind (&PeerImp::onValidationVerified,
+                        std::placeholders::_1, &m_overlay, val, isTrusted, m,
+                        std::weak_ptr<Peer> (shared_from_this ())));
+            }
         }
         else
         {
@@ -1329,6 +1377,10 @@ PeerImp::on_message (std::shared_ptr <protocol::TMGetObjectByHash> const& m)
         bool pLDo = true;
         bool progress = false;
 
+        // Fetch pack entries are checked against their hashes together
+        std::vector <uint256> hashes;
+        std::vector <const_byte_view> objects;
+
         for (int i = 0; i < packet.objects_size (); ++i)
         {
             const protocol::TMIndexedObject& obj = packet.objects (i);
@@ -1357,16 +1409,33 @@ PeerImp::on_message (std::shared_ptr <protocol::TMGetObjectByHash> const& m)
                 {
                     uint256 hash;
                     memcpy (hash.begin (), obj.hash ().data (), 256 / 8);
+                    hashes.push_back (hash);
 
-                    std::shared_ptr< Blob > data (
-                        std::make_shared< Blob > (
-                            obj.data ().begin (), obj.data ().end ()));
-
-                    getApp().getOPs ().addFetchPack (hash, data);
+                    auto const data = reinterpret_cast <std::uint8_t const*> (
+                        obj.data ().data ());
+                    objects.emplace_back (data, data + obj.data ().size ());
                 }
             }
         }
 
+        std::vector <uint256> computed (objects.size ());
+        sha512HalfBatch (objects.data (), computed.data (), objects.size ());
+
+        for (std::size_t i = 0; i < objects.size (); ++i)
+        {
+            if (computed[i] != hashes[i])
+            {
+                m_journal.warning << "Bad entry in fetch pack";
+                continue;
+            }
+
+            std::shared_ptr< Blob > data (
+                std::make_shared< Blob > (
+                    objects[i].begin (), objects[i].end ()));
+
+            getApp().getOPs ().addFetchPack (hashes[i], data);
+        }
+
         if ((pLDo && (pLSeq != 0)) &&
             m_journal.active(beast::Journal::Severity::kDebug))
             m_journal.debug << "Received partial fetch pack for " << pLSeq;
@@ -41,7 +41,9 @@
 #include <beast/asio/placeholders.h>
 #include <beast/http/basic_message.h>
 
+#include <atomic>
 #include <cstdint>
+#include <deque>
 
 namespace ripple {
 
@@ -151,8 +153,19 @@ public:
     boost::asio::deadline_timer         timer_;
 
     std::vector<uint8_t>                m_readBuffer;
-    std::list<Message::pointer>   mSendQ;
-    Message::pointer              mSendingPacket;
+
+    // Messages waiting to be written, and the ones being written now.
+    // Several small messages are copied into mSendBuffer and written
+    // together, so they go out in as few TLS records as possible.
+    std::deque<Message::pointer>        mSendQ;
+    std::vector<Message::pointer>       mSending;
+    std::size_t                         mSendingBytes;
+    std::vector<std::uint8_t>           mSendBuffer;
+
+    // Queued and in flight, for json (). Only changed on the strand.
+    std::atomic<std::size_t>            mSendQueueCount;
+    std::atomic<std::size_t>            mSendQueueBytes;
+
     protocol::TMStatusChange            mLastStatus;
     protocol::TMHello                   mHello;
 
@@ -205,6 +218,9 @@ public:
             , m_minLedger (0)
             , m_maxLedger (0)
             , timer_ (m_owned_socket.get_io_service())
+            , mSendingBytes (0)
+            , mSendQueueCount (0)
+            , mSendQueueBytes (0)
             , m_slot (slot)
             , m_was_canceled (false)
             , message_stream_(*this)
@@ -244,6 +260,9 @@ public:
             , m_minLedger (0)
             , m_maxLedger (0)
             , timer_ (io_service)
+            , mSendingBytes (0)
+            , mSendQueueCount (0)
+            , mSendQueueBytes (0)
             , m_slot (slot)
             , m_was_canceled (false)
             , message_stream_(*this)
@@ -324,6 +343,9 @@ private:
     void
     on_read_protocol (error_code ec, std::size_t bytes_transferred);
 
+    void
+    on_read_body (error_code ec, std::size_t bytes_transferred);
+
     void
     on_write_protocol (error_code ec, std::size_t bytes_transferred);
 
@@ -423,6 +445,8 @@ public:
                                      " detached: " << rsn;
 
             mSendQ.clear ();
+            mSendQueueCount = mSending.size ();
+            mSendQueueBytes = mSendingBytes;
 
             (void) timer_.cancel ();
 
@@ -489,10 +513,15 @@ public:
         {
             if (m_strand.running_in_this_thread())
             {
-                if (mSendingPacket)
-                    mSendQ.push_back (m);
-                else
-                    sendForce (m);
+                if (m_detaching)
+                    return;
+
+                mSendQ.push_back (m);
+                ++mSendQueueCount;
+                mSendQueueBytes += m->getBuffer ().size ();
+
+                if (mSending.empty ())
+                    sendQueued ();
             }
             else
             {
@@ -566,6 +595,12 @@ public:
         if (m_closedLedgerHash != zero)
             ret["ledger"] = to_string (m_closedLedgerHash);
 
+        if (std::size_t const count = mSendQueueCount)
+        {
+            ret["send_queue"] = static_cast<Json::UInt> (count);
+            ret["send_queue_bytes"] = static_cast<Json::UInt> (mSendQueueBytes);
+        }
+
         if (mLastStatus.has_newstatus ())
         {
             switch (mLastStatus.newstatus ())
@@ -699,7 +734,10 @@ private:
 
         // Call on IO strand
 
-        mSendingPacket.reset ();
+        mSendQueueCount -= mSending.size ();
+        mSendQueueBytes -= mSendingBytes;
+        mSending.clear ();
+        mSendingBytes = 0;
 
         if (ec == boost::asio::error::operation_aborted)
             return;
@@ -714,16 +752,7 @@ private:
             return;
         }
 
-        if (!mSendQ.empty ())
-        {
-            Message::pointer packet = mSendQ.front ();
-
-            if (packet)
-            {
-                sendForce (packet);
-                mSendQ.pop_front ();
-            }
-        }
+        sendQueued ();
     }
 
     void handleVerifyTimer (boost::system::error_code const& ec)
@@ -747,15 +776,36 @@ private:
         }
     }
 
-    void sendForce (const Message::pointer& packet)
+    void sendQueued ()
     {
         // must be on IO strand
-        if (!m_detaching)
+        if (!m_detaching && !mSendQ.empty ())
         {
-            mSendingPacket = packet;
+            // Larger messages are written on their own from their buffer
+            std::size_t const maxBatchBytes = 64 * 1024;
+
+            do
+            {
+                mSendingBytes += mSendQ.front ()->getBuffer ().size ();
+                mSending.push_back (std::move (mSendQ.front ()));
+                mSendQ.pop_front ();
+            }
+            while (!mSendQ.empty () && ((mSendingBytes +
+                mSendQ.front ()->getBuffer ().size ()) <= maxBatchBytes));
+
+            if (mSending.size () > 1)
+            {
+                mSendBuffer.clear ();
+                mSendBuffer.reserve (mSendingBytes);
+
+                for (auto const& m : mSending)
+                    mSendBuffer.insert (mSendBuffer.end (),
+                        m->getBuffer ().begin (), m->getBuffer ().end ());
+            }
 
             boost::asio::async_write (getStream (),
-                boost::asio::buffer (packet->getBuffer ()),
+                boost::asio::buffer ((mSending.size () > 1) ?
+                    mSendBuffer : mSending.front ()->getBuffer ()),
                 m_strand.wrap (std::bind (
                     &PeerImp::handleWrite,
                     std::static_pointer_cast <PeerImp> (shared_from_this ()),
@@ -933,10 +983,9 @@ private:
     void doFetchPack (const std::shared_ptr<protocol::TMGetObjectByHash>& packet)
     {
         // VFALCO TODO Invert this dependency using an observer and shared state object.
-        // Don't queue fetch pack jobs if we're under load or we already have
-        // some queued.
-        if (getApp().getFeeTrack ().isLoadedLocal () ||
-            (getApp().getLedgerMaster().getValidatedLedgerAge() > 40) ||
+        // Don't queue fetch pack jobs if we're out of sync or we already have
+        // some queued. Under local load the pack is made smaller instead.
+        if ((getApp().getLedgerMaster().getValidatedLedgerAge() > 40) ||
             (getApp().getJobQueue().getJobCount(jtPACK) > 10))
         {
             m_journal.info << "Too busy to make fetch pack";
@@ -988,6 +1037,23 @@ private:
         }
     }
 
+    // Called from the SignatureVerifier
+    static void onTransactionVerified (bool sigGood, int flags,
+        SerializedTransaction::pointer stx, std::weak_ptr<Peer> peer)
+    {
+        if (! sigGood)
+        {
+            charge (peer, Resource::feeInvalidSignature);
+            return;
+        }
+
+        getApp().getJobQueue ().addJob (jtTRANSACTION,
+            "recvTransaction->checkTransaction",
+            std::bind (
+                &PeerImp::checkTransaction, std::placeholders::_1,
+                flags | SF_SIGGOOD, stx, peer));
+    }
+
     static void checkTransaction (Job&, int flags, SerializedTransaction::pointer stx, std::weak_ptr<Peer> peer)
     {
         try
@@ -1097,13 +1163,33 @@ private:
         }
     }
 
-    static void checkValidation (Job&, Overlay* pPeers, SerializedValidation::pointer val, bool isTrusted, bool isCluster,
+    // Called from the SignatureVerifier
+    static void onValidationVerified (bool sigGood, Overlay* pPeers,
+        SerializedValidation::pointer val, bool isTrusted,
+        std::shared_ptr<protocol::TMValidation> packet, std::weak_ptr<Peer> peer)
+    {
+        if (! sigGood)
+        {
+            WriteLog(lsWARNING, Peer) << "Validation is invalid";
+            charge (peer, Resource::feeInvalidRequest);
+            return;
+        }
+
+        getApp().getJobQueue ().addJob (
+            isTrusted ? jtVALIDATION_t : jtVALIDATION_ut,
+            "recvValidation->checkValidation",
+            std::bind (
+                &PeerImp::checkValidation, std::placeholders::_1,
+                pPeers, val, isTrusted, true, packet, peer));
+    }
+
+    static void checkValidation (Job&, Overlay* pPeers, SerializedValidation::pointer val, bool isTrusted, bool sigGood,
                                  std::shared_ptr<protocol::TMValidation> packet, std::weak_ptr<Peer> peer)
     {
         try
         {
             uint256 signingHash = val->getSigningHash();
-            if (!isCluster && !val->isValid (signingHash))
+            if (!sigGood && !val->isValid (signingHash))
             {
                 WriteLog(lsWARNING, Peer) << "Validation is invalid";
                 charge (peer, Resource::feeInvalidRequest);
@@ -29,6 +29,9 @@ enum
 {
     /** Size of buffer used to read from the socket. */
     readBufferBytes     = 4096
+
+    /** Largest message whose decoded object is kept for reuse. */
+    ,maxReusedMessageBytes = 256 * 1024
 };
 
 } // Tuning
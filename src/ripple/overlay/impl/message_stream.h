@@ -21,6 +21,7 @@
 #define RIPPLE_OVERLAY_MESSAGE_STREAM_H_INCLUDED
 
 #include <ripple/overlay/impl/abstract_protocol_handler.h>
+#include <ripple/overlay/impl/Tuning.h>
 #include <ripple/overlay/Message.h>
 #include <boost/asio/buffer.hpp>
 #include <boost/system/error_code.hpp>
@@ -31,7 +32,15 @@
 
 namespace ripple {
 
-/** Turns a stream of bytes into protocol messages and invokes the handler. */
+/** Turns a stream of bytes into protocol messages and invokes the handler.
+
+    Bodies which arrive whole in the pushed buffer are parsed in place.
+    Larger bodies are assembled in a buffer which the caller may read
+    into directly, see body_buffer(). The objects for the message types
+    which carry many nodes are reused from one message to the next when
+    no handler kept a reference, so their nested objects and strings are
+    allocated once instead of once per message.
+*/
 class message_stream
 {
 private:
@@ -43,6 +52,10 @@ private:
     std::vector <std::uint8_t> header_; // VFALCO TODO Use std::array
     std::vector <std::uint8_t> body_;
 
+    // Reused message objects
+    std::shared_ptr <protocol::TMLedgerData> ledger_data_;
+    std::shared_ptr <protocol::TMGetObjectByHash> get_objects_;
+
     static
     boost::system::error_code
     parse_error()
@@ -53,11 +66,10 @@ private:
 
     template <class Message>
     boost::system::error_code
-    invoke()
+    invoke (std::shared_ptr <Message> const& m, void const* data)
     {
         boost::system::error_code ec;
-        std::shared_ptr <Message> m (std::make_shared <Message>());
-        bool const parsed (m->ParseFromArray (body_.data(), length_));
+        bool const parsed (m->ParseFromArray (data, length_));
         if (! parsed)
             return parse_error();
         ec = handler_.on_message_begin (type_, m);
@@ -69,6 +81,62 @@ private:
         return ec;
     }
 
+    template <class Message>
+    boost::system::error_code
+    invoke (void const* data)
+    {
+        return invoke (std::make_shared <Message>(), data);
+    }
+
+    template <class Message>
+    boost::system::error_code
+    invoke (void const* data, std::shared_ptr <Message>& cache)
+    {
+        // Parsing clears the message but keeps its nested objects
+        std::shared_ptr <Message> m;
+        if (cache && cache.unique())
+            m.swap (cache);
+        else
+            m = std::make_shared <Message>();
+        boost::system::error_code const ec (invoke (m, data));
+        if (length_ <= Tuning::maxReusedMessageBytes)
+            cache = m;
+        else
+            cache.reset();
+        return ec;
+    }
+
+    /** Dispatch the current message, whose body is at data. */
+    boost::system::error_code
+    dispatch (void const* data)
+    {
+        boost::system::error_code ec;
+        switch (type_)
+        {
+        case protocol::mtHELLO:           ec = invoke <protocol::TMHello> (data); break;
+        case protocol::mtPING:            ec = invoke <protocol::TMPing> (data); break;
+        case protocol::mtPROOFOFWORK:     ec = invoke <protocol::TMProofWork> (data); break;
+        case protocol::mtCLUSTER:         ec = invoke <protocol::TMCluster> (data); break;
+        case protocol::mtGET_PEERS:       ec = invoke <protocol::TMGetPeers> (data); break;
+        case protocol::mtPEERS:           ec = invoke <protocol::TMPeers> (data); break;
+        case protocol::mtENDPOINTS:       ec = invoke <protocol::TMEndpoints> (data); break;
+        case protocol::mtTRANSACTION:     ec = invoke <protocol::TMTransaction> (data); break;
+        case protocol::mtGET_LEDGER:      ec = invoke <protocol::TMGetLedger> (data); break;
+        case protocol::mtLEDGER_DATA:     ec = invoke (data, ledger_data_); break;
+        case protocol::mtPROPOSE_LEDGER:  ec = invoke <protocol::TMProposeSet> (data); break;
+        case protocol::mtSTATUS_CHANGE:   ec = invoke <protocol::TMStatusChange> (data); break;
+        case protocol::mtHAVE_SET:        ec = invoke <protocol::TMHaveTransactionSet> (data); break;
+        case protocol::mtVALIDATION:      ec = invoke <protocol::TMValidation> (data); break;
+        case protocol::mtGET_OBJECTS:     ec = invoke (data, get_objects_); break;
+        default:
+            ec = handler_.on_message_unknown(type_);
+            break;
+        }
+        header_bytes_ = 0;
+        body_bytes_ = 0;
+        return ec;
+    }
+
 public:
     message_stream (abstract_protocol_handler& handler)
         : handler_(handler)
@@ -90,7 +158,7 @@ public:
         boost::system::error_code ec;
         const_buffer buffer (cb);
         std::size_t remain (buffer_size(buffer));
-        while (remain)
+        while (remain && ! ec)
         {
             if (header_bytes_ < header_.size())
             {
@@ -104,6 +172,14 @@ public:
                     assert (header_bytes_ == header_.size());
                     length_ = Message::getLength (header_);
                     type_ = Message::getType (header_);
+                    if (remain >= length_)
+                    {
+                        // The whole body is here, no need to copy it
+                        ec = dispatch (buffer_cast <void const*> (buffer));
+                        buffer = buffer + length_;
+                        remain = remain - length_;
+                        continue;
+                    }
                     body_.resize (length_);
                 }
             }
@@ -112,41 +188,41 @@ public:
             {
                 std::size_t const n (buffer_copy (mutable_buffer (body_.data() +
                     body_bytes_, body_.size() - body_bytes_), buffer));
-                body_bytes_ += n;
                 buffer = buffer + n;
                 remain = remain - n;
-                if (body_bytes_ >= length_)
-                {
-                    assert (body_bytes_ == length_);
-                    switch (type_)
-                    {
-                    case protocol::mtHELLO:           ec = invoke <protocol::TMHello> (); break;
-                    case protocol::mtPING:            ec = invoke <protocol::TMPing> (); break;
-                    case protocol::mtPROOFOFWORK:     ec = invoke <protocol::TMProofWork> (); break;
-                    case protocol::mtCLUSTER:         ec = invoke <protocol::TMCluster> (); break;
-                    case protocol::mtGET_PEERS:       ec = invoke <protocol::TMGetPeers> (); break;
-                    case protocol::mtPEERS:           ec = invoke <protocol::TMPeers> (); break;
-                    case protocol::mtENDPOINTS:       ec = invoke <protocol::TMEndpoints> (); break;
-                    case protocol::mtTRANSACTION:     ec = invoke <protocol::TMTransaction> (); break;
-                    case protocol::mtGET_LEDGER:      ec = invoke <protocol::TMGetLedger> (); break;
-                    case protocol::mtLEDGER_DATA:     ec = invoke <protocol::TMLedgerData> (); break;
-                    case protocol::mtPROPOSE_LEDGER:  ec = invoke <protocol::TMProposeSet> (); break;
-                    case protocol::mtSTATUS_CHANGE:   ec = invoke <protocol::TMStatusChange> (); break;
-                    case protocol::mtHAVE_SET:        ec = invoke <protocol::TMHaveTransactionSet> (); break;
-                    case protocol::mtVALIDATION:      ec = invoke <protocol::TMValidation> (); break;
-                    case protocol::mtGET_OBJECTS:     ec = invoke <protocol::TMGetObjectByHash> (); break;
-                    default:
-                        ec = handler_.on_message_unknown(type_);
-                        break;
-                    }
-                    header_bytes_ = 0;
-                    body_bytes_ = 0;
-                }
+                ec = commit_body (n);
             }
         }
         return ec;
     }
 
+    /** Returns the part of the current message body not yet received.
+        The buffer is empty unless a message body is partially received.
+        The caller may read from the stream directly into it, rather than
+        pushing the data through write_one, and then call commit_body.
+    */
+    boost::asio::mutable_buffers_1
+    body_buffer()
+    {
+        if (header_bytes_ < header_.size())
+            return boost::asio::mutable_buffers_1 (nullptr, 0);
+        return boost::asio::mutable_buffers_1 (body_.data() + body_bytes_,
+            body_.size() - body_bytes_);
+    }
+
+    /** Record bytes placed in the buffer returned by body_buffer.
+        The handler is called if this completes the message.
+    */
+    boost::system::error_code
+    commit_body (std::size_t n)
+    {
+        assert (body_bytes_ + n <= length_);
+        body_bytes_ += n;
+        if (body_bytes_ < length_)
+            return boost::system::error_code();
+        return dispatch (body_.data());
+    }
+
     /** Push a set of buffers through.
         The handler is called for each complete protocol message contained
         in the buffers.
@@ -26,6 +26,8 @@
 
 #include <ripple/radmap/api/Tuning.h>
 
+#include <vector>
+
 namespace ripple {
 namespace RadMap {
 
@@ -107,6 +109,15 @@ public:
         m_cache.insert (key);
     }
 
+    /** Return a copy of the keys in the cache.
+        Thread safety:
+            Safe to call from any thread.
+    */
+    std::vector <key_type> getKeys () const
+    {
+        return m_cache.getKeys ();
+    }
+
 private:
     KeyCache <Key> m_cache;
 };
@@ -17,11 +17,51 @@
 */
 //==============================================================================
 
+#include <ripple/radmap/api/BasicFullBelowCache.h>
+
+#include <beast/unit_test/suite.h>
+#include <beast/chrono/manual_clock.h>
+
+#include <algorithm>
+
 namespace ripple {
 namespace RadMap {
 
-// Unit test to go here if the class becomes
-// a non-trivial wrapper for KeyCache.
+class BasicFullBelowCache_test : public beast::unit_test::suite
+{
+public:
+    void run ()
+    {
+        beast::manual_clock <std::chrono::seconds> clock;
+        clock.set (0);
+
+        typedef std::string Key;
+        typedef BasicFullBelowCache <Key> Cache;
+
+        Cache c ("test", clock, beast::insight::NullCollector::New (), 0, 2);
+
+        c.insert ("one");
+        c.insert ("two");
+        expect (c.touch_if_exists ("one"));
+        expect (! c.touch_if_exists ("three"));
+
+        // The keys are what gets saved across restarts
+        std::vector <Key> keys (c.getKeys ());
+        std::sort (keys.begin (), keys.end ());
+        expect (keys.size () == 2 && keys [0] == "one" && keys [1] == "two");
+
+        clock.set (2);
+        expect (c.touch_if_exists ("one"));
+
+        // Only the key that was used survives the sweep
+        clock.set (3);
+        c.sweep ();
+        expect (c.size () == 1);
+        expect (c.getKeys () == std::vector <Key> (1, "one"));
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(BasicFullBelowCache,radmap,ripple);
 
 }
 }
@@ -58,6 +58,7 @@
 
 #include <ripple/common/KeyCache.h>
 #include <ripple/common/TaggedCache.h>
+#include <ripple/common/ShardedTaggedCache.h>
 
 #include <ripple/module/app/data/Database.h>
 #include <ripple/module/app/data/DatabaseCon.h>
@@ -83,10 +84,12 @@
 #include <ripple/module/app/misc/AmendmentTable.h>
 #include <ripple/module/app/misc/FeeVote.h>
 #include <ripple/module/app/misc/IHashRouter.h>
+#include <ripple/module/app/misc/SignatureVerifier.h>
 #include <ripple/module/app/peers/ClusterNodeStatus.h>
 #include <ripple/module/app/peers/UniqueNodeList.h>
 #include <ripple/module/app/misc/Validations.h>
 #include <ripple/module/app/peers/PeerSet.h>
+#include <ripple/module/app/ledger/LedgerFetchPipeline.h>
 #include <ripple/module/app/ledger/InboundLedger.h>
 #include <ripple/module/app/ledger/InboundLedgers.h>
 #include <ripple/module/app/ledger/AcceptedLedgerTx.h>
@@ -97,6 +100,7 @@
 #include <ripple/module/app/tx/TransactionEngine.h>
 #include <ripple/module/app/misc/CanonicalTXSet.h>
 #include <ripple/module/app/ledger/LedgerHolder.h>
+#include <ripple/module/app/ledger/LedgerHashIndex.h>
 #include <ripple/module/app/ledger/LedgerHistory.h>
 #include <ripple/module/app/ledger/LedgerCleaner.h>
 #include <ripple/module/app/ledger/LedgerMaster.h>
@@ -31,6 +31,7 @@
 
 #include <ripple/module/app/paths/RippleState.cpp>
 #include <ripple/module/app/peers/UniqueNodeList.cpp>
+#include <ripple/module/app/ledger/LedgerFetchPipeline.cpp>
 #include <ripple/module/app/ledger/InboundLedger.cpp>
 #include <ripple/module/app/tx/TransactionCheck.cpp>
 #include <ripple/module/app/tx/TransactionMaster.cpp>
@@ -29,5 +29,6 @@
 #include <ripple/module/app/ledger/OrderBookIterator.cpp>
 #include <ripple/module/app/consensus/DisputedTx.cpp>
 #include <ripple/module/app/misc/HashRouter.cpp>
+#include <ripple/module/app/misc/SignatureVerifier.cpp>
 #include <ripple/module/app/paths/Pathfinder.cpp>
 #include <ripple/module/app/misc/AmendmentTableImpl.cpp>
@@ -26,6 +26,7 @@
 #include <ripple/common/seconds_clock.h>
 
 #include <ripple/module/app/ledger/InboundLedgers.cpp>
+#include <ripple/module/app/ledger/LedgerHashIndex.cpp>
 #include <ripple/module/app/ledger/LedgerHistory.cpp>
 #include <ripple/module/app/misc/SerializedLedger.cpp>
 #include <ripple/module/app/tx/TransactionAcquire.cpp>
@@ -65,6 +65,7 @@
 #include <ripple/module/data/crypto/CKeyECIES.cpp>
 #include <ripple/module/data/crypto/Base58Data.cpp>
 #include <ripple/module/data/crypto/RFC1751.cpp>
+#include <ripple/module/data/crypto/SHA512Batch.cpp>
 
 #include <ripple/module/data/protocol/BuildInfo.cpp>
 #include <ripple/module/data/protocol/SField.cpp>
@@ -76,6 +77,7 @@
 #include <ripple/module/data/protocol/Serializer.cpp>
 #include <ripple/module/data/protocol/SerializedObjectTemplate.cpp>
 #include <ripple/module/data/protocol/SerializedObject.cpp>
+#include <ripple/module/data/protocol/STVar.cpp>
 #include <ripple/module/data/protocol/TER.cpp>
 #include <ripple/module/data/protocol/TxFormats.cpp>
 
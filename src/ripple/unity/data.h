@@ -29,6 +29,7 @@ typedef struct bignum_st BIGNUM;
 
 #include <ripple/module/data/crypto/Base58Data.h>
 #include <ripple/module/data/crypto/RFC1751.h>
+#include <ripple/module/data/crypto/SHA512Batch.h>
 #include <ripple/module/data/protocol/BuildInfo.h>
 #include <ripple/module/data/protocol/SField.h>
 #include <ripple/module/data/protocol/HashPrefix.h>
@@ -42,6 +43,7 @@ typedef struct bignum_st BIGNUM;
  #include <ripple/module/data/protocol/KnownFormats.h>
  #include <ripple/module/data/protocol/LedgerFormats.h> // needs SOTemplate from SerializedObjectTemplate
  #include <ripple/module/data/protocol/TxFormats.h>
+#include <ripple/module/data/protocol/STVar.h>
 #include <ripple/module/data/protocol/SerializedObject.h>
 #include <ripple/module/data/protocol/TxFlags.h>
 
@@ -17,6 +17,7 @@
 */
 //==============================================================================
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -29,12 +30,16 @@
 
 #include <ripple/common/seconds_clock.h>
 #include <ripple/common/TaggedCache.h>
+#include <ripple/common/ShardedTaggedCache.h>
 #include <ripple/common/KeyCache.h>
 
 #include <ripple/nodestore/impl/Tuning.h>
+#include <ripple/nodestore/impl/BlobFormat.h>
 #include <ripple/nodestore/impl/DecodedBlob.h>
 #include <ripple/nodestore/impl/EncodedBlob.h>
 #include <ripple/nodestore/impl/BatchWriter.h>
+#include <ripple/nodestore/backend/AppendDBFactory.h>
+#include <ripple/nodestore/backend/AppendDBFactory.cpp>
 #include <ripple/nodestore/backend/HyperDBFactory.h>
 #include <ripple/nodestore/backend/HyperDBFactory.cpp>
 #include <ripple/nodestore/backend/LevelDBFactory.h>
@@ -60,6 +65,7 @@
 #include <ripple/nodestore/impl/Task.cpp>
 
 #include <ripple/nodestore/tests/TestBase.h>
+#include <ripple/nodestore/tests/AppendDBTests.cpp>
 #include <ripple/nodestore/tests/BackendTests.cpp>
 #include <ripple/nodestore/tests/BasicTests.cpp>
 #include <ripple/nodestore/tests/DatabaseTests.cpp>